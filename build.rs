@@ -23,8 +23,38 @@ fn main() {
     println!("cargo:rustc-link-search=C:/Qt/6.10.0/mingw_64/lib");
     println!("cargo:rustc-link-search=C:/Qt/6.10.0/mingw_64/bin");
     
+    println!("cargo:rerun-if-changed=src/ui/autosave.h");
+    println!("cargo:rerun-if-changed=src/ui/autosave.cpp");
+    println!("cargo:rerun-if-changed=src/ui/book_scroll_view.h");
+    println!("cargo:rerun-if-changed=src/ui/book_scroll_view.cpp");
+    println!("cargo:rerun-if-changed=src/ui/checkbox_object.h");
+    println!("cargo:rerun-if-changed=src/ui/checkbox_object.cpp");
+    println!("cargo:rerun-if-changed=src/ui/command_queue.h");
+    println!("cargo:rerun-if-changed=src/ui/command_queue.cpp");
+    println!("cargo:rerun-if-changed=src/ui/event_ring.h");
+    println!("cargo:rerun-if-changed=src/ui/event_ring.cpp");
+    println!("cargo:rerun-if-changed=src/ui/image_loader.h");
+    println!("cargo:rerun-if-changed=src/ui/image_loader.cpp");
+    println!("cargo:rerun-if-changed=src/ui/image_scaler.h");
+    println!("cargo:rerun-if-changed=src/ui/image_scaler.cpp");
     println!("cargo:rerun-if-changed=src/ui/mainwindow.h");
     println!("cargo:rerun-if-changed=src/ui/mainwindow.cpp");
+    println!("cargo:rerun-if-changed=src/ui/markdown_highlighter.h");
+    println!("cargo:rerun-if-changed=src/ui/markdown_highlighter.cpp");
+    println!("cargo:rerun-if-changed=src/ui/page_editor.h");
+    println!("cargo:rerun-if-changed=src/ui/page_editor.cpp");
+    println!("cargo:rerun-if-changed=src/ui/page_navigator.h");
+    println!("cargo:rerun-if-changed=src/ui/page_navigator.cpp");
+    println!("cargo:rerun-if-changed=src/ui/page_prefetch.h");
+    println!("cargo:rerun-if-changed=src/ui/page_prefetch.cpp");
+    println!("cargo:rerun-if-changed=src/ui/page_thumbnails.h");
+    println!("cargo:rerun-if-changed=src/ui/page_thumbnails.cpp");
+    println!("cargo:rerun-if-changed=src/ui/piece_table.h");
+    println!("cargo:rerun-if-changed=src/ui/piece_table.cpp");
     println!("cargo:rerun-if-changed=src/ui/qt_bridge.h");
     println!("cargo:rerun-if-changed=src/ui/qt_bridge.cpp");
+    println!("cargo:rerun-if-changed=src/ui/text_insert.h");
+    println!("cargo:rerun-if-changed=src/ui/text_insert.cpp");
+    println!("cargo:rerun-if-changed=src/ui/text_store.h");
+    println!("cargo:rerun-if-changed=src/ui/text_store.cpp");
 }
\ No newline at end of file
@@ -0,0 +1,309 @@
+// src/blobs.rs
+// Encrypted, content-addressed store for the original files of images and attachments
+
+use blake2::digest::consts::U32;
+use blake2::digest::{KeyInit, Mac};
+use blake2::Blake2bMac;
+use std::fs::{self, File};
+use std::io::{self, BufReader, BufWriter, Read, Write};
+use std::path::{Path, PathBuf};
+
+use crate::crypto::stream::{self, StreamError, StreamReader};
+use crate::crypto::MasterKey;
+
+type Blake2bMac256 = Blake2bMac<U32>;
+
+/// Blob error type
+#[derive(Debug)]
+pub enum BlobError {
+    InvalidKey,
+    Io(io::Error),
+    Stream(StreamError),
+}
+
+impl std::fmt::Display for BlobError {
+    fn fmt(&self, f: &mut std::fmt::Formatter) -> std::fmt::Result {
+        match self {
+            BlobError::InvalidKey => write!(f, "Invalid blob hash"),
+            BlobError::Io(e) => write!(f, "Blob file error: {}", e),
+            BlobError::Stream(e) => write!(f, "{}", e),
+        }
+    }
+}
+
+impl std::error::Error for BlobError {}
+
+impl From<io::Error> for BlobError {
+    fn from(e: io::Error) -> Self {
+        BlobError::Io(e)
+    }
+}
+
+impl From<StreamError> for BlobError {
+    fn from(e: StreamError) -> Self {
+        BlobError::Stream(e)
+    }
+}
+
+/// Keys the content hash; changing it renames every blob
+const HASH_CONTEXT: &[u8] = b"notequarry blob hash v1";
+
+/// A file as it went into the store
+#[derive(Debug, Clone)]
+pub struct StoredBlob {
+    pub hash: String,
+    pub size: u64,
+    /// False when the same content was stored before and nothing was written
+    pub written: bool,
+}
+
+/// Reader that hashes what passes through it
+struct HashingReader<R: Read> {
+    inner: R,
+    mac: Blake2bMac256,
+    size: u64,
+}
+
+impl<R: Read> Read for HashingReader<R> {
+    fn read(&mut self, buf: &mut [u8]) -> io::Result<usize> {
+        let n = self.inner.read(buf)?;
+        self.mac.update(&buf[..n]);
+        self.size += n as u64;
+        Ok(n)
+    }
+}
+
+/// Blobs live in `<dir>/<first two hex digits>/<hash>.blob`, encrypted with
+/// `crypto::stream` so neither storing nor reading holds a whole file in
+/// memory. The hash is a BLAKE2b-256 MAC of the content under a key derived
+/// from the master key: equal files share one blob, yet a name on disk or in
+/// a sync bundle does not tell which well-known file it holds.
+#[derive(Clone)]
+pub struct BlobStore {
+    dir: PathBuf,
+}
+
+impl BlobStore {
+    pub fn new(dir: PathBuf) -> Self {
+        BlobStore { dir }
+    }
+
+    /// Store kept in a `blobs` directory next to the database
+    pub fn beside(db_path: &Path) -> Self {
+        let parent = db_path.parent().unwrap_or_else(|| Path::new("."));
+        Self::new(parent.join("blobs"))
+    }
+
+    /// Lowercase hex, the only form used as a file name
+    pub fn is_valid_hash(hash: &str) -> bool {
+        hash.len() == 64 && hash.bytes().all(|b| b.is_ascii_digit() || (b'a'..=b'f').contains(&b))
+    }
+
+    fn path(&self, hash: &str) -> Result<PathBuf, BlobError> {
+        if !Self::is_valid_hash(hash) {
+            return Err(BlobError::InvalidKey);
+        }
+        Ok(self.dir.join(&hash[..2]).join(format!("{}.blob", hash)))
+    }
+
+    fn hasher(key: &MasterKey) -> Blake2bMac256 {
+        let mut derive = <Blake2bMac256 as KeyInit>::new_from_slice(key.as_slice()).expect("32-byte key");
+        derive.update(HASH_CONTEXT);
+        let hash_key = derive.finalize().into_bytes();
+        <Blake2bMac256 as KeyInit>::new_from_slice(&hash_key).expect("32-byte key")
+    }
+
+    fn hashing<R: Read>(reader: R, key: &MasterKey) -> HashingReader<R> {
+        HashingReader {
+            inner: reader,
+            mac: Self::hasher(key),
+            size: 0,
+        }
+    }
+
+    fn finish<R: Read>(reader: HashingReader<R>) -> (String, u64) {
+        (hex::encode(reader.mac.finalize().into_bytes()), reader.size)
+    }
+
+    /// Keyed hash and length of everything `reader` yields
+    pub fn hash_reader<R: Read>(reader: R, key: &MasterKey) -> Result<(String, u64), BlobError> {
+        let mut hashing = Self::hashing(reader, key);
+        io::copy(&mut hashing, &mut io::sink())?;
+        Ok(Self::finish(hashing))
+    }
+
+    pub fn contains(&self, hash: &str) -> bool {
+        self.path(hash).map(|path| path.exists()).unwrap_or(false)
+    }
+
+    /// Add a file to the store. Content already there costs one hashing
+    /// pass and no write.
+    pub fn store_file(&self, path: &Path, key: &MasterKey) -> Result<StoredBlob, BlobError> {
+        let (hash, size) = Self::hash_reader(BufReader::new(File::open(path)?), key)?;
+        if self.contains(&hash) {
+            return Ok(StoredBlob { hash, size, written: false });
+        }
+
+        self.store_reader(File::open(path)?, key)
+    }
+
+    /// Encrypt everything `reader` yields into the store
+    pub fn store_reader<R: Read>(&self, reader: R, key: &MasterKey) -> Result<StoredBlob, BlobError> {
+        fs::create_dir_all(&self.dir)?;
+
+        // The name is only known at the end, and is taken from the bytes that
+        // were actually encrypted
+        let partial = self.dir.join(format!("incoming-{}.part", std::process::id()));
+        let mut hashing = Self::hashing(BufReader::new(reader), key);
+        let result = File::create(&partial).map_err(BlobError::from).and_then(|file| {
+            let mut writer = BufWriter::new(file);
+            stream::encrypt_stream(&mut hashing, &mut writer, key, stream::DEFAULT_CHUNK_SIZE)?;
+            writer.into_inner().map_err(|e| e.into_error())?.sync_all()?;
+            Ok(())
+        });
+        if let Err(e) = result {
+            let _ = fs::remove_file(&partial);
+            return Err(e);
+        }
+
+        let (hash, size) = Self::finish(hashing);
+        let path = self.path(&hash)?;
+        if path.exists() {
+            fs::remove_file(&partial)?;
+            return Ok(StoredBlob { hash, size, written: false });
+        }
+        if let Some(parent) = path.parent() {
+            fs::create_dir_all(parent)?;
+        }
+        fs::rename(&partial, &path)?;
+        Ok(StoredBlob { hash, size, written: true })
+    }
+
+    /// Random access to a blob's chunks
+    pub fn open(&self, hash: &str, key: &MasterKey) -> Result<StreamReader<File>, BlobError> {
+        let file = File::open(self.path(hash)?)?;
+        Ok(StreamReader::open(file, key)?)
+    }
+
+    /// Decrypt a whole blob into `writer`; returns its length
+    pub fn read_to<W: Write>(&self, hash: &str, writer: &mut W, key: &MasterKey) -> Result<u64, BlobError> {
+        let mut reader = BufReader::new(File::open(self.path(hash)?)?);
+        Ok(stream::decrypt_stream(&mut reader, writer, key)?)
+    }
+
+    /// Delete a blob's file; one already gone is not an error
+    pub fn remove(&self, hash: &str) -> Result<(), BlobError> {
+        match fs::remove_file(self.path(hash)?) {
+            Err(e) if e.kind() != io::ErrorKind::NotFound => Err(e.into()),
+            _ => Ok(()),
+        }
+    }
+
+    /// Hashes of every blob file on disk, for sweeping files whose row is gone
+    pub fn stored_hashes(&self) -> Result<Vec<String>, BlobError> {
+        let mut hashes = Vec::new();
+        let shards = match fs::read_dir(&self.dir) {
+            Ok(shards) => shards,
+            Err(e) if e.kind() == io::ErrorKind::NotFound => return Ok(hashes),
+            Err(e) => return Err(e.into()),
+        };
+        for shard in shards {
+            let shard = shard?;
+            if !shard.file_type()?.is_dir() {
+                continue;
+            }
+            for file in fs::read_dir(shard.path())? {
+                let name = file?.file_name();
+                if let Some(hash) = name.to_str().and_then(|name| name.strip_suffix(".blob")) {
+                    if Self::is_valid_hash(hash) {
+                        hashes.push(hash.to_string());
+                    }
+                }
+            }
+        }
+        Ok(hashes)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::io::Cursor;
+
+    fn temp_store(name: &str) -> BlobStore {
+        let dir = std::env::temp_dir().join(format!("notequarry-blobs-{}-{}", std::process::id(), name));
+        let _ = fs::remove_dir_all(&dir);
+        BlobStore::new(dir)
+    }
+
+    fn sample(len: usize) -> Vec<u8> {
+        (0..len).map(|i| (i * 13 % 256) as u8).collect()
+    }
+
+    #[test]
+    fn test_store_dedup_and_read() {
+        let store = temp_store("dedup");
+        let key = MasterKey::from_bytes([3; 32]);
+        let data = sample(200_000);
+
+        let first = store.store_reader(Cursor::new(&data), &key).unwrap();
+        let second = store.store_reader(Cursor::new(&data), &key).unwrap();
+        assert!(first.written);
+        assert!(!second.written);
+        assert_eq!(first.hash, second.hash);
+        assert_eq!(first.size, data.len() as u64);
+        assert_eq!(store.stored_hashes().unwrap(), vec![first.hash.clone()]);
+
+        let mut out = Vec::new();
+        assert_eq!(store.read_to(&first.hash, &mut out, &key).unwrap(), data.len() as u64);
+        assert_eq!(out, data);
+
+        let mut reader = store.open(&first.hash, &key).unwrap();
+        assert_eq!(reader.plaintext_len(), data.len() as u64);
+        assert_eq!(reader.read_chunk(1).unwrap(), &data[stream::DEFAULT_CHUNK_SIZE..2 * stream::DEFAULT_CHUNK_SIZE]);
+
+        store.remove(&first.hash).unwrap();
+        store.remove(&first.hash).unwrap();
+        assert!(!store.contains(&first.hash));
+
+        let _ = fs::remove_dir_all(&store.dir);
+    }
+
+    #[test]
+    fn test_store_file_skips_known_content() {
+        let store = temp_store("file");
+        let key = MasterKey::from_bytes([4; 32]);
+        let source = store.dir.with_extension("src");
+        fs::write(&source, sample(1000)).unwrap();
+
+        let first = store.store_file(&source, &key).unwrap();
+        let second = store.store_file(&source, &key).unwrap();
+        assert!(first.written);
+        assert!(!second.written);
+        assert_eq!(first.hash, BlobStore::hash_reader(Cursor::new(sample(1000)), &key).unwrap().0);
+
+        let _ = fs::remove_file(&source);
+        let _ = fs::remove_dir_all(&store.dir);
+    }
+
+    #[test]
+    fn test_hash_is_keyed() {
+        let data = sample(100);
+        let (a, size) = BlobStore::hash_reader(Cursor::new(&data), &MasterKey::from_bytes([1; 32])).unwrap();
+        let (b, _) = BlobStore::hash_reader(Cursor::new(&data), &MasterKey::from_bytes([2; 32])).unwrap();
+
+        assert_eq!(size, 100);
+        assert!(BlobStore::is_valid_hash(&a));
+        assert_ne!(a, b);
+    }
+
+    #[test]
+    fn test_rejects_unsafe_keys() {
+        let store = temp_store("keys");
+        let key = MasterKey::from_bytes([1; 32]);
+
+        assert!(store.remove("../../etc/passwd").is_err());
+        assert!(store.open(&"A".repeat(64), &key).is_err());
+        assert!(store.stored_hashes().unwrap().is_empty());
+    }
+}
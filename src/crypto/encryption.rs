@@ -30,6 +30,11 @@ const NONCE_SIZE: usize = 12;
 /// Encrypt plaintext using ChaCha20-Poly1305
 /// Format: [nonce (12 bytes)] + [ciphertext + tag]
 pub fn encrypt(plaintext: &str, key: &MasterKey) -> Result<Vec<u8>, EncryptionError> {
+    encrypt_bytes(plaintext.as_bytes(), key)
+}
+
+/// Encrypt binary data, in the same format as `encrypt`
+pub fn encrypt_bytes(plaintext: &[u8], key: &MasterKey) -> Result<Vec<u8>, EncryptionError> {
     info!("Encrypting data...");
 
     // Create key from slice
@@ -44,7 +49,7 @@ pub fn encrypt(plaintext: &str, key: &MasterKey) -> Result<Vec<u8>, EncryptionEr
 
     // Encrypt
     let ciphertext = cipher
-        .encrypt(&nonce, plaintext.as_bytes())
+        .encrypt(&nonce, plaintext)
         .map_err(|e| EncryptionError::EncryptFailed(e.to_string()))?;
 
     // Prepend nonce
@@ -58,6 +63,15 @@ pub fn encrypt(plaintext: &str, key: &MasterKey) -> Result<Vec<u8>, EncryptionEr
 
 /// Decrypt ciphertext using ChaCha20-Poly1305
 pub fn decrypt(ciphertext: &[u8], key: &MasterKey) -> Result<String, EncryptionError> {
+    let plaintext_bytes = decrypt_bytes(ciphertext, key)?;
+
+    // Convert to string
+    String::from_utf8(plaintext_bytes)
+        .map_err(|e| EncryptionError::DecryptFailed(format!("Invalid UTF-8: {}", e)))
+}
+
+/// Decrypt binary data written by `encrypt_bytes`
+pub fn decrypt_bytes(ciphertext: &[u8], key: &MasterKey) -> Result<Vec<u8>, EncryptionError> {
     info!("Decrypting data...");
 
     if ciphertext.len() < NONCE_SIZE + 16 {
@@ -78,12 +92,8 @@ pub fn decrypt(ciphertext: &[u8], key: &MasterKey) -> Result<String, EncryptionE
         .decrypt(&nonce, encrypted_data)
         .map_err(|e| EncryptionError::DecryptFailed(e.to_string()))?;
 
-    // Convert to string
-    let plaintext = String::from_utf8(plaintext_bytes)
-        .map_err(|e| EncryptionError::DecryptFailed(format!("Invalid UTF-8: {}", e)))?;
-
-    info!("Decryption successful ({} bytes)", plaintext.len());
-    Ok(plaintext)
+    info!("Decryption successful ({} bytes)", plaintext_bytes.len());
+    Ok(plaintext_bytes)
 }
 
 #[cfg(test)]
@@ -143,6 +153,19 @@ mod tests {
         assert!(decrypt(&ciphertext, &key).is_err());
     }
 
+    #[test]
+    fn test_bytes_roundtrip() {
+        let salt = generate_salt();
+        let key = derive_key("password", &salt).unwrap();
+
+        // Not valid UTF-8
+        let data = vec![0xFF, 0x00, 0xD8, 0xFF, 0xE0];
+        let ciphertext = encrypt_bytes(&data, &key).unwrap();
+
+        assert_eq!(decrypt_bytes(&ciphertext, &key).unwrap(), data);
+        assert!(decrypt(&ciphertext, &key).is_err());
+    }
+
     #[test]
     fn test_unicode() {
         let salt = generate_salt();
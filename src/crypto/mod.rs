@@ -3,8 +3,9 @@
 pub mod encryption;
 pub mod key_derivation;
 pub mod secure_memory;
+pub mod stream;
 
 // Re-export commonly used items
-pub use encryption::{decrypt, encrypt};
+pub use encryption::{decrypt, decrypt_bytes, encrypt, encrypt_bytes};
 pub use key_derivation::{derive_key, generate_salt, MasterKey};
 //pub use secure_memory::SecureString;
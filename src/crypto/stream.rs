@@ -0,0 +1,434 @@
+// src/crypto/stream.rs
+// Chunked ChaCha20-Poly1305 for attachments too large to hold in memory
+
+use chacha20poly1305::aead::{Aead, KeyInit, OsRng, Payload};
+use chacha20poly1305::{ChaCha20Poly1305, Key, Nonce};
+use rand::RngCore;
+use std::io::{self, Read, Seek, SeekFrom, Write};
+
+use super::key_derivation::MasterKey;
+
+/// Stream error type
+#[derive(Debug)]
+pub enum StreamError {
+    Io(io::Error),
+    InvalidHeader,
+    /// The stream ends before its final chunk
+    Truncated,
+    /// A chunk failed authentication: wrong key, tampering, or chunks
+    /// reordered, dropped or appended
+    Corrupt(u64),
+    ChunkOutOfRange(u64),
+    TooLarge,
+}
+
+impl std::fmt::Display for StreamError {
+    fn fmt(&self, f: &mut std::fmt::Formatter) -> std::fmt::Result {
+        match self {
+            StreamError::Io(e) => write!(f, "Stream I/O failed: {}", e),
+            StreamError::InvalidHeader => write!(f, "Invalid stream header"),
+            StreamError::Truncated => write!(f, "Stream is truncated"),
+            StreamError::Corrupt(index) => write!(f, "Chunk {} failed authentication", index),
+            StreamError::ChunkOutOfRange(index) => write!(f, "Chunk {} is past the end of the stream", index),
+            StreamError::TooLarge => write!(f, "Stream has too many chunks"),
+        }
+    }
+}
+
+impl std::error::Error for StreamError {}
+
+impl From<io::Error> for StreamError {
+    fn from(e: io::Error) -> Self {
+        StreamError::Io(e)
+    }
+}
+
+/// Plaintext bytes per chunk unless the caller picks otherwise
+pub const DEFAULT_CHUNK_SIZE: usize = 64 * 1024;
+
+const MAGIC: &[u8; 4] = b"NQS1";
+const PREFIX_SIZE: usize = 7;
+const TAG_SIZE: usize = 16;
+const HEADER_SIZE: usize = MAGIC.len() + 4 + PREFIX_SIZE;
+const MAX_CHUNK_SIZE: usize = 16 * 1024 * 1024;
+
+/// STREAM construction (Hoang et al.): every chunk is sealed on its own
+/// under the nonce [random prefix (7 bytes)] + [chunk index (4 bytes BE)] +
+/// [1 on the final chunk, else 0], with the header as associated data.
+/// Reordering, dropping or appending chunks, cutting the stream short or
+/// changing the chunk size therefore all fail authentication.
+///
+/// Format: [magic "NQS1"] + [chunk size (4 bytes BE)] + [nonce prefix] +
+/// chunks of [ciphertext + tag]. Every chunk but the last holds exactly
+/// chunk size bytes of plaintext; the last holds the rest, possibly none.
+struct Header {
+    chunk_size: usize,
+    prefix: [u8; PREFIX_SIZE],
+}
+
+impl Header {
+    fn to_bytes(&self) -> [u8; HEADER_SIZE] {
+        let mut bytes = [0u8; HEADER_SIZE];
+        bytes[..4].copy_from_slice(MAGIC);
+        bytes[4..8].copy_from_slice(&(self.chunk_size as u32).to_be_bytes());
+        bytes[8..].copy_from_slice(&self.prefix);
+        bytes
+    }
+
+    fn read<R: Read>(reader: &mut R) -> Result<Self, StreamError> {
+        let mut bytes = [0u8; HEADER_SIZE];
+        reader.read_exact(&mut bytes).map_err(|e| match e.kind() {
+            io::ErrorKind::UnexpectedEof => StreamError::InvalidHeader,
+            _ => StreamError::Io(e),
+        })?;
+        if &bytes[..4] != MAGIC {
+            return Err(StreamError::InvalidHeader);
+        }
+
+        let chunk_size = u32::from_be_bytes([bytes[4], bytes[5], bytes[6], bytes[7]]) as usize;
+        if chunk_size == 0 || chunk_size > MAX_CHUNK_SIZE {
+            return Err(StreamError::InvalidHeader);
+        }
+
+        let mut prefix = [0u8; PREFIX_SIZE];
+        prefix.copy_from_slice(&bytes[8..]);
+        Ok(Header { chunk_size, prefix })
+    }
+
+    fn nonce(&self, index: u64, last: bool) -> Result<[u8; 12], StreamError> {
+        let counter = u32::try_from(index).map_err(|_| StreamError::TooLarge)?;
+        let mut nonce = [0u8; 12];
+        nonce[..PREFIX_SIZE].copy_from_slice(&self.prefix);
+        nonce[PREFIX_SIZE..11].copy_from_slice(&counter.to_be_bytes());
+        nonce[11] = last as u8;
+        Ok(nonce)
+    }
+}
+
+fn cipher_for(key: &MasterKey) -> ChaCha20Poly1305 {
+    ChaCha20Poly1305::new(Key::from_slice(key.as_slice()))
+}
+
+/// Fill `buf` from `reader` as far as it goes; returns the bytes read
+fn read_full<R: Read>(reader: &mut R, buf: &mut [u8]) -> io::Result<usize> {
+    let mut filled = 0;
+    while filled < buf.len() {
+        match reader.read(&mut buf[filled..]) {
+            Ok(0) => break,
+            Ok(n) => filled += n,
+            Err(e) if e.kind() == io::ErrorKind::Interrupted => {}
+            Err(e) => return Err(e),
+        }
+    }
+    Ok(filled)
+}
+
+/// Encrypt everything `reader` yields into `writer`, holding two chunks at
+/// a time. Returns the number of plaintext bytes.
+pub fn encrypt_stream<R: Read, W: Write>(
+    reader: &mut R,
+    writer: &mut W,
+    key: &MasterKey,
+    chunk_size: usize,
+) -> Result<u64, StreamError> {
+    if chunk_size == 0 || chunk_size > MAX_CHUNK_SIZE {
+        return Err(StreamError::InvalidHeader);
+    }
+
+    let mut prefix = [0u8; PREFIX_SIZE];
+    OsRng.fill_bytes(&mut prefix);
+    let header = Header { chunk_size, prefix };
+    let aad = header.to_bytes();
+    writer.write_all(&aad)?;
+
+    let cipher = cipher_for(key);
+
+    // A chunk is only known to be the last once the next read comes back
+    // empty, so one is always held back
+    let mut current = vec![0u8; chunk_size];
+    let mut next = vec![0u8; chunk_size];
+    let mut current_len = read_full(reader, &mut current)?;
+    let mut index = 0u64;
+    let mut total = 0u64;
+    loop {
+        let next_len = if current_len == chunk_size {
+            read_full(reader, &mut next)?
+        } else {
+            0
+        };
+        let last = next_len == 0;
+
+        let nonce = header.nonce(index, last)?;
+        let sealed = cipher
+            .encrypt(
+                Nonce::from_slice(&nonce),
+                Payload {
+                    msg: &current[..current_len],
+                    aad: &aad,
+                },
+            )
+            .map_err(|_| StreamError::Corrupt(index))?;
+        writer.write_all(&sealed)?;
+        total += current_len as u64;
+
+        if last {
+            break;
+        }
+        std::mem::swap(&mut current, &mut next);
+        current_len = next_len;
+        index += 1;
+    }
+
+    writer.flush()?;
+    Ok(total)
+}
+
+/// Decrypt a stream written by `encrypt_stream` into `writer`, one chunk at
+/// a time. Nothing past a chunk that fails is written, but chunks before it
+/// already have been; callers that need all-or-nothing write to a
+/// temporary first. Returns the number of plaintext bytes.
+pub fn decrypt_stream<R: Read, W: Write>(
+    reader: &mut R,
+    writer: &mut W,
+    key: &MasterKey,
+) -> Result<u64, StreamError> {
+    let header = Header::read(reader)?;
+    let aad = header.to_bytes();
+    let cipher = cipher_for(key);
+
+    let sealed_size = header.chunk_size + TAG_SIZE;
+    let mut current = vec![0u8; sealed_size];
+    let mut next = vec![0u8; sealed_size];
+    let mut current_len = read_full(reader, &mut current)?;
+    let mut index = 0u64;
+    let mut total = 0u64;
+    loop {
+        if current_len < TAG_SIZE {
+            return Err(StreamError::Truncated);
+        }
+        let next_len = if current_len == sealed_size {
+            read_full(reader, &mut next)?
+        } else {
+            0
+        };
+        let last = next_len == 0;
+
+        let nonce = header.nonce(index, last)?;
+        let plaintext = cipher
+            .decrypt(
+                Nonce::from_slice(&nonce),
+                Payload {
+                    msg: &current[..current_len],
+                    aad: &aad,
+                },
+            )
+            .map_err(|_| if last { StreamError::Truncated } else { StreamError::Corrupt(index) })?;
+        writer.write_all(&plaintext)?;
+        total += plaintext.len() as u64;
+
+        if last {
+            break;
+        }
+        std::mem::swap(&mut current, &mut next);
+        current_len = next_len;
+        index += 1;
+    }
+
+    writer.flush()?;
+    Ok(total)
+}
+
+/// Random access to the chunks of an encrypted stream, for showing a large
+/// attachment progressively. Each chunk is authenticated on its own; the
+/// stream length decides which one must carry the final flag, so a stream
+/// cut at a chunk boundary fails on its new last chunk.
+pub struct StreamReader<R: Read + Seek> {
+    inner: R,
+    header: Header,
+    cipher: ChaCha20Poly1305,
+    chunk_count: u64,
+    last_chunk_len: usize,
+}
+
+impl<R: Read + Seek> StreamReader<R> {
+    pub fn open(mut inner: R, key: &MasterKey) -> Result<Self, StreamError> {
+        inner.seek(SeekFrom::Start(0))?;
+        let header = Header::read(&mut inner)?;
+        let body = inner
+            .seek(SeekFrom::End(0))?
+            .checked_sub(HEADER_SIZE as u64)
+            .ok_or(StreamError::InvalidHeader)?;
+
+        let sealed_size = (header.chunk_size + TAG_SIZE) as u64;
+        if body < TAG_SIZE as u64 {
+            return Err(StreamError::Truncated);
+        }
+        // A body that ends on a chunk boundary ends with a full chunk
+        let chunk_count = (body + sealed_size - 1) / sealed_size;
+        let last_sealed = body - (chunk_count - 1) * sealed_size;
+        if last_sealed < TAG_SIZE as u64 {
+            return Err(StreamError::Truncated);
+        }
+        if chunk_count > u32::MAX as u64 + 1 {
+            return Err(StreamError::TooLarge);
+        }
+
+        Ok(StreamReader {
+            inner,
+            cipher: cipher_for(key),
+            chunk_count,
+            last_chunk_len: last_sealed as usize - TAG_SIZE,
+            header,
+        })
+    }
+
+    pub fn chunk_count(&self) -> u64 {
+        self.chunk_count
+    }
+
+    pub fn chunk_size(&self) -> usize {
+        self.header.chunk_size
+    }
+
+    pub fn plaintext_len(&self) -> u64 {
+        (self.chunk_count - 1) * self.header.chunk_size as u64 + self.last_chunk_len as u64
+    }
+
+    /// Decrypt chunk `index` only
+    pub fn read_chunk(&mut self, index: u64) -> Result<Vec<u8>, StreamError> {
+        if index >= self.chunk_count {
+            return Err(StreamError::ChunkOutOfRange(index));
+        }
+
+        let last = index + 1 == self.chunk_count;
+        let sealed_size = self.header.chunk_size + TAG_SIZE;
+        let len = if last { self.last_chunk_len + TAG_SIZE } else { sealed_size };
+        let mut sealed = vec![0u8; len];
+        self.inner
+            .seek(SeekFrom::Start(HEADER_SIZE as u64 + index * sealed_size as u64))?;
+        self.inner.read_exact(&mut sealed).map_err(|e| match e.kind() {
+            io::ErrorKind::UnexpectedEof => StreamError::Truncated,
+            _ => StreamError::Io(e),
+        })?;
+
+        let aad = self.header.to_bytes();
+        let nonce = self.header.nonce(index, last)?;
+        self.cipher
+            .decrypt(Nonce::from_slice(&nonce), Payload { msg: &sealed, aad: &aad })
+            .map_err(|_| StreamError::Corrupt(index))
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::io::Cursor;
+
+    const CHUNK: usize = 64;
+
+    fn key(byte: u8) -> MasterKey {
+        MasterKey::from_bytes([byte; 32])
+    }
+
+    fn sample(len: usize) -> Vec<u8> {
+        (0..len).map(|i| (i * 31 % 251) as u8).collect()
+    }
+
+    fn encrypt(data: &[u8]) -> Vec<u8> {
+        let mut out = Vec::new();
+        encrypt_stream(&mut Cursor::new(data), &mut out, &key(1), CHUNK).unwrap();
+        out
+    }
+
+    fn decrypt(sealed: &[u8]) -> Result<Vec<u8>, StreamError> {
+        let mut out = Vec::new();
+        decrypt_stream(&mut Cursor::new(sealed), &mut out, &key(1))?;
+        Ok(out)
+    }
+
+    #[test]
+    fn test_roundtrip_sizes() {
+        for len in [0, 1, CHUNK - 1, CHUNK, CHUNK + 1, 3 * CHUNK, 3 * CHUNK + CHUNK / 2] {
+            let data = sample(len);
+            let sealed = encrypt(&data);
+
+            let chunks = ((len + CHUNK - 1) / CHUNK).max(1);
+            assert_eq!(sealed.len(), HEADER_SIZE + len + chunks * TAG_SIZE, "len {}", len);
+            assert_eq!(decrypt(&sealed).unwrap(), data, "len {}", len);
+        }
+    }
+
+    #[test]
+    fn test_wrong_key_fails() {
+        let sealed = encrypt(&sample(200));
+        let mut out = Vec::new();
+        assert!(decrypt_stream(&mut Cursor::new(&sealed), &mut out, &key(2)).is_err());
+    }
+
+    #[test]
+    fn test_truncation_fails() {
+        let sealed = encrypt(&sample(3 * CHUNK + 10));
+
+        // Cut at a chunk boundary: the new last chunk is not flagged final
+        let cut = HEADER_SIZE + 2 * (CHUNK + TAG_SIZE);
+        assert!(matches!(decrypt(&sealed[..cut]), Err(StreamError::Truncated)));
+        assert!(StreamReader::open(Cursor::new(&sealed[..cut]), &key(1))
+            .unwrap()
+            .read_chunk(1)
+            .is_err());
+
+        // Cut inside a chunk
+        assert!(decrypt(&sealed[..sealed.len() - 3]).is_err());
+    }
+
+    #[test]
+    fn test_reordered_chunks_fail() {
+        let mut sealed = encrypt(&sample(3 * CHUNK));
+        let a = HEADER_SIZE;
+        let b = HEADER_SIZE + CHUNK + TAG_SIZE;
+        let first: Vec<u8> = sealed[a..b].to_vec();
+        let second: Vec<u8> = sealed[b..b + CHUNK + TAG_SIZE].to_vec();
+        sealed[a..b].copy_from_slice(&second);
+        sealed[b..b + CHUNK + TAG_SIZE].copy_from_slice(&first);
+
+        assert!(matches!(decrypt(&sealed), Err(StreamError::Corrupt(0))));
+    }
+
+    #[test]
+    fn test_header_is_authenticated() {
+        let mut sealed = encrypt(&sample(100));
+        // Same chunk size field, different nonce prefix
+        sealed[HEADER_SIZE - 1] ^= 1;
+        assert!(decrypt(&sealed).is_err());
+
+        let mut sealed = encrypt(&sample(100));
+        sealed[0] = b'X';
+        assert!(matches!(decrypt(&sealed), Err(StreamError::InvalidHeader)));
+    }
+
+    #[test]
+    fn test_random_access() {
+        let data = sample(5 * CHUNK + 7);
+        let sealed = encrypt(&data);
+
+        let mut reader = StreamReader::open(Cursor::new(sealed), &key(1)).unwrap();
+        assert_eq!(reader.chunk_count(), 6);
+        assert_eq!(reader.chunk_size(), CHUNK);
+        assert_eq!(reader.plaintext_len(), data.len() as u64);
+
+        assert_eq!(reader.read_chunk(3).unwrap(), &data[3 * CHUNK..4 * CHUNK]);
+        assert_eq!(reader.read_chunk(5).unwrap(), &data[5 * CHUNK..]);
+        assert_eq!(reader.read_chunk(0).unwrap(), &data[..CHUNK]);
+        assert!(matches!(reader.read_chunk(6), Err(StreamError::ChunkOutOfRange(6))));
+    }
+
+    #[test]
+    fn test_random_access_exact_multiple() {
+        let data = sample(2 * CHUNK);
+        let mut reader = StreamReader::open(Cursor::new(encrypt(&data)), &key(1)).unwrap();
+
+        assert_eq!(reader.chunk_count(), 2);
+        assert_eq!(reader.plaintext_len(), data.len() as u64);
+        assert_eq!(reader.read_chunk(1).unwrap(), &data[CHUNK..]);
+    }
+}
@@ -100,6 +100,71 @@ impl Note {
     }
 }
 
+/// Checklist item of a note. The label is part of the note text; the row
+/// keeps the checked state, the item's order and an encrypted copy of the
+/// label, so ticking an item never touches the note.
+#[derive(Debug, Clone)]
+pub struct Checkbox {
+    pub id: Option<i64>,
+    pub note_id: i64,
+    pub text_encrypted: Vec<u8>,
+    pub is_checked: bool,
+    pub position: i32,
+}
+
+/// Picture shown in a page (`page_id` set) or a note (`page_id` None). The
+/// text holds a U+FFFC for it at `position_in_content`, a UTF-16 offset as
+/// the editor counts; width and height are the size it is shown at.
+/// `thumbnail_path` is the content hash its thumbnails are stored under in
+/// the thumbnail directory, once they have been made.
+#[derive(Debug, Clone)]
+pub struct Image {
+    pub id: Option<i64>,
+    pub entry_id: i64,
+    pub page_id: Option<i64>,
+    pub file_path: String,
+    pub thumbnail_path: Option<String>,
+    pub blob_hash: Option<String>,
+    pub position_in_content: i32,
+    pub width: i32,
+    pub height: i32,
+    pub created_at: i64,
+}
+
+impl Image {
+    pub fn new(
+        entry_id: i64,
+        page_id: Option<i64>,
+        file_path: String,
+        position_in_content: i32,
+        width: i32,
+        height: i32,
+    ) -> Self {
+        Image {
+            id: None,
+            entry_id,
+            page_id,
+            file_path,
+            thumbnail_path: None,
+            blob_hash: None,
+            position_in_content,
+            width,
+            height,
+            created_at: Utc::now().timestamp(),
+        }
+    }
+}
+
+/// Blob structure: one encrypted original file, shared by every image
+/// with the same content
+#[derive(Debug, Clone)]
+pub struct Blob {
+    pub hash: String,
+    pub size: i64,
+    pub refcount: i64,
+    pub created_at: i64,
+}
+
 /// Entry queries
 pub mod entries {
     use super::*;
@@ -296,6 +361,26 @@ pub mod pages {
         pages.collect()
     }
 
+    /// Get a page by its number within an entry
+    pub fn get_by_number(conn: &Connection, entry_id: i64, page_number: i32) -> Result<Option<Page>> {
+        conn.query_row(
+            "SELECT id, entry_id, page_number, content_encrypted, word_count, created_at
+             FROM pages WHERE entry_id = ?1 AND page_number = ?2",
+            params![entry_id, page_number],
+            |row| {
+                Ok(Page {
+                    id: Some(row.get(0)?),
+                    entry_id: row.get(1)?,
+                    page_number: row.get(2)?,
+                    content_encrypted: row.get(3)?,
+                    word_count: row.get(4)?,
+                    created_at: row.get(5)?,
+                })
+            },
+        )
+        .optional()
+    }
+
     /// Update page content
     pub fn update(conn: &Connection, page: &Page) -> Result<()> {
         let id = page.id.expect("Page must have an ID to update");
@@ -369,6 +454,15 @@ pub mod notes {
         Ok(())
     }
 
+    /// Record whether the note holds checklist items, without touching its text
+    pub fn set_has_checkboxes(conn: &Connection, entry_id: i64, has_checkboxes: bool) -> Result<()> {
+        conn.execute(
+            "UPDATE notes SET has_checkboxes = ?1 WHERE entry_id = ?2",
+            params![has_checkboxes as i32, entry_id],
+        )?;
+        Ok(())
+    }
+
     /// Delete note
     pub fn delete(conn: &Connection, entry_id: i64) -> Result<()> {
         conn.execute("DELETE FROM notes WHERE entry_id = ?1", params![entry_id])?;
@@ -376,6 +470,264 @@ pub mod notes {
     }
 }
 
+/// Checkbox queries (Note mode)
+pub mod checkboxes {
+    use super::*;
+
+    /// Create an unchecked item at `position`, moving the items from there on
+    /// down by one
+    pub fn create(conn: &Connection, note_id: i64, position: i32) -> Result<i64> {
+        let tx = conn.unchecked_transaction()?;
+        tx.execute(
+            "UPDATE checkboxes SET position = position + 1 WHERE note_id = ?1 AND position >= ?2",
+            params![note_id, position],
+        )?;
+        tx.execute(
+            "INSERT INTO checkboxes (note_id, text, is_checked, position) VALUES (?1, ?2, 0, ?3)",
+            params![note_id, Vec::<u8>::new(), position],
+        )?;
+        let id = tx.last_insert_rowid();
+        tx.commit()?;
+        Ok(id)
+    }
+
+    /// Get a note's items in order
+    pub fn get_by_note(conn: &Connection, note_id: i64) -> Result<Vec<Checkbox>> {
+        let mut stmt = conn.prepare(
+            "SELECT id, note_id, text, is_checked, position
+             FROM checkboxes WHERE note_id = ?1 ORDER BY position, id",
+        )?;
+
+        let checkboxes = stmt.query_map(params![note_id], |row| {
+            Ok(Checkbox {
+                id: Some(row.get(0)?),
+                note_id: row.get(1)?,
+                text_encrypted: row.get(2)?,
+                is_checked: row.get::<_, i32>(3)? != 0,
+                position: row.get(4)?,
+            })
+        })?;
+
+        checkboxes.collect()
+    }
+
+    /// Tick or untick one item
+    pub fn set_checked(conn: &Connection, id: i64, checked: bool) -> Result<()> {
+        conn.execute(
+            "UPDATE checkboxes SET is_checked = ?1 WHERE id = ?2",
+            params![checked as i32, id],
+        )?;
+        Ok(())
+    }
+
+    /// Match the rows to the items left in the saved note: `items` are the
+    /// ids in text order, each with its encrypted label when known. Rows of
+    /// the note that are not listed were deleted from the text.
+    pub fn sync(conn: &Connection, note_id: i64, items: &[(i64, Option<Vec<u8>>)]) -> Result<()> {
+        let tx = conn.unchecked_transaction()?;
+
+        let existing: Vec<i64> = {
+            let mut stmt = tx.prepare("SELECT id FROM checkboxes WHERE note_id = ?1")?;
+            let ids = stmt
+                .query_map(params![note_id], |row| row.get(0))?
+                .collect::<Result<Vec<i64>>>()?;
+            ids
+        };
+        for id in existing {
+            if !items.iter().any(|(item_id, _)| *item_id == id) {
+                tx.execute("DELETE FROM checkboxes WHERE id = ?1", params![id])?;
+            }
+        }
+
+        for (position, (id, text)) in items.iter().enumerate() {
+            match text {
+                Some(text) => tx.execute(
+                    "UPDATE checkboxes SET position = ?1, text = ?2 WHERE id = ?3 AND note_id = ?4",
+                    params![position as i32, text, id, note_id],
+                )?,
+                None => tx.execute(
+                    "UPDATE checkboxes SET position = ?1 WHERE id = ?2 AND note_id = ?3",
+                    params![position as i32, id, note_id],
+                )?,
+            };
+        }
+
+        tx.commit()
+    }
+}
+
+/// Image queries (both modes)
+pub mod images {
+    use super::*;
+
+    /// Create an image row
+    pub fn create(conn: &Connection, image: &Image) -> Result<i64> {
+        conn.execute(
+            "INSERT INTO images (entry_id, page_id, file_path, thumbnail_path, blob_hash, position_in_content, width, height, created_at)
+             VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8, ?9)",
+            params![
+                image.entry_id,
+                image.page_id,
+                &image.file_path,
+                &image.thumbnail_path,
+                &image.blob_hash,
+                image.position_in_content,
+                image.width,
+                image.height,
+                image.created_at,
+            ],
+        )?;
+        Ok(conn.last_insert_rowid())
+    }
+
+    /// Get the images of a page, or of a note's entry when `page_id` is None,
+    /// in text order
+    pub fn get_by_owner(conn: &Connection, entry_id: i64, page_id: Option<i64>) -> Result<Vec<Image>> {
+        let mut stmt = conn.prepare(
+            "SELECT id, entry_id, page_id, file_path, thumbnail_path, blob_hash, position_in_content, width, height, created_at
+             FROM images WHERE entry_id = ?1 AND page_id IS ?2 ORDER BY position_in_content, id",
+        )?;
+
+        let images = stmt.query_map(params![entry_id, page_id], |row| {
+            Ok(Image {
+                id: Some(row.get(0)?),
+                entry_id: row.get(1)?,
+                page_id: row.get(2)?,
+                file_path: row.get(3)?,
+                thumbnail_path: row.get(4)?,
+                blob_hash: row.get(5)?,
+                position_in_content: row.get(6)?,
+                width: row.get::<_, Option<i32>>(7)?.unwrap_or(0),
+                height: row.get::<_, Option<i32>>(8)?.unwrap_or(0),
+                created_at: row.get(9)?,
+            })
+        })?;
+
+        images.collect()
+    }
+
+    /// Hash of the blob holding an image's original, if it has one
+    pub fn blob_hash(conn: &Connection, id: i64) -> Result<Option<String>> {
+        let hash = conn
+            .query_row("SELECT blob_hash FROM images WHERE id = ?1", params![id], |row| row.get(0))
+            .optional()?;
+        Ok(hash.flatten())
+    }
+
+    /// Point an image at the thumbnails stored under `hash`
+    pub fn set_thumbnail(conn: &Connection, id: i64, hash: &str) -> Result<()> {
+        conn.execute(
+            "UPDATE images SET thumbnail_path = ?1 WHERE id = ?2",
+            params![hash, id],
+        )?;
+        Ok(())
+    }
+
+    /// Point an image at the blob holding its original; the triggers move
+    /// the reference counts
+    pub fn set_blob(conn: &Connection, id: i64, hash: &str) -> Result<()> {
+        conn.execute(
+            "UPDATE images SET blob_hash = ?1 WHERE id = ?2",
+            params![hash, id],
+        )?;
+        Ok(())
+    }
+
+    /// Move an image to `page_id` at UTF-16 offset `position`, e.g. when
+    /// auto-pagination carried its U+FFFC onto the next page
+    pub fn move_to(conn: &Connection, id: i64, page_id: Option<i64>, position: i32) -> Result<()> {
+        conn.execute(
+            "UPDATE images SET page_id = ?1, position_in_content = ?2 WHERE id = ?3",
+            params![page_id, position, id],
+        )?;
+        Ok(())
+    }
+
+    /// Match the rows of a page or note to the images left in its saved text:
+    /// `items` are (id, offset) in text order. Rows of that page or note that
+    /// are not listed were deleted from the text.
+    pub fn sync(conn: &Connection, entry_id: i64, page_id: Option<i64>, items: &[(i64, i32)]) -> Result<()> {
+        let tx = conn.unchecked_transaction()?;
+
+        let existing: Vec<i64> = {
+            let mut stmt = tx.prepare("SELECT id FROM images WHERE entry_id = ?1 AND page_id IS ?2")?;
+            let ids = stmt
+                .query_map(params![entry_id, page_id], |row| row.get(0))?
+                .collect::<Result<Vec<i64>>>()?;
+            ids
+        };
+        for id in existing {
+            if !items.iter().any(|(item_id, _)| *item_id == id) {
+                tx.execute("DELETE FROM images WHERE id = ?1", params![id])?;
+            }
+        }
+
+        for (id, position) in items {
+            tx.execute(
+                "UPDATE images SET position_in_content = ?1 WHERE id = ?2 AND entry_id = ?3 AND page_id IS ?4",
+                params![position, id, entry_id, page_id],
+            )?;
+        }
+
+        tx.commit()
+    }
+}
+
+/// Blob queries. Reference counts are kept by triggers on `images`.
+pub mod blobs {
+    use super::*;
+
+    /// Record a stored blob; a hash already known is left as it is
+    pub fn add(conn: &Connection, hash: &str, size: i64) -> Result<()> {
+        conn.execute(
+            "INSERT OR IGNORE INTO blobs (hash, size, refcount, created_at) VALUES (?1, ?2, 0, ?3)",
+            params![hash, size, Utc::now().timestamp()],
+        )?;
+        Ok(())
+    }
+
+    /// Get a blob by hash
+    pub fn get(conn: &Connection, hash: &str) -> Result<Option<Blob>> {
+        conn.query_row(
+            "SELECT hash, size, refcount, created_at FROM blobs WHERE hash = ?1",
+            params![hash],
+            |row| {
+                Ok(Blob {
+                    hash: row.get(0)?,
+                    size: row.get(1)?,
+                    refcount: row.get(2)?,
+                    created_at: row.get(3)?,
+                })
+            },
+        )
+        .optional()
+    }
+
+    /// Hashes of the blobs no image refers to any more
+    pub fn unreferenced(conn: &Connection) -> Result<Vec<String>> {
+        let mut stmt = conn.prepare("SELECT hash FROM blobs WHERE refcount <= 0")?;
+        let hashes = stmt.query_map([], |row| row.get(0))?;
+        hashes.collect()
+    }
+
+    /// Every hash with a row, referenced or not
+    pub fn all_hashes(conn: &Connection) -> Result<Vec<String>> {
+        let mut stmt = conn.prepare("SELECT hash FROM blobs")?;
+        let hashes = stmt.query_map([], |row| row.get(0))?;
+        hashes.collect()
+    }
+
+    /// Drop a blob's row unless an image took it up again meanwhile.
+    /// Returns whether it was dropped, i.e. whether its file may go.
+    pub fn remove_unreferenced(conn: &Connection, hash: &str) -> Result<bool> {
+        let removed = conn.execute(
+            "DELETE FROM blobs WHERE hash = ?1 AND refcount <= 0",
+            params![hash],
+        )?;
+        Ok(removed > 0)
+    }
+}
+
 /// Search queries using FTS5
 pub mod search {
     use super::*;
@@ -524,6 +876,20 @@ mod tests {
         assert_eq!(all_pages[2].page_number, 3);
     }
 
+    #[test]
+    fn test_get_page_by_number() {
+        let db = setup_test_db();
+        let entry = Entry::new("Book Entry".to_string(), EntryMode::Book, vec![1]);
+        let entry_id = entries::create(db.connection(), &entry).unwrap();
+
+        pages::create(db.connection(), &Page::new(entry_id, 1, vec![1], 100)).unwrap();
+        pages::create(db.connection(), &Page::new(entry_id, 2, vec![2], 200)).unwrap();
+
+        let second = pages::get_by_number(db.connection(), entry_id, 2).unwrap().unwrap();
+        assert_eq!(second.word_count, 200);
+        assert!(pages::get_by_number(db.connection(), entry_id, 3).unwrap().is_none());
+    }
+
     #[test]
     fn test_create_and_get_note() {
         let db = setup_test_db();
@@ -535,6 +901,158 @@ mod tests {
 
         let retrieved = notes::get_by_entry(db.connection(), entry_id).unwrap();
         assert_eq!(retrieved.has_checkboxes, true);
+
+        notes::set_has_checkboxes(db.connection(), entry_id, false).unwrap();
+        let retrieved = notes::get_by_entry(db.connection(), entry_id).unwrap();
+        assert_eq!(retrieved.has_checkboxes, false);
+        assert_eq!(retrieved.content_encrypted, vec![10, 20, 30]);
+    }
+
+    #[test]
+    fn test_checkbox_create_and_toggle() {
+        let db = setup_test_db();
+        let entry_id = entries::create(
+            db.connection(),
+            &Entry::new("Todo".to_string(), EntryMode::Note, vec![1]),
+        )
+        .unwrap();
+        let note_id = notes::create(db.connection(), &Note::new(entry_id, vec![1], true)).unwrap();
+
+        let first = checkboxes::create(db.connection(), note_id, 0).unwrap();
+        let last = checkboxes::create(db.connection(), note_id, 1).unwrap();
+        // Inserted between the two
+        let middle = checkboxes::create(db.connection(), note_id, 1).unwrap();
+
+        checkboxes::set_checked(db.connection(), middle, true).unwrap();
+
+        let items = checkboxes::get_by_note(db.connection(), note_id).unwrap();
+        let ids: Vec<i64> = items.iter().map(|item| item.id.unwrap()).collect();
+        assert_eq!(ids, vec![first, middle, last]);
+        assert_eq!(
+            items.iter().map(|item| item.is_checked).collect::<Vec<_>>(),
+            vec![false, true, false]
+        );
+    }
+
+    #[test]
+    fn test_checkbox_sync() {
+        let db = setup_test_db();
+        let entry_id = entries::create(
+            db.connection(),
+            &Entry::new("Todo".to_string(), EntryMode::Note, vec![1]),
+        )
+        .unwrap();
+        let note_id = notes::create(db.connection(), &Note::new(entry_id, vec![1], true)).unwrap();
+
+        let a = checkboxes::create(db.connection(), note_id, 0).unwrap();
+        let b = checkboxes::create(db.connection(), note_id, 1).unwrap();
+        let c = checkboxes::create(db.connection(), note_id, 2).unwrap();
+
+        // `b` was deleted from the text and `c` moved above `a`
+        checkboxes::sync(
+            db.connection(),
+            note_id,
+            &[(c, Some(vec![3])), (a, None)],
+        )
+        .unwrap();
+
+        let items = checkboxes::get_by_note(db.connection(), note_id).unwrap();
+        assert_eq!(items.len(), 2);
+        assert_eq!(items[0].id, Some(c));
+        assert_eq!(items[0].text_encrypted, vec![3]);
+        assert_eq!(items[1].id, Some(a));
+        assert!(items.iter().all(|item| item.id != Some(b)));
+    }
+
+    #[test]
+    fn test_image_sync() {
+        let db = setup_test_db();
+        let entry_id = entries::create(
+            db.connection(),
+            &Entry::new("Album".to_string(), EntryMode::Book, vec![1]),
+        )
+        .unwrap();
+        let page_id = pages::create(db.connection(), &Page::new(entry_id, 1, vec![1], 0)).unwrap();
+
+        let on_page = |position| Image::new(entry_id, Some(page_id), "a.png".to_string(), position, 600, 400);
+        let a = images::create(db.connection(), &on_page(3)).unwrap();
+        let b = images::create(db.connection(), &on_page(10)).unwrap();
+        let c = images::create(db.connection(), &on_page(20)).unwrap();
+        // Same entry, no page: left alone by the page's sync
+        let other = images::create(
+            db.connection(),
+            &Image::new(entry_id, None, "b.png".to_string(), 0, 100, 100),
+        )
+        .unwrap();
+
+        // `b` was deleted and text typed before `c` moved it ahead of `a`
+        images::sync(db.connection(), entry_id, Some(page_id), &[(c, 1), (a, 5)]).unwrap();
+
+        let items = images::get_by_owner(db.connection(), entry_id, Some(page_id)).unwrap();
+        assert_eq!(items.iter().map(|image| image.id.unwrap()).collect::<Vec<_>>(), vec![c, a]);
+        assert_eq!(items[1].position_in_content, 5);
+        assert_eq!((items[1].width, items[1].height), (600, 400));
+        assert!(items.iter().all(|image| image.id != Some(b)));
+
+        let loose = images::get_by_owner(db.connection(), entry_id, None).unwrap();
+        assert_eq!(loose.len(), 1);
+        assert_eq!(loose[0].id, Some(other));
+        assert!(loose[0].thumbnail_path.is_none());
+
+        assert_eq!(images::blob_hash(db.connection(), other).unwrap(), None);
+        assert_eq!(images::blob_hash(db.connection(), b).unwrap(), None);
+
+        images::set_thumbnail(db.connection(), other, "ab12").unwrap();
+        let loose = images::get_by_owner(db.connection(), entry_id, None).unwrap();
+        assert_eq!(loose[0].thumbnail_path.as_deref(), Some("ab12"));
+
+        // Carried onto the next page, the row is no longer the first page's
+        let next_id = pages::create(db.connection(), &Page::new(entry_id, 2, vec![1], 0)).unwrap();
+        images::move_to(db.connection(), a, Some(next_id), 2).unwrap();
+        images::sync(db.connection(), entry_id, Some(page_id), &[(c, 1)]).unwrap();
+        let moved = images::get_by_owner(db.connection(), entry_id, Some(next_id)).unwrap();
+        assert_eq!(moved.len(), 1);
+        assert_eq!((moved[0].id, moved[0].position_in_content), (Some(a), 2));
+    }
+
+    #[test]
+    fn test_blob_refcount() {
+        let db = setup_test_db();
+        let entry_id = entries::create(
+            db.connection(),
+            &Entry::new("Scraps".to_string(), EntryMode::Note, vec![1]),
+        )
+        .unwrap();
+        let hash = "c0ffee";
+        blobs::add(db.connection(), hash, 1234).unwrap();
+        blobs::add(db.connection(), hash, 1234).unwrap();
+
+        let with_blob = |position| {
+            let mut image = Image::new(entry_id, None, "shot.png".to_string(), position, 10, 10);
+            image.blob_hash = Some(hash.to_string());
+            image
+        };
+        let a = images::create(db.connection(), &with_blob(0)).unwrap();
+        images::create(db.connection(), &with_blob(4)).unwrap();
+
+        let blob = blobs::get(db.connection(), hash).unwrap().unwrap();
+        assert_eq!((blob.size, blob.refcount), (1234, 2));
+        assert_eq!(
+            images::get_by_owner(db.connection(), entry_id, None).unwrap()[0].blob_hash.as_deref(),
+            Some(hash)
+        );
+
+        // Still in use: not collected
+        images::sync(db.connection(), entry_id, None, &[(a, 0)]).unwrap();
+        assert_eq!(blobs::get(db.connection(), hash).unwrap().unwrap().refcount, 1);
+        assert!(blobs::unreferenced(db.connection()).unwrap().is_empty());
+        assert!(!blobs::remove_unreferenced(db.connection(), hash).unwrap());
+
+        // Deleting the entry cascades to its images and releases the blob
+        entries::delete(db.connection(), entry_id).unwrap();
+        assert_eq!(blobs::unreferenced(db.connection()).unwrap(), vec![hash.to_string()]);
+        assert!(blobs::remove_unreferenced(db.connection(), hash).unwrap());
+        assert!(blobs::get(db.connection(), hash).unwrap().is_none());
     }
 
     #[test]
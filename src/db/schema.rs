@@ -4,7 +4,7 @@ use log::{info, warn};
 use rusqlite::{Connection, Result};
 
 /// Current schema version
-const CURRENT_VERSION: i32 = 1;
+const CURRENT_VERSION: i32 = 2;
 
 /// Initialize database schema
 pub fn initialize_schema(conn: &Connection) -> Result<()> {
@@ -14,6 +14,7 @@ pub fn initialize_schema(conn: &Connection) -> Result<()> {
     if version == 0 {
         info!("Creating new database schema...");
         create_initial_schema(conn)?;
+        migrate_schema(conn, 1)?;
         set_schema_version(conn, CURRENT_VERSION)?;
         info!("Database schema created successfully");
     } else if version < CURRENT_VERSION {
@@ -22,6 +23,7 @@ pub fn initialize_schema(conn: &Connection) -> Result<()> {
             version, CURRENT_VERSION
         );
         migrate_schema(conn, version)?;
+        set_schema_version(conn, CURRENT_VERSION)?;
         info!("Database migration completed");
     } else if version > CURRENT_VERSION {
         warn!(
@@ -168,18 +170,58 @@ fn create_initial_schema(conn: &Connection) -> Result<()> {
     Ok(())
 }
 
-/// Migrate schema from old version to new version
+/// Migrate schema from old version to new version, one step at a time
 fn migrate_schema(conn: &Connection, from_version: i32) -> Result<()> {
-    match from_version {
-        1 => {
-            // Future migrations will go here
-            Ok(())
-        }
-        _ => {
-            warn!("No migration path from version {}", from_version);
-            Ok(())
+    for version in from_version..CURRENT_VERSION {
+        match version {
+            1 => migrate_v1_to_v2(conn)?,
+            _ => warn!("No migration path from version {}", version),
         }
     }
+    Ok(())
+}
+
+/// Version 2: content-addressed blob store. Images point at the encrypted
+/// original by keyed hash; triggers keep each blob's reference count, so
+/// pasting the same picture again only adds a row.
+fn migrate_v1_to_v2(conn: &Connection) -> Result<()> {
+    conn.execute_batch(
+        r#"
+        BEGIN;
+
+        CREATE TABLE blobs (
+            hash TEXT PRIMARY KEY,
+            size INTEGER NOT NULL,
+            refcount INTEGER NOT NULL DEFAULT 0,
+            created_at INTEGER NOT NULL
+        );
+
+        ALTER TABLE images ADD COLUMN blob_hash TEXT REFERENCES blobs(hash);
+
+        CREATE INDEX idx_images_blob ON images(blob_hash);
+        CREATE INDEX idx_blobs_unreferenced ON blobs(hash) WHERE refcount <= 0;
+
+        -- Reference counting, also through cascaded deletes
+        CREATE TRIGGER images_blob_ai AFTER INSERT ON images
+        WHEN new.blob_hash IS NOT NULL BEGIN
+            UPDATE blobs SET refcount = refcount + 1 WHERE hash = new.blob_hash;
+        END;
+
+        CREATE TRIGGER images_blob_ad AFTER DELETE ON images
+        WHEN old.blob_hash IS NOT NULL BEGIN
+            UPDATE blobs SET refcount = refcount - 1 WHERE hash = old.blob_hash;
+        END;
+
+        CREATE TRIGGER images_blob_au AFTER UPDATE OF blob_hash ON images BEGIN
+            UPDATE blobs SET refcount = refcount - 1 WHERE hash = old.blob_hash;
+            UPDATE blobs SET refcount = refcount + 1 WHERE hash = new.blob_hash;
+        END;
+
+        COMMIT;
+        "#,
+    )?;
+
+    Ok(())
 }
 
 #[cfg(test)]
@@ -214,6 +256,7 @@ mod tests {
             "notes",
             "checkboxes",
             "images",
+            "blobs",
             "sync_metadata",
             "user_settings",
         ];
@@ -233,4 +276,24 @@ mod tests {
             assert_eq!(count, 1, "Table {} not created", table);
         }
     }
+
+    #[test]
+    fn test_migrate_from_v1() {
+        let db = Database::in_memory().unwrap();
+        create_initial_schema(db.connection()).unwrap();
+        set_schema_version(db.connection(), 1).unwrap();
+
+        initialize_schema(db.connection()).unwrap();
+
+        assert_eq!(get_schema_version(db.connection()).unwrap(), CURRENT_VERSION);
+        let has_column: i32 = db
+            .connection()
+            .query_row(
+                "SELECT COUNT(*) FROM pragma_table_info('images') WHERE name = 'blob_hash'",
+                [],
+                |row| row.get(0),
+            )
+            .unwrap();
+        assert_eq!(has_column, 1);
+    }
 }
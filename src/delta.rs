@@ -0,0 +1,108 @@
+// src/delta.rs
+// Applies the edit batches sent by the editor's delta save
+
+/// One edit of a batch, in UTF-8 byte offsets of the text as left by the
+/// previous edits
+#[derive(Debug, Clone, PartialEq)]
+pub struct Edit<'a> {
+    pub offset: usize,
+    pub delete: usize,
+    pub insert: &'a str,
+}
+
+/// Delta error type
+#[derive(Debug)]
+pub enum DeltaError {
+    OutOfRange { offset: usize, delete: usize, len: usize },
+    NotCharBoundary(usize),
+}
+
+impl std::fmt::Display for DeltaError {
+    fn fmt(&self, f: &mut std::fmt::Formatter) -> std::fmt::Result {
+        match self {
+            DeltaError::OutOfRange { offset, delete, len } => {
+                write!(f, "Edit {}+{} is outside text of {} bytes", offset, delete, len)
+            }
+            DeltaError::NotCharBoundary(at) => write!(f, "Edit splits a character at byte {}", at),
+        }
+    }
+}
+
+impl std::error::Error for DeltaError {}
+
+/// Apply `edits` in order. Leaves `text` untouched when any edit is invalid,
+/// since a batch that does not fit means the base text was not the one the
+/// editor had.
+pub fn apply(text: &mut String, edits: &[Edit]) -> Result<(), DeltaError> {
+    let mut result = text.clone();
+
+    for edit in edits {
+        let end = edit
+            .offset
+            .checked_add(edit.delete)
+            .filter(|&end| end <= result.len())
+            .ok_or(DeltaError::OutOfRange {
+                offset: edit.offset,
+                delete: edit.delete,
+                len: result.len(),
+            })?;
+
+        for at in [edit.offset, end] {
+            if !result.is_char_boundary(at) {
+                return Err(DeltaError::NotCharBoundary(at));
+            }
+        }
+
+        result.replace_range(edit.offset..end, edit.insert);
+    }
+
+    *text = result;
+    Ok(())
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn edit(offset: usize, delete: usize, insert: &str) -> Edit<'_> {
+        Edit { offset, delete, insert }
+    }
+
+    #[test]
+    fn test_apply_sequential_edits() {
+        let mut text = String::from("Hello world");
+
+        apply(&mut text, &[edit(5, 0, ","), edit(7, 5, "there"), edit(12, 0, "!")]).unwrap();
+
+        assert_eq!(text, "Hello, there!");
+    }
+
+    #[test]
+    fn test_apply_multibyte_offsets() {
+        let mut text = String::from("naïve café");
+
+        // "ï" and "é" are two bytes each
+        apply(&mut text, &[edit(10, 2, "é!"), edit(0, 6, "NAÏVE")]).unwrap();
+
+        assert_eq!(text, "NAÏVE café!");
+    }
+
+    #[test]
+    fn test_apply_empty_batch() {
+        let mut text = String::from("unchanged");
+        apply(&mut text, &[]).unwrap();
+        assert_eq!(text, "unchanged");
+    }
+
+    #[test]
+    fn test_apply_rejects_bad_batch() {
+        let mut text = String::from("café");
+
+        assert!(apply(&mut text, &[edit(2, 0, "x"), edit(10, 1, "")]).is_err());
+        assert!(apply(&mut text, &[edit(4, 1, "")]).is_err());
+        assert!(apply(&mut text, &[edit(usize::MAX, 2, "")]).is_err());
+
+        // A failed batch leaves the text as it was
+        assert_eq!(text, "café");
+    }
+}
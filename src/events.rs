@@ -0,0 +1,137 @@
+// src/events.rs
+// UI events drained in batches from the bridge's event ring
+
+use crate::qt_ffi;
+
+/// One event read from the ring
+#[derive(Debug, Clone, PartialEq)]
+pub enum UiEvent {
+    NewEntryClicked,
+    EntrySelected(i32),
+    DeleteEntry(i32),
+    BackToList,
+    SearchEntries(String),
+    PageChanged(i32),
+    AddNewPage,
+    PrefetchPage(i32),
+    CheckboxToggled { id: i64, checked: bool },
+}
+
+impl UiEvent {
+    /// Copies a record out of the ring; None for a type this build does
+    /// not know.
+    ///
+    /// # Safety
+    /// `raw` must come from `qt_next_event`, before the next call to it.
+    pub unsafe fn from_raw(raw: &qt_ffi::UiEvent) -> Option<Self> {
+        let text = || {
+            if raw.text.is_null() || raw.text_length <= 0 {
+                return String::new();
+            }
+            let bytes = std::slice::from_raw_parts(raw.text as *const u8, raw.text_length as usize);
+            String::from_utf8_lossy(bytes).into_owned()
+        };
+
+        let event = match raw.event_type {
+            qt_ffi::UI_EVENT_NEW_ENTRY_CLICKED => UiEvent::NewEntryClicked,
+            qt_ffi::UI_EVENT_ENTRY_SELECTED => UiEvent::EntrySelected(raw.value),
+            qt_ffi::UI_EVENT_DELETE_ENTRY => UiEvent::DeleteEntry(raw.value),
+            qt_ffi::UI_EVENT_BACK_TO_LIST => UiEvent::BackToList,
+            qt_ffi::UI_EVENT_SEARCH_ENTRIES => UiEvent::SearchEntries(text()),
+            qt_ffi::UI_EVENT_PAGE_CHANGED => UiEvent::PageChanged(raw.value),
+            qt_ffi::UI_EVENT_ADD_NEW_PAGE => UiEvent::AddNewPage,
+            qt_ffi::UI_EVENT_PREFETCH_PAGE => UiEvent::PrefetchPage(raw.value),
+            qt_ffi::UI_EVENT_CHECKBOX_TOGGLED => UiEvent::CheckboxToggled {
+                id: raw.id,
+                checked: raw.value != 0,
+            },
+            _ => return None,
+        };
+        Some(event)
+    }
+
+    /// Whether `next`, coming right after this event, makes handling this
+    /// one pointless: only the last page flipped to, query typed or entry
+    /// clicked is loaded, and only the last state of a checkbox is stored.
+    fn superseded_by(&self, next: &UiEvent) -> bool {
+        match (self, next) {
+            (UiEvent::EntrySelected(_), UiEvent::EntrySelected(_)) => true,
+            (UiEvent::SearchEntries(_), UiEvent::SearchEntries(_)) => true,
+            (UiEvent::PageChanged(_), UiEvent::PageChanged(_)) => true,
+            (UiEvent::CheckboxToggled { id, .. }, UiEvent::CheckboxToggled { id: next_id, .. }) => id == next_id,
+            _ => false,
+        }
+    }
+}
+
+/// Drops each event that the one right after it supersedes. Only
+/// neighbours are merged, so no event is moved past one of another kind.
+pub fn coalesce(events: Vec<UiEvent>) -> Vec<UiEvent> {
+    let mut result: Vec<UiEvent> = Vec::with_capacity(events.len());
+    for event in events {
+        if let Some(last) = result.last() {
+            if last.superseded_by(&event) {
+                result.pop();
+            }
+        }
+        result.push(event);
+    }
+    result
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_coalesce_runs() {
+        let events = vec![
+            UiEvent::PageChanged(2),
+            UiEvent::PageChanged(3),
+            UiEvent::PageChanged(4),
+            UiEvent::SearchEntries("a".to_string()),
+            UiEvent::SearchEntries("ab".to_string()),
+            UiEvent::EntrySelected(1),
+        ];
+
+        assert_eq!(
+            coalesce(events),
+            vec![
+                UiEvent::PageChanged(4),
+                UiEvent::SearchEntries("ab".to_string()),
+                UiEvent::EntrySelected(1),
+            ]
+        );
+    }
+
+    #[test]
+    fn test_coalesce_keeps_order() {
+        // A page change between two others is not merged across
+        let events = vec![
+            UiEvent::PageChanged(2),
+            UiEvent::PrefetchPage(3),
+            UiEvent::PageChanged(3),
+            UiEvent::AddNewPage,
+            UiEvent::AddNewPage,
+        ];
+
+        assert_eq!(coalesce(events.clone()), events);
+    }
+
+    #[test]
+    fn test_coalesce_checkboxes() {
+        let events = vec![
+            UiEvent::CheckboxToggled { id: 1, checked: true },
+            UiEvent::CheckboxToggled { id: 1, checked: false },
+            UiEvent::CheckboxToggled { id: 2, checked: true },
+        ];
+
+        assert_eq!(
+            coalesce(events),
+            vec![
+                UiEvent::CheckboxToggled { id: 1, checked: false },
+                UiEvent::CheckboxToggled { id: 2, checked: true },
+            ]
+        );
+    }
+}
@@ -1,12 +1,45 @@
 // main.rs - Qt integration version
+mod blobs;
 mod crypto;
 mod db;
+mod delta;
+mod events;
 mod qt_ffi;
+mod thumbnails;
 
 use log::info;
 use std::cell::RefCell;
+use std::collections::HashMap;
 use std::ffi::{CString, CStr};
-use std::os::raw::c_char;
+use std::os::raw::{c_char, c_int, c_longlong, c_uchar};
+use std::sync::mpsc;
+use zeroize::Zeroize;
+
+// Plaintext of the open page or note as last stored, so delta saves only
+// have to patch it
+struct SavedText {
+    revision: i64,
+    text: String,
+}
+
+// Decrypted pages handed to the editor's prefetch, kept until shown so the
+// page turn skips the decrypt
+const MAX_PREFETCHED_PAGES: usize = 8;
+
+// What a worker thread hands back; picked up on the GUI thread by
+// on_worker_finished
+enum WorkerResult {
+    Unlock(Result<crypto::MasterKey, String>),
+    BlobStored {
+        image_id: i64,
+        path: String,
+        stored: Result<blobs::StoredBlob, String>,
+    },
+    OriginalRead {
+        image_id: i64,
+        data: Result<Vec<u8>, String>,
+    },
+}
 
 // Struct to hold current state
 struct AppState {
@@ -14,8 +47,17 @@ struct AppState {
     current_entry_id: Option<i64>,
     current_entry_mode: Option<db::EntryMode>,
     current_page_id: Option<i64>,
+    current_page_number: Option<i32>,
+    saved_text: Option<SavedText>,
+    prefetched: HashMap<i32, String>,
     displayed_entry_ids: Vec<i64>,
     master_key: Option<crypto::MasterKey>,
+    unlocking: bool,
+    thumbnails: thumbnails::ThumbnailStore,
+    blobs: blobs::BlobStore,
+    workers: Vec<std::thread::JoinHandle<()>>,
+    worker_sender: mpsc::Sender<WorkerResult>,
+    worker_results: mpsc::Receiver<WorkerResult>,
     qt_handle: *mut qt_ffi::MainWindowHandle,
 }
 
@@ -46,19 +88,47 @@ fn main() -> Result<(), Box<dyn std::error::Error>> {
         qt_ffi::qt_init(c_args.len() as i32, c_args.as_ptr() as *mut *mut c_char)
     };
 
+    let thumbnail_store = thumbnails::ThumbnailStore::beside(database.path());
+    let blob_store = blobs::BlobStore::beside(database.path());
+    let (worker_sender, worker_results) = mpsc::channel();
     let app_state = Box::into_raw(Box::new(RefCell::new(AppState {
         db: database,
         current_entry_id: None,
         current_entry_mode: None,
         current_page_id: None,
+        current_page_number: None,
+        saved_text: None,
+        prefetched: HashMap::new(),
         displayed_entry_ids: Vec::new(),
         master_key: None,
+        unlocking: false,
+        thumbnails: thumbnail_store,
+        blobs: blob_store,
+        workers: Vec::new(),
+        worker_sender,
+        worker_results,
         qt_handle,
     })));
 
     // Register all callbacks
     setup_callbacks(app_state);
 
+    // Nothing is being inserted yet, so unreferenced blobs can go
+    unsafe {
+        collect_blob_garbage(&(*app_state).borrow());
+    }
+
+    // Autosave idle window, if the user changed it
+    unsafe {
+        let state = (*app_state).borrow();
+        if let Ok(Some(value)) = db::settings::get(state.db.connection(), "autosave_interval_ms") {
+            match value.parse::<i32>() {
+                Ok(msec) => qt_ffi::qt_set_autosave_interval(qt_handle, msec),
+                Err(e) => eprintln!("Invalid autosave interval {:?}: {}", value, e),
+            }
+        }
+    }
+
     // Load initial entries
     unsafe {
         load_entries_to_ui(&(*app_state).borrow());
@@ -67,6 +137,13 @@ fn main() -> Result<(), Box<dyn std::error::Error>> {
     // Run Qt event loop (blocking)
     let _exit_code = unsafe { qt_ffi::qt_exec(qt_handle) };
 
+    // Workers post to the window, so they finish before it goes. Results
+    // they leave behind are dropped with the state.
+    let workers = unsafe { std::mem::take(&mut (*app_state).borrow_mut().workers) };
+    for worker in workers {
+        let _ = worker.join();
+    }
+
     // Cleanup
     unsafe {
         qt_ffi::qt_cleanup(qt_handle);
@@ -170,17 +247,143 @@ fn setup_callbacks(app_state: *mut RefCell<AppState>) {
             state_ptr,
         );
     }
+
+    // Auto-pagination split
+    unsafe {
+        qt_ffi::qt_register_split_page(
+            qt_handle,
+            Some(on_split_page),
+            state_ptr,
+        );
+    }
+
+    // Delta save
+    unsafe {
+        qt_ffi::qt_register_save_delta(
+            qt_handle,
+            Some(on_save_delta),
+            state_ptr,
+        );
+    }
+
+    // Neighbouring pages for the book editor's prefetch
+    unsafe {
+        qt_ffi::qt_register_prefetch_page(
+            qt_handle,
+            Some(on_prefetch_page),
+            state_ptr,
+        );
+    }
+
+    // Note checklist items
+    unsafe {
+        qt_ffi::qt_register_add_checkbox(
+            qt_handle,
+            Some(on_add_checkbox),
+            state_ptr,
+        );
+        qt_ffi::qt_register_checkbox_toggled(
+            qt_handle,
+            Some(on_checkbox_toggled),
+            state_ptr,
+        );
+        qt_ffi::qt_register_checkbox_order(
+            qt_handle,
+            Some(on_checkbox_order),
+            state_ptr,
+        );
+    }
+
+    // Pictures in pages and notes
+    unsafe {
+        qt_ffi::qt_register_image_inserted(
+            qt_handle,
+            Some(on_image_inserted),
+            state_ptr,
+        );
+        qt_ffi::qt_register_image_positions(
+            qt_handle,
+            Some(on_image_positions),
+            state_ptr,
+        );
+        qt_ffi::qt_register_thumbnail_requested(
+            qt_handle,
+            Some(on_thumbnail_requested),
+            state_ptr,
+        );
+        qt_ffi::qt_register_original_requested(
+            qt_handle,
+            Some(on_original_requested),
+            state_ptr,
+        );
+        qt_ffi::qt_register_thumbnails_ready(
+            qt_handle,
+            Some(on_thumbnails_ready),
+            state_ptr,
+        );
+    }
+
+    // Selection, navigation and search events come in batches through the
+    // event ring; the callbacks above still take any that overflow it
+    unsafe {
+        qt_ffi::qt_enable_event_ring(qt_handle, 0, Some(on_events_available), state_ptr);
+    }
 }
 
 // ============ Callback Implementations ============
 
+extern "C" fn on_events_available(user_data: *mut std::ffi::c_void) {
+    let app_state = user_data as *mut RefCell<AppState>;
+    let qt_handle = unsafe { &*app_state }.borrow().qt_handle;
+
+    let mut batch = Vec::new();
+    let mut raw = qt_ffi::UiEvent {
+        event_type: 0,
+        value: 0,
+        id: 0,
+        text: std::ptr::null(),
+        text_length: 0,
+    };
+    while unsafe { qt_ffi::qt_next_event(qt_handle, &mut raw) } != 0 {
+        if let Some(event) = unsafe { events::UiEvent::from_raw(&raw) } {
+            batch.push(event);
+        }
+    }
+
+    let received = batch.len();
+    let batch = events::coalesce(batch);
+    if batch.len() < received {
+        info!("Coalesced {} UI events into {}", received, batch.len());
+    }
+
+    for event in batch {
+        match event {
+            events::UiEvent::NewEntryClicked => on_new_entry_clicked(user_data),
+            events::UiEvent::EntrySelected(index) => on_entry_selected(index, user_data),
+            events::UiEvent::DeleteEntry(index) => on_delete_entry(index, user_data),
+            events::UiEvent::BackToList => on_back_to_list(user_data),
+            events::UiEvent::SearchEntries(query) => search_entries(app_state, &query),
+            events::UiEvent::PageChanged(page) => on_page_changed(page, user_data),
+            events::UiEvent::AddNewPage => on_add_new_page(user_data),
+            events::UiEvent::PrefetchPage(page) => on_prefetch_page(page, user_data),
+            events::UiEvent::CheckboxToggled { id, checked } => {
+                on_checkbox_toggled(id, checked as c_int, user_data)
+            }
+        }
+    }
+}
+
 extern "C" fn on_password_submitted(password: *const c_char, user_data: *mut std::ffi::c_void) {
     let app_state = user_data as *mut RefCell<AppState>;
-    let password_str = unsafe { CStr::from_ptr(password).to_str().unwrap() };
+    let mut password = unsafe { CStr::from_ptr(password) }.to_string_lossy().into_owned();
     
-    info!("Password submitted, deriving key...");
+    let mut state = unsafe { &*app_state }.borrow_mut();
+    if state.unlocking {
+        password.zeroize();
+        return;
+    }
     
-    let mut state = unsafe { &mut *app_state }.borrow_mut();
+    info!("Password submitted, deriving key...");
     
     // Get or create persistent salt
     let salt = match db::settings::get(state.db.connection(), "master_salt") {
@@ -197,10 +400,37 @@ extern "C" fn on_password_submitted(password: *const c_char, user_data: *mut std
         }
     };
     
-    match crypto::derive_key(password_str, &salt) {
+    // Argon2 takes a second or more; the dialog shows it is busy and the
+    // window keeps running until the key comes back through the GUI queue
+    state.unlocking = true;
+    let spawned = spawn_worker(&mut state, app_state, "unlock", move || {
+        let key = crypto::derive_key(&password, &salt);
+        password.zeroize();
+        WorkerResult::Unlock(key)
+    });
+    
+    if let Err(e) = spawned {
+        state.unlocking = false;
+        eprintln!("Failed to start key derivation: {}", e);
+        let error_msg = CString::new(format!("Key derivation failed: {}", e)).unwrap();
+        unsafe {
+            qt_ffi::qt_unlock_finished(state.qt_handle, 0, error_msg.as_ptr());
+        }
+    }
+}
+
+/// A derived key back from the unlock thread
+fn finish_unlock(app_state: *mut RefCell<AppState>, key: Result<crypto::MasterKey, String>) {
+    let mut state = unsafe { &*app_state }.borrow_mut();
+    state.unlocking = false;
+    
+    match key {
         Ok(master_key) => {
             info!("Master key derived successfully!");
             state.master_key = Some(master_key);
+            unsafe {
+                qt_ffi::qt_unlock_finished(state.qt_handle, 1, std::ptr::null());
+            }
             
             // Load entries after successful password
             drop(state);
@@ -212,8 +442,7 @@ extern "C" fn on_password_submitted(password: *const c_char, user_data: *mut std
             eprintln!("Key derivation failed: {}", e);
             let error_msg = CString::new(format!("Key derivation failed: {}", e)).unwrap();
             unsafe {
-                qt_ffi::qt_set_password_error(state.qt_handle, error_msg.as_ptr());
-                qt_ffi::qt_show_password_error(state.qt_handle, 1);
+                qt_ffi::qt_unlock_finished(state.qt_handle, 0, error_msg.as_ptr());
             }
         }
     }
@@ -225,10 +454,21 @@ extern "C" fn on_new_entry_clicked(user_data: *mut std::ffi::c_void) {
     // Mode dialog will handle this
 }
 
-extern "C" fn on_mode_selected(mode: *const c_char, title: *const c_char, user_data: *mut std::ffi::c_void) {
+extern "C" fn on_mode_selected(
+    mode: *const c_char,
+    mode_length: c_longlong,
+    title: *const c_char,
+    title_length: c_longlong,
+    user_data: *mut std::ffi::c_void,
+) {
     let app_state = user_data as *mut RefCell<AppState>;
-    let mode_str = unsafe { CStr::from_ptr(mode).to_str().unwrap() };
-    let title_str = unsafe { CStr::from_ptr(title).to_str().unwrap() };
+    let (mode_str, title_str) = match unsafe { (callback_str(mode, mode_length), callback_str(title, title_length)) } {
+        (Ok(mode), Ok(title)) => (mode, title),
+        _ => {
+            eprintln!("New entry is not valid UTF-8");
+            return;
+        }
+    };
     
     info!("Creating entry: {} (mode: {})", title_str, mode_str);
     
@@ -317,18 +557,32 @@ extern "C" fn on_entry_selected(index: i32, user_data: *mut std::ffi::c_void) {
     
     let mut state = state_ref.borrow_mut();
     
+    // Title, page count, content and word count are shown in one repaint
+    unsafe {
+        qt_ffi::qt_batch_begin(state.qt_handle);
+    }
+
     match db::entries::get_by_id(state.db.connection(), entry_id) {
         Ok(entry) => {
             state.current_entry_id = Some(entry_id);
             state.current_entry_mode = Some(entry.mode.clone());
+            state.current_page_number = None;
+            state.saved_text = None;
+            state.prefetched.clear();
             
-            let title_cstr = CString::new(entry.title.clone()).unwrap();
             unsafe {
-                qt_ffi::qt_set_current_entry_title(state.qt_handle, title_cstr.as_ptr());
+                qt_ffi::qt_set_current_entry_title_utf8(
+                    state.qt_handle,
+                    entry.title.as_ptr() as *const c_char,
+                    entry.title.len() as c_longlong,
+                );
             }
             
             match entry.mode {
                 db::EntryMode::Book => {
+                    unsafe {
+                        qt_ffi::qt_show_book_editor(state.qt_handle);
+                    }
                     if let Ok(pages) = db::pages::get_by_entry(state.db.connection(), entry_id) {
                         let total = pages.len() as i32;
                         unsafe {
@@ -338,23 +592,40 @@ extern "C" fn on_entry_selected(index: i32, user_data: *mut std::ffi::c_void) {
                         
                         if let Some(first_page) = pages.first() {
                             state.current_page_id = first_page.id;
+                            state.current_page_number = Some(first_page.page_number);
                             if let Ok(plaintext) = crypto::decrypt(&first_page.content_encrypted, &master_key) {
-                                let content_cstr = CString::new(plaintext.clone()).unwrap();
                                 let word_count = count_words(&plaintext);
                                 unsafe {
-                                    qt_ffi::qt_set_current_content(state.qt_handle, content_cstr.as_ptr());
+                                    qt_ffi::qt_set_current_content_utf8(
+                                        state.qt_handle,
+                                        plaintext.as_ptr() as *const c_char,
+                                        plaintext.len() as c_longlong,
+                                    );
                                     qt_ffi::qt_set_word_count(state.qt_handle, word_count);
                                 }
+                                state.saved_text = Some(SavedText { revision: 0, text: plaintext });
+                                load_images_to_ui(&state, entry_id, first_page.id);
                             }
                         }
                     }
                 }
                 db::EntryMode::Note => {
+                    unsafe {
+                        qt_ffi::qt_show_note_editor(state.qt_handle);
+                    }
                     if let Ok(note) = db::notes::get_by_entry(state.db.connection(), entry_id) {
                         if let Ok(plaintext) = crypto::decrypt(&note.content_encrypted, &master_key) {
-                            let content_cstr = CString::new(plaintext).unwrap();
                             unsafe {
-                                qt_ffi::qt_set_current_content(state.qt_handle, content_cstr.as_ptr());
+                                qt_ffi::qt_set_current_content_utf8(
+                                    state.qt_handle,
+                                    plaintext.as_ptr() as *const c_char,
+                                    plaintext.len() as c_longlong,
+                                );
+                            }
+                            state.saved_text = Some(SavedText { revision: 0, text: plaintext });
+                            load_images_to_ui(&state, entry_id, None);
+                            if let Some(note_id) = note.id {
+                                load_checkboxes_to_ui(&state, note_id);
                             }
                         }
                     }
@@ -365,6 +636,10 @@ extern "C" fn on_entry_selected(index: i32, user_data: *mut std::ffi::c_void) {
             eprintln!("Failed to get entry: {}", e);
         }
     }
+
+    unsafe {
+        qt_ffi::qt_batch_commit(state.qt_handle);
+    }
 }
 
 extern "C" fn on_delete_entry(index: i32, user_data: *mut std::ffi::c_void) {
@@ -395,14 +670,33 @@ extern "C" fn on_delete_entry(index: i32, user_data: *mut std::ffi::c_void) {
     }
 }
 
-extern "C" fn on_save_content(content: *const c_char, user_data: *mut std::ffi::c_void) {
-    let _app_state = user_data as *mut RefCell<AppState>;
-    let _content_str = unsafe { CStr::from_ptr(content).to_str().unwrap() };
-    
-    info!("Saving content...");
-    
-    // Implementation similar to your original save_content callback
-    // ... (truncated for brevity, follows same pattern as original)
+extern "C" fn on_save_content(
+    content: *const c_char,
+    length: c_longlong,
+    page: c_int,
+    user_data: *mut std::ffi::c_void,
+) {
+    let app_state = user_data as *mut RefCell<AppState>;
+    let content_str = match unsafe { callback_str(content, length) } {
+        Ok(text) => text,
+        Err(e) => {
+            eprintln!("Save content is not valid UTF-8: {}", e);
+            return;
+        }
+    };
+
+    info!("Saving content ({} bytes)...", content_str.len());
+
+    let mut state = unsafe { &*app_state }.borrow_mut();
+
+    // Full saves carry no revision, so the next delta save starts over
+    if is_open_text(&state, page) {
+        state.saved_text = None;
+    }
+    state.prefetched.remove(&page);
+    if let Err(e) = save_text(&state, page, content_str) {
+        eprintln!("Failed to save content: {}", e);
+    }
 }
 
 extern "C" fn on_back_to_list(user_data: *mut std::ffi::c_void) {
@@ -413,21 +707,29 @@ extern "C" fn on_back_to_list(user_data: *mut std::ffi::c_void) {
     state.current_entry_id = None;
     state.current_entry_mode = None;
     state.current_page_id = None;
+    state.current_page_number = None;
+    state.saved_text = None;
+    state.prefetched.clear();
 }
 
 extern "C" fn on_search_entries(query: *const c_char, user_data: *mut std::ffi::c_void) {
-    let _app_state = user_data as *mut RefCell<AppState>;
-    let _query_str = unsafe { CStr::from_ptr(query).to_str().unwrap() };
-    
+    let query = unsafe { CStr::from_ptr(query) }.to_string_lossy();
+    search_entries(user_data as *mut RefCell<AppState>, &query);
+}
+
+fn search_entries(_app_state: *mut RefCell<AppState>, _query: &str) {
     info!("Searching...");
     
     // Implementation follows your original search logic
     // ... (truncated for brevity)
 }
 
-extern "C" fn on_page_changed(_page: i32, _user_data: *mut std::ffi::c_void) {
-    info!("Page changed");
-    // Implementation follows your original page navigation
+extern "C" fn on_page_changed(page: i32, user_data: *mut std::ffi::c_void) {
+    let app_state = user_data as *mut RefCell<AppState>;
+    info!("Page changed to {}", page);
+
+    let mut state = unsafe { &mut *app_state }.borrow_mut();
+    load_page_to_ui(&mut state, page);
 }
 
 extern "C" fn on_add_new_page(_user_data: *mut std::ffi::c_void) {
@@ -435,6 +737,613 @@ extern "C" fn on_add_new_page(_user_data: *mut std::ffi::c_void) {
     // Implementation follows your original add page logic
 }
 
+extern "C" fn on_split_page(
+    page: i32,
+    keep: *const c_char,
+    keep_length: c_longlong,
+    overflow: *const c_char,
+    overflow_length: c_longlong,
+    user_data: *mut std::ffi::c_void,
+) -> c_int {
+    let app_state = user_data as *mut RefCell<AppState>;
+    let (keep_str, overflow_str) = match unsafe { (callback_str(keep, keep_length), callback_str(overflow, overflow_length)) } {
+        (Ok(keep), Ok(overflow)) => (keep, overflow),
+        _ => {
+            eprintln!("Split page text is not valid UTF-8");
+            return 0;
+        }
+    };
+
+    info!("Splitting page {} ({} bytes overflow)", page, overflow_str.len());
+
+    let mut state = unsafe { &*app_state }.borrow_mut();
+
+    let (entry_id, master_key) = match (state.current_entry_id, &state.master_key) {
+        (Some(id), Some(key)) => (id, key.clone()),
+        _ => {
+            eprintln!("No open entry to paginate!");
+            return 0;
+        }
+    };
+
+    // The editor's revision of the kept text is unknown here; its next
+    // delta save is refused and resent whole
+    state.saved_text = None;
+
+    // The next page gains the overflow
+    state.prefetched.clear();
+
+    match split_page(&state.db, entry_id, page, keep_str, overflow_str, &master_key) {
+        Ok(total) => {
+            unsafe {
+                qt_ffi::qt_set_total_pages(state.qt_handle, total);
+            }
+            1
+        }
+        Err(e) => {
+            eprintln!("Failed to split page: {}", e);
+            0
+        }
+    }
+}
+
+extern "C" fn on_save_delta(
+    base_revision: i64,
+    revision: i64,
+    ops: *const qt_ffi::SaveDeltaOp,
+    count: i32,
+    page: i32,
+    user_data: *mut std::ffi::c_void,
+) -> i32 {
+    let app_state = user_data as *mut RefCell<AppState>;
+    let mut state = unsafe { &*app_state }.borrow_mut();
+
+    // saved_text is the open page's; revisions of other pages, which also
+    // count from 0, are never applied to it
+    let is_open = is_open_text(&state, page);
+
+    if count <= 0 && base_revision >= 0 {
+        match &state.saved_text {
+            Some(saved) if is_open && saved.revision == base_revision => {
+                info!("Nothing to save at revision {}", revision);
+                return 1;
+            }
+            _ => return 0,
+        }
+    }
+
+    let raw_ops: &[qt_ffi::SaveDeltaOp] = if count > 0 {
+        unsafe { std::slice::from_raw_parts(ops, count as usize) }
+    } else {
+        &[]
+    };
+    let mut edits = Vec::with_capacity(raw_ops.len());
+    for op in raw_ops {
+        let bytes: &[u8] = if op.insert_length > 0 {
+            unsafe { std::slice::from_raw_parts(op.insert as *const u8, op.insert_length as usize) }
+        } else {
+            &[]
+        };
+        let insert = match std::str::from_utf8(bytes) {
+            Ok(insert) => insert,
+            Err(e) => {
+                eprintln!("Delta save carries invalid UTF-8: {}", e);
+                return 0;
+            }
+        };
+        edits.push(delta::Edit {
+            offset: op.offset.max(0) as usize,
+            delete: op.delete_length.max(0) as usize,
+            insert,
+        });
+    }
+
+    // A base of -1 carries the whole text
+    let mut text = if base_revision < 0 {
+        String::new()
+    } else {
+        match &state.saved_text {
+            Some(saved) if is_open && saved.revision == base_revision => saved.text.clone(),
+            _ => {
+                info!("Delta base {} is stale, asking for the whole text", base_revision);
+                return 0;
+            }
+        }
+    };
+
+    if let Err(e) = delta::apply(&mut text, &edits) {
+        eprintln!("Failed to apply delta: {}", e);
+        return 0;
+    }
+
+    info!("Saving revision {} of page {} ({} ops)", revision, page, edits.len());
+    state.prefetched.remove(&page);
+
+    match save_text(&state, page, &text) {
+        Ok(()) => {
+            if is_open {
+                state.saved_text = Some(SavedText { revision, text });
+            }
+            1
+        }
+        Err(e) => {
+            eprintln!("Failed to save content: {}", e);
+            0
+        }
+    }
+}
+
+extern "C" fn on_add_checkbox(index: c_int, user_data: *mut std::ffi::c_void) -> c_longlong {
+    let app_state = user_data as *mut RefCell<AppState>;
+    let state = unsafe { &*app_state }.borrow();
+
+    let note_id = match current_note_id(&state) {
+        Some(id) => id,
+        None => {
+            eprintln!("No open note for the checkbox!");
+            return -1;
+        }
+    };
+
+    match db::checkboxes::create(state.db.connection(), note_id, index.max(0)) {
+        Ok(id) => {
+            info!("Added checkbox {} at {}", id, index);
+            id
+        }
+        Err(e) => {
+            eprintln!("Failed to add checkbox: {}", e);
+            -1
+        }
+    }
+}
+
+extern "C" fn on_checkbox_toggled(id: c_longlong, checked: c_int, user_data: *mut std::ffi::c_void) {
+    let app_state = user_data as *mut RefCell<AppState>;
+    let state = unsafe { &*app_state }.borrow();
+
+    if let Err(e) = db::checkboxes::set_checked(state.db.connection(), id, checked != 0) {
+        eprintln!("Failed to update checkbox {}: {}", id, e);
+    }
+}
+
+extern "C" fn on_checkbox_order(
+    ids: *const c_longlong,
+    positions: *const c_int,
+    count: c_int,
+    user_data: *mut std::ffi::c_void,
+) {
+    let app_state = user_data as *mut RefCell<AppState>;
+    let state = unsafe { &*app_state }.borrow();
+
+    let (note_id, master_key) = match (current_note_id(&state), &state.master_key) {
+        (Some(id), Some(key)) => (id, key),
+        _ => return,
+    };
+
+    let (ids, positions): (&[c_longlong], &[c_int]) = if count > 0 {
+        unsafe {
+            (
+                std::slice::from_raw_parts(ids, count as usize),
+                std::slice::from_raw_parts(positions, count as usize),
+            )
+        }
+    } else {
+        (&[], &[])
+    };
+
+    // Labels are only refreshed when the stored text is known and lines up
+    // with the items; otherwise the rows just follow the order
+    let labels = match &state.saved_text {
+        Some(saved) => checkbox_labels(&saved.text, positions).unwrap_or_default(),
+        None => Vec::new(),
+    };
+    let mut items = Vec::with_capacity(ids.len());
+    for (index, &id) in ids.iter().enumerate() {
+        let text = if labels.len() == ids.len() {
+            match crypto::encrypt(labels[index], master_key) {
+                Ok(encrypted) => Some(encrypted),
+                Err(e) => {
+                    eprintln!("Failed to encrypt checkbox label: {}", e);
+                    None
+                }
+            }
+        } else {
+            None
+        };
+        items.push((id, text));
+    }
+
+    if let Err(e) = db::checkboxes::sync(state.db.connection(), note_id, &items) {
+        eprintln!("Failed to store checkboxes: {}", e);
+    }
+
+    if let Some(entry_id) = state.current_entry_id {
+        if let Err(e) = db::notes::set_has_checkboxes(state.db.connection(), entry_id, !ids.is_empty()) {
+            eprintln!("Failed to update note: {}", e);
+        }
+    }
+}
+
+extern "C" fn on_image_inserted(
+    path: *const c_char,
+    hash: *const c_char,
+    position: c_int,
+    width: c_int,
+    height: c_int,
+    user_data: *mut std::ffi::c_void,
+) -> c_longlong {
+    let app_state = user_data as *mut RefCell<AppState>;
+    let mut state = unsafe { &*app_state }.borrow_mut();
+
+    let (entry_id, page_id) = match current_image_owner(&state) {
+        Some(owner) => owner,
+        None => {
+            eprintln!("No open page or note for the image!");
+            return -1;
+        }
+    };
+
+    let path = unsafe { CStr::from_ptr(path) }.to_string_lossy().into_owned();
+    let hash = unsafe { CStr::from_ptr(hash) }.to_string_lossy().into_owned();
+    let mut image = db::Image::new(entry_id, page_id, path.clone(), position, width, height);
+    if thumbnails::ThumbnailStore::is_valid_hash(&hash) {
+        image.thumbnail_path = Some(hash);
+    }
+    let id = match db::images::create(state.db.connection(), &image) {
+        Ok(id) => id,
+        Err(e) => {
+            eprintln!("Failed to add image: {}", e);
+            return -1;
+        }
+    };
+    info!("Added image {} at {}", id, position);
+
+    // Hashing and encrypting a large photo takes a while; the row is given
+    // its blob once the copy is stored
+    if let Some(key) = state.master_key.clone() {
+        let store = state.blobs.clone();
+        let spawned = spawn_worker(&mut state, app_state, "blob-store", move || {
+            let stored = store
+                .store_file(std::path::Path::new(&path), &key)
+                .map_err(|e| e.to_string());
+            WorkerResult::BlobStored { image_id: id, path, stored }
+        });
+        if let Err(e) = spawned {
+            eprintln!("Failed to start storing image {}: {}", id, e);
+        }
+    }
+    id
+}
+
+/// Run `job` on its own thread and hand the result to on_worker_finished
+fn spawn_worker<F>(
+    state: &mut AppState,
+    app_state: *mut RefCell<AppState>,
+    name: &str,
+    job: F,
+) -> std::io::Result<()>
+where
+    F: FnOnce() -> WorkerResult + Send + 'static,
+{
+    state.workers.retain(|worker| !worker.is_finished());
+
+    let sender = state.worker_sender.clone();
+    let handle = qt_ffi::SendHandle(state.qt_handle);
+    let state_addr = app_state as usize;
+    let worker = std::thread::Builder::new().name(name.to_string()).spawn(move || {
+        let handle = handle;
+        if sender.send(job()).is_ok() {
+            unsafe {
+                qt_ffi::qt_post_to_gui(handle.0, Some(on_worker_finished), state_addr as *mut std::ffi::c_void);
+            }
+        }
+    })?;
+    state.workers.push(worker);
+    Ok(())
+}
+
+extern "C" fn on_worker_finished(user_data: *mut std::ffi::c_void) {
+    let app_state = user_data as *mut RefCell<AppState>;
+
+    // One post may find several results, or none when an earlier one took it
+    loop {
+        let result = match unsafe { &*app_state }.borrow().worker_results.try_recv() {
+            Ok(result) => result,
+            Err(_) => return,
+        };
+
+        match result {
+            WorkerResult::Unlock(key) => finish_unlock(app_state, key),
+            WorkerResult::BlobStored { image_id, path, stored } => {
+                finish_blob(&unsafe { &*app_state }.borrow(), image_id, &path, stored)
+            }
+            WorkerResult::OriginalRead { image_id, data } => {
+                let state = unsafe { &*app_state }.borrow();
+                let data = data.unwrap_or_else(|e| {
+                    eprintln!("Failed to read the original of image {}: {}", image_id, e);
+                    Vec::new()
+                });
+                unsafe {
+                    qt_ffi::qt_provide_original(state.qt_handle, image_id, data.as_ptr(), data.len() as c_longlong);
+                }
+            }
+        }
+    }
+}
+
+/// Record an inserted file's encrypted copy; the same content pasted again
+/// only gains a reference
+fn finish_blob(state: &AppState, image_id: i64, path: &str, stored: Result<blobs::StoredBlob, String>) {
+    let stored = match stored {
+        Ok(stored) => stored,
+        Err(e) => {
+            eprintln!("Failed to store {} in the blob store: {}", path, e);
+            return;
+        }
+    };
+
+    // A row deleted meanwhile leaves the blob unreferenced, for the next
+    // collection
+    let conn = state.db.connection();
+    if let Err(e) = db::blobs::add(conn, &stored.hash, stored.size as i64)
+        .and_then(|_| db::images::set_blob(conn, image_id, &stored.hash))
+    {
+        eprintln!("Failed to record blob {}: {}", stored.hash, e);
+        return;
+    }
+
+    if stored.written {
+        info!("Stored blob {} ({} bytes)", stored.hash, stored.size);
+    } else {
+        info!("Reusing blob {}", stored.hash);
+    }
+}
+
+/// Delete blobs no image refers to, and blob files left without a row
+fn collect_blob_garbage(state: &AppState) {
+    let conn = state.db.connection();
+    let unreferenced = match db::blobs::unreferenced(conn) {
+        Ok(hashes) => hashes,
+        Err(e) => {
+            eprintln!("Failed to list unreferenced blobs: {}", e);
+            return;
+        }
+    };
+
+    // The row goes first: a crash in between leaves a file the sweep below
+    // removes next time, never a row without its file
+    for hash in unreferenced {
+        match db::blobs::remove_unreferenced(conn, &hash) {
+            Ok(true) => {
+                if let Err(e) = state.blobs.remove(&hash) {
+                    eprintln!("Failed to delete blob {}: {}", hash, e);
+                }
+            }
+            Ok(false) => {}
+            Err(e) => eprintln!("Failed to drop blob {}: {}", hash, e),
+        }
+    }
+
+    let known: std::collections::HashSet<String> = match db::blobs::all_hashes(conn) {
+        Ok(hashes) => hashes.into_iter().collect(),
+        Err(_) => return,
+    };
+    match state.blobs.stored_hashes() {
+        Ok(stored) => {
+            for hash in stored.iter().filter(|hash| !known.contains(*hash)) {
+                info!("Removing orphaned blob {}", hash);
+                let _ = state.blobs.remove(hash);
+            }
+        }
+        Err(e) => eprintln!("Failed to list blob files: {}", e),
+    }
+}
+
+extern "C" fn on_image_positions(
+    ids: *const c_longlong,
+    positions: *const c_int,
+    count: c_int,
+    user_data: *mut std::ffi::c_void,
+) {
+    let app_state = user_data as *mut RefCell<AppState>;
+    let state = unsafe { &*app_state }.borrow();
+
+    let (entry_id, page_id) = match current_image_owner(&state) {
+        Some(owner) => owner,
+        None => return,
+    };
+
+    let items: Vec<(i64, i32)> = if count > 0 {
+        let ids = unsafe { std::slice::from_raw_parts(ids, count as usize) };
+        let positions = unsafe { std::slice::from_raw_parts(positions, count as usize) };
+        ids.iter().copied().zip(positions.iter().copied()).collect()
+    } else {
+        Vec::new()
+    };
+
+    if let Err(e) = db::images::sync(state.db.connection(), entry_id, page_id, &items) {
+        eprintln!("Failed to store images: {}", e);
+    }
+}
+
+extern "C" fn on_thumbnail_requested(hash: *const c_char, size: c_int, user_data: *mut std::ffi::c_void) {
+    let app_state = user_data as *mut RefCell<AppState>;
+    let state = unsafe { &*app_state }.borrow();
+
+    // Anything but the thumbnail itself is answered with nothing, which
+    // makes the editor fall back to the original file
+    let data = match (&state.master_key, unsafe { CStr::from_ptr(hash) }.to_str()) {
+        (Some(key), Ok(hash_str)) => match state.thumbnails.load(hash_str, size, key) {
+            Ok(data) => data.unwrap_or_default(),
+            Err(e) => {
+                eprintln!("Failed to load thumbnail {}-{}: {}", hash_str, size, e);
+                Vec::new()
+            }
+        },
+        _ => Vec::new(),
+    };
+
+    unsafe {
+        qt_ffi::qt_provide_thumbnail(state.qt_handle, hash, size, data.as_ptr(), data.len() as c_longlong);
+    }
+}
+
+extern "C" fn on_original_requested(image_id: c_longlong, user_data: *mut std::ffi::c_void) {
+    let app_state = user_data as *mut RefCell<AppState>;
+    let mut state = unsafe { &*app_state }.borrow_mut();
+
+    // The image's file is gone; its copy in the blob store is decrypted in
+    // the background. Without one the frame stays empty.
+    let hash = match db::images::blob_hash(state.db.connection(), image_id) {
+        Ok(hash) => hash,
+        Err(e) => {
+            eprintln!("Failed to look up the blob of image {}: {}", image_id, e);
+            None
+        }
+    };
+    let (hash, key) = match (hash, state.master_key.clone()) {
+        (Some(hash), Some(key)) => (hash, key),
+        _ => {
+            unsafe {
+                qt_ffi::qt_provide_original(state.qt_handle, image_id, std::ptr::null(), 0);
+            }
+            return;
+        }
+    };
+
+    let store = state.blobs.clone();
+    let spawned = spawn_worker(&mut state, app_state, "blob-read", move || {
+        let mut data = Vec::new();
+        let data = store
+            .read_to(&hash, &mut data, &key)
+            .map(|_| data)
+            .map_err(|e| e.to_string());
+        WorkerResult::OriginalRead { image_id, data }
+    });
+    if let Err(e) = spawned {
+        eprintln!("Failed to start reading image {}: {}", image_id, e);
+        unsafe {
+            qt_ffi::qt_provide_original(state.qt_handle, image_id, std::ptr::null(), 0);
+        }
+    }
+}
+
+extern "C" fn on_thumbnails_ready(
+    image_id: c_longlong,
+    hash: *const c_char,
+    sizes: *const c_int,
+    data: *const *const c_uchar,
+    lengths: *const c_longlong,
+    count: c_int,
+    user_data: *mut std::ffi::c_void,
+) {
+    let app_state = user_data as *mut RefCell<AppState>;
+    let state = unsafe { &*app_state }.borrow();
+
+    let master_key = match &state.master_key {
+        Some(key) => key,
+        None => return,
+    };
+    let hash = match unsafe { CStr::from_ptr(hash) }.to_str() {
+        Ok(hash) if thumbnails::ThumbnailStore::is_valid_hash(hash) => hash,
+        _ => {
+            eprintln!("Ignoring thumbnails with an invalid hash");
+            return;
+        }
+    };
+
+    let count = count.max(0) as usize;
+    let (sizes, data, lengths) = if count > 0 {
+        unsafe {
+            (
+                std::slice::from_raw_parts(sizes, count),
+                std::slice::from_raw_parts(data, count),
+                std::slice::from_raw_parts(lengths, count),
+            )
+        }
+    } else {
+        (&[][..], &[][..], &[][..])
+    };
+
+    for i in 0..count {
+        if data[i].is_null() || lengths[i] <= 0 {
+            continue;
+        }
+        let bytes = unsafe { std::slice::from_raw_parts(data[i], lengths[i] as usize) };
+        if let Err(e) = state.thumbnails.store(hash, sizes[i], bytes, master_key) {
+            eprintln!("Failed to store thumbnail {}-{}: {}", hash, sizes[i], e);
+            return;
+        }
+    }
+
+    if image_id >= 0 {
+        if let Err(e) = db::images::set_thumbnail(state.db.connection(), image_id, hash) {
+            eprintln!("Failed to record thumbnails of image {}: {}", image_id, e);
+        }
+    }
+}
+
+extern "C" fn on_prefetch_page(page: i32, user_data: *mut std::ffi::c_void) {
+    let app_state = user_data as *mut RefCell<AppState>;
+    let mut state = unsafe { &*app_state }.borrow_mut();
+
+    let (entry_id, master_key) = match (state.current_entry_id, &state.master_key) {
+        (Some(id), Some(key)) if state.current_entry_mode == Some(db::EntryMode::Book) => (id, key.clone()),
+        _ => return,
+    };
+
+    // The open page is the editor's; it is sent as last saved and never
+    // cached, so a page turn cannot bring back text from before an edit
+    let is_current = state.current_page_number == Some(page);
+    let cached = if is_current {
+        state.saved_text.as_ref().map(|saved| saved.text.clone())
+    } else {
+        state.prefetched.get(&page).cloned()
+    };
+
+    let plaintext = match cached {
+        Some(text) => text,
+        None => {
+            // Pages past the end are simply not there yet
+            let page_row = match db::pages::get_by_number(state.db.connection(), entry_id, page) {
+                Ok(Some(page_row)) => page_row,
+                Ok(None) => return,
+                Err(e) => {
+                    eprintln!("Failed to prefetch page {}: {}", page, e);
+                    return;
+                }
+            };
+            match crypto::decrypt(&page_row.content_encrypted, &master_key) {
+                Ok(plaintext) => plaintext,
+                Err(e) => {
+                    eprintln!("Failed to decrypt page {}: {}", page, e);
+                    return;
+                }
+            }
+        }
+    };
+
+    info!("Prefetched page {}", page);
+
+    unsafe {
+        qt_ffi::qt_provide_page_content_utf8(
+            state.qt_handle,
+            page,
+            plaintext.as_ptr() as *const c_char,
+            plaintext.len() as c_longlong,
+        );
+    }
+
+    if is_current {
+        return;
+    }
+    if state.prefetched.len() >= MAX_PREFETCHED_PAGES && !state.prefetched.contains_key(&page) {
+        state.prefetched.clear();
+    }
+    state.prefetched.insert(page, plaintext);
+}
+
+
 // ============ Helper Functions ============
 
 fn load_entries_to_ui(state: &AppState) {
@@ -442,26 +1351,31 @@ fn load_entries_to_ui(state: &AppState) {
         Ok(entries) => {
             info!("Loaded {} entries from database", entries.len());
             
-            let entry_strings: Vec<CString> = entries
+            let entry_strings: Vec<String> = entries
                 .iter()
                 .map(|entry| {
                     let icon = match entry.mode {
                         db::EntryMode::Book => "📚",
                         db::EntryMode::Note => "📝",
                     };
-                    CString::new(format!("{} {}", icon, entry.title)).unwrap()
+                    format!("{} {}", icon, entry.title)
                 })
                 .collect();
             
             let c_strings: Vec<*const c_char> = entry_strings
                 .iter()
-                .map(|s| s.as_ptr())
+                .map(|s| s.as_ptr() as *const c_char)
+                .collect();
+            let lengths: Vec<c_longlong> = entry_strings
+                .iter()
+                .map(|s| s.len() as c_longlong)
                 .collect();
             
             unsafe {
-                qt_ffi::qt_set_entry_list(
+                qt_ffi::qt_set_entry_list_utf8(
                     state.qt_handle,
                     c_strings.as_ptr(),
+                    lengths.as_ptr(),
                     c_strings.len() as i32,
                 );
             }
@@ -472,6 +1386,313 @@ fn load_entries_to_ui(state: &AppState) {
     }
 }
 
+fn load_checkboxes_to_ui(state: &AppState, note_id: i64) {
+    let checkboxes = match db::checkboxes::get_by_note(state.db.connection(), note_id) {
+        Ok(checkboxes) => checkboxes,
+        Err(e) => {
+            eprintln!("Failed to load checkboxes: {}", e);
+            return;
+        }
+    };
+
+    let ids: Vec<c_longlong> = checkboxes.iter().filter_map(|checkbox| checkbox.id).collect();
+    let checked: Vec<c_int> = checkboxes
+        .iter()
+        .filter(|checkbox| checkbox.id.is_some())
+        .map(|checkbox| checkbox.is_checked as c_int)
+        .collect();
+
+    unsafe {
+        qt_ffi::qt_set_note_checkboxes(state.qt_handle, ids.as_ptr(), checked.as_ptr(), ids.len() as c_int);
+    }
+}
+
+fn load_images_to_ui(state: &AppState, entry_id: i64, page_id: Option<i64>) {
+    let images = match db::images::get_by_owner(state.db.connection(), entry_id, page_id) {
+        Ok(images) => images,
+        Err(e) => {
+            eprintln!("Failed to load images: {}", e);
+            return;
+        }
+    };
+    let images: Vec<&db::Image> = images.iter().filter(|image| image.id.is_some()).collect();
+
+    let ids: Vec<c_longlong> = images.iter().filter_map(|image| image.id).collect();
+    let paths: Vec<CString> = images
+        .iter()
+        .map(|image| CString::new(image.file_path.replace('\0', "")).unwrap())
+        .collect();
+    let path_ptrs: Vec<*const c_char> = paths.iter().map(|path| path.as_ptr()).collect();
+
+    // Images without thumbnails yet are read from their file
+    let hashes: Vec<Option<CString>> = images
+        .iter()
+        .map(|image| {
+            image
+                .thumbnail_path
+                .as_deref()
+                .filter(|hash| thumbnails::ThumbnailStore::is_valid_hash(hash))
+                .map(|hash| CString::new(hash).unwrap())
+        })
+        .collect();
+    let hash_ptrs: Vec<*const c_char> = hashes
+        .iter()
+        .map(|hash| hash.as_ref().map_or(std::ptr::null(), |hash| hash.as_ptr()))
+        .collect();
+    let positions: Vec<c_int> = images.iter().map(|image| image.position_in_content).collect();
+    let widths: Vec<c_int> = images.iter().map(|image| image.width).collect();
+    let heights: Vec<c_int> = images.iter().map(|image| image.height).collect();
+
+    unsafe {
+        qt_ffi::qt_set_images(
+            state.qt_handle,
+            ids.as_ptr(),
+            path_ptrs.as_ptr(),
+            hash_ptrs.as_ptr(),
+            positions.as_ptr(),
+            widths.as_ptr(),
+            heights.as_ptr(),
+            ids.len() as c_int,
+        );
+    }
+}
+
+// Images belong to the open page in book mode and to the entry in note mode
+fn current_image_owner(state: &AppState) -> Option<(i64, Option<i64>)> {
+    match (state.current_entry_id, &state.current_entry_mode) {
+        (Some(entry_id), Some(db::EntryMode::Book)) => state.current_page_id.map(|page_id| (entry_id, Some(page_id))),
+        (Some(entry_id), Some(db::EntryMode::Note)) => Some((entry_id, None)),
+        _ => None,
+    }
+}
+
+fn current_note_id(state: &AppState) -> Option<i64> {
+    match (state.current_entry_id, &state.current_entry_mode) {
+        (Some(entry_id), Some(db::EntryMode::Note)) => db::notes::get_by_entry(state.db.connection(), entry_id)
+            .ok()
+            .and_then(|note| note.id),
+        _ => None,
+    }
+}
+
+// Label of each checklist item at the given UTF-16 offsets: the rest of its
+// line after the U+FFFC. Images use the same character, so the offsets come
+// from the editor; None if one does not land on a marker.
+fn checkbox_labels<'a>(text: &'a str, positions: &[c_int]) -> Option<Vec<&'a str>> {
+    let mut starts = Vec::with_capacity(positions.len());
+    let mut wanted = positions.iter().copied().peekable();
+    let mut offset = 0;
+    for (start, c) in text.char_indices() {
+        while wanted.peek() == Some(&offset) {
+            if c != '\u{FFFC}' {
+                return None;
+            }
+            starts.push(start + c.len_utf8());
+            wanted.next();
+        }
+        offset += c.len_utf16() as c_int;
+    }
+    if wanted.next().is_some() {
+        return None;
+    }
+
+    Some(
+        starts
+            .into_iter()
+            .map(|start| {
+                let rest = &text[start..];
+                let end = rest.find(|c| c == '\n' || c == '\u{FFFC}').unwrap_or(rest.len());
+                rest[..end].trim()
+            })
+            .collect(),
+    )
+}
+
+fn load_page_to_ui(state: &mut AppState, page_number: i32) {
+    let (entry_id, master_key) = match (state.current_entry_id, &state.master_key) {
+        (Some(id), Some(key)) => (id, key.clone()),
+        _ => {
+            eprintln!("No open entry to load page from!");
+            return;
+        }
+    };
+
+    match db::pages::get_by_number(state.db.connection(), entry_id, page_number) {
+        Ok(Some(page)) => {
+            state.current_page_id = page.id;
+            state.current_page_number = Some(page_number);
+            state.saved_text = None;
+
+            // Saves go through saved_text from here on, so the copy is dropped
+            let decrypted = match state.prefetched.remove(&page_number) {
+                Some(plaintext) => Ok(plaintext),
+                None => crypto::decrypt(&page.content_encrypted, &master_key),
+            };
+            match decrypted {
+                Ok(plaintext) => {
+                    let word_count = count_words(&plaintext);
+                    unsafe {
+                        qt_ffi::qt_batch_begin(state.qt_handle);
+                        qt_ffi::qt_set_current_page(state.qt_handle, page_number);
+                        qt_ffi::qt_set_current_content_utf8(
+                            state.qt_handle,
+                            plaintext.as_ptr() as *const c_char,
+                            plaintext.len() as c_longlong,
+                        );
+                        qt_ffi::qt_set_word_count(state.qt_handle, word_count);
+                    }
+                    state.saved_text = Some(SavedText { revision: 0, text: plaintext });
+                    load_images_to_ui(state, entry_id, page.id);
+                    unsafe {
+                        qt_ffi::qt_batch_commit(state.qt_handle);
+                    }
+                }
+                Err(e) => {
+                    eprintln!("Failed to decrypt page {}: {}", page_number, e);
+                }
+            }
+        }
+        Ok(None) => {
+            eprintln!("Page {} not found", page_number);
+        }
+        Err(e) => {
+            eprintln!("Failed to load page {}: {}", page_number, e);
+        }
+    }
+}
+
+/// Persist an auto-pagination split in one transaction: the current page
+/// keeps `keep` and `overflow` is prepended to the next page, which is
+/// created when missing. Returns the new page total.
+fn split_page(
+    database: &db::Database,
+    entry_id: i64,
+    page_number: i32,
+    keep: &str,
+    overflow: &str,
+    master_key: &crypto::MasterKey,
+) -> Result<i32, Box<dyn std::error::Error>> {
+    let tx = database.connection().unchecked_transaction()?;
+
+    let mut current = db::pages::get_by_number(&tx, entry_id, page_number)?
+        .ok_or("Current page not found")?;
+    current.content_encrypted = crypto::encrypt(keep, master_key)?;
+    current.word_count = count_words(keep);
+    db::pages::update(&tx, &current)?;
+
+    let next_id = match db::pages::get_by_number(&tx, entry_id, page_number + 1)? {
+        Some(mut next) => {
+            let existing = crypto::decrypt(&next.content_encrypted, master_key)?;
+            let merged = if existing.is_empty() {
+                overflow.to_string()
+            } else {
+                // Images already on the next page move down behind the overflow
+                let shift = marker_offset(overflow.encode_utf16().count()) + 1;
+                for image in db::images::get_by_owner(&tx, entry_id, next.id)? {
+                    if let Some(id) = image.id {
+                        db::images::move_to(&tx, id, next.id, image.position_in_content + shift)?;
+                    }
+                }
+                format!("{}\n{}", overflow, existing)
+            };
+            next.content_encrypted = crypto::encrypt(&merged, master_key)?;
+            next.word_count = count_words(&merged);
+            db::pages::update(&tx, &next)?;
+            next.id
+        }
+        None => {
+            let encrypted = crypto::encrypt(overflow, master_key)?;
+            let next = db::Page::new(entry_id, page_number + 1, encrypted, count_words(overflow));
+            Some(db::pages::create(&tx, &next)?)
+        }
+    };
+
+    // Book pages hold no checklist items, so every U+FFFC is an image, in
+    // text order: those after the kept ones went with the overflow
+    let images = db::images::get_by_owner(&tx, entry_id, current.id)?;
+    let kept = marker_offsets(keep).into_iter().map(|p| (current.id, p));
+    let carried = marker_offsets(overflow).into_iter().map(|p| (next_id, p));
+    for (image, (page_id, position)) in images.iter().zip(kept.chain(carried)) {
+        if let Some(id) = image.id {
+            db::images::move_to(&tx, id, page_id, position)?;
+        }
+    }
+
+    let total = db::pages::count_by_entry(&tx, entry_id)?;
+    tx.commit()?;
+
+    Ok(total as i32)
+}
+
+/// Whether a save for `page` (0 for a note) is for the text Rust has open
+fn is_open_text(state: &AppState, page: i32) -> bool {
+    match state.current_entry_mode {
+        Some(db::EntryMode::Book) => state.current_page_number == Some(page),
+        Some(db::EntryMode::Note) => page == 0,
+        None => false,
+    }
+}
+
+/// Text a callback passed as a pointer and a length in bytes; NULs in it
+/// are kept
+///
+/// # Safety
+/// `data` must point to `length` bytes that outlive the callback's use.
+unsafe fn callback_str<'a>(data: *const c_char, length: c_longlong) -> Result<&'a str, std::str::Utf8Error> {
+    if data.is_null() || length <= 0 {
+        return Ok("");
+    }
+    std::str::from_utf8(std::slice::from_raw_parts(data as *const u8, length as usize))
+}
+
+/// UTF-16 offset of each U+FFFC in `text`, as the editor counts positions
+fn marker_offsets(text: &str) -> Vec<i32> {
+    let mut offsets = Vec::new();
+    let mut offset = 0;
+    for c in text.chars() {
+        if c == '\u{FFFC}' {
+            offsets.push(marker_offset(offset));
+        }
+        offset += c.len_utf16();
+    }
+    offsets
+}
+
+fn marker_offset(utf16: usize) -> i32 {
+    utf16.min(i32::MAX as usize) as i32
+}
+
+/// Encrypt `text` and store it as page `page` of the open book, or as the
+/// open note when `page` is 0
+fn save_text(state: &AppState, page: i32, text: &str) -> Result<(), Box<dyn std::error::Error>> {
+    let (entry_id, master_key) = match (state.current_entry_id, &state.master_key) {
+        (Some(id), Some(key)) => (id, key),
+        _ => return Err("No open entry".into()),
+    };
+
+    let encrypted = crypto::encrypt(text, master_key)?;
+    match state.current_entry_mode {
+        Some(db::EntryMode::Book) => {
+            let mut row = db::pages::get_by_number(state.db.connection(), entry_id, page)?
+                .ok_or("Saved page not found")?;
+            row.content_encrypted = encrypted;
+            row.word_count = count_words(text);
+            db::pages::update(state.db.connection(), &row)?;
+        }
+        Some(db::EntryMode::Note) => {
+            if page != 0 {
+                return Err("Page save for a note".into());
+            }
+            let mut note = db::notes::get_by_entry(state.db.connection(), entry_id)?;
+            note.content_encrypted = encrypted;
+            db::notes::update(state.db.connection(), &note)?;
+        }
+        None => return Err("No open entry".into()),
+    }
+
+    Ok(())
+}
+
 fn count_words(text: &str) -> i32 {
     text.split_whitespace().count() as i32
 }
@@ -1,24 +1,87 @@
 // src/qt_ffi.rs
 // Rust FFI bindings to Qt C bridge
 
-use std::os::raw::{c_char, c_int, c_void};
+use std::os::raw::{c_char, c_int, c_longlong, c_uchar, c_void};
 
 #[repr(C)]
 pub struct MainWindowHandle {
     _private: [u8; 0],
 }
 
+/// One edit of a delta save; offsets and lengths are UTF-8 bytes and
+/// `insert` is not NUL-terminated
+#[repr(C)]
+pub struct SaveDeltaOp {
+    pub offset: c_longlong,
+    pub delete_length: c_longlong,
+    pub insert: *const c_char,
+    pub insert_length: c_longlong,
+}
+
+/// One event from the UI event ring; `text` is UTF-8, not NUL-terminated,
+/// and valid until the next qt_next_event call
+#[repr(C)]
+pub struct UiEvent {
+    pub event_type: c_int,
+    pub value: c_int,
+    pub id: c_longlong,
+    pub text: *const c_char,
+    pub text_length: c_longlong,
+}
+
+// Event types written to the ring
+pub const UI_EVENT_NEW_ENTRY_CLICKED: c_int = 1;
+pub const UI_EVENT_ENTRY_SELECTED: c_int = 2;
+pub const UI_EVENT_DELETE_ENTRY: c_int = 3;
+pub const UI_EVENT_BACK_TO_LIST: c_int = 4;
+pub const UI_EVENT_SEARCH_ENTRIES: c_int = 5;
+pub const UI_EVENT_PAGE_CHANGED: c_int = 6;
+pub const UI_EVENT_ADD_NEW_PAGE: c_int = 7;
+pub const UI_EVENT_PREFETCH_PAGE: c_int = 8;
+pub const UI_EVENT_CHECKBOX_TOGGLED: c_int = 9;
+
+/// The window handle, for worker threads: the qt_set_* and qt_batch_*
+/// functions may be called from any thread
+#[derive(Clone, Copy)]
+pub struct SendHandle(pub *mut MainWindowHandle);
+
+unsafe impl Send for SendHandle {}
+
 // Callback types
 pub type PasswordSubmittedCallback = extern "C" fn(*const c_char, *mut c_void);
 pub type NewEntryClickedCallback = extern "C" fn(*mut c_void);
-pub type ModeSelectedCallback = extern "C" fn(*const c_char, *const c_char, *mut c_void);
+pub type ModeSelectedCallback = extern "C" fn(*const c_char, c_longlong, *const c_char, c_longlong, *mut c_void);
 pub type EntrySelectedCallback = extern "C" fn(c_int, *mut c_void);
 pub type DeleteEntryCallback = extern "C" fn(c_int, *mut c_void);
-pub type SaveContentCallback = extern "C" fn(*const c_char, *mut c_void);
+pub type SaveContentCallback = extern "C" fn(*const c_char, c_longlong, c_int, *mut c_void);
 pub type BackToListCallback = extern "C" fn(*mut c_void);
 pub type SearchEntriesCallback = extern "C" fn(*const c_char, *mut c_void);
 pub type PageChangedCallback = extern "C" fn(c_int, *mut c_void);
 pub type AddNewPageCallback = extern "C" fn(*mut c_void);
+pub type SplitPageCallback =
+    extern "C" fn(c_int, *const c_char, c_longlong, *const c_char, c_longlong, *mut c_void) -> c_int;
+pub type SaveDeltaCallback =
+    extern "C" fn(c_longlong, c_longlong, *const SaveDeltaOp, c_int, c_int, *mut c_void) -> c_int;
+pub type PrefetchPageCallback = extern "C" fn(c_int, *mut c_void);
+pub type AddCheckboxCallback = extern "C" fn(c_int, *mut c_void) -> c_longlong;
+pub type CheckboxToggledCallback = extern "C" fn(c_longlong, c_int, *mut c_void);
+pub type CheckboxOrderCallback = extern "C" fn(*const c_longlong, *const c_int, c_int, *mut c_void);
+pub type ImageInsertedCallback =
+    extern "C" fn(*const c_char, *const c_char, c_int, c_int, c_int, *mut c_void) -> c_longlong;
+pub type ImagePositionsCallback = extern "C" fn(*const c_longlong, *const c_int, c_int, *mut c_void);
+pub type ThumbnailRequestedCallback = extern "C" fn(*const c_char, c_int, *mut c_void);
+pub type OriginalRequestedCallback = extern "C" fn(c_longlong, *mut c_void);
+pub type ThumbnailsReadyCallback = extern "C" fn(
+    c_longlong,
+    *const c_char,
+    *const c_int,
+    *const *const c_uchar,
+    *const c_longlong,
+    c_int,
+    *mut c_void,
+);
+pub type GuiTaskCallback = extern "C" fn(*mut c_void);
+pub type EventsAvailableCallback = extern "C" fn(*mut c_void);
 
 #[link(name = "notequarry_ui")]
 extern "C" {
@@ -28,14 +91,73 @@ extern "C" {
     pub fn qt_cleanup(handle: *mut MainWindowHandle);
 
     // UI Updates
+    pub fn qt_batch_begin(handle: *mut MainWindowHandle);
+    pub fn qt_batch_commit(handle: *mut MainWindowHandle);
     pub fn qt_set_entry_list(handle: *mut MainWindowHandle, entries: *const *const c_char, count: c_int);
     pub fn qt_set_current_entry_title(handle: *mut MainWindowHandle, title: *const c_char);
     pub fn qt_set_current_content(handle: *mut MainWindowHandle, content: *const c_char);
+    pub fn qt_set_entry_list_utf8(
+        handle: *mut MainWindowHandle,
+        entries: *const *const c_char,
+        lengths: *const c_longlong,
+        count: c_int,
+    );
+    pub fn qt_set_current_entry_title_utf8(handle: *mut MainWindowHandle, title: *const c_char, length: c_longlong);
+    pub fn qt_set_current_content_utf8(handle: *mut MainWindowHandle, content: *const c_char, length: c_longlong);
+    pub fn qt_set_current_content_utf16(handle: *mut MainWindowHandle, content: *const u16, length: c_longlong);
     pub fn qt_set_current_page(handle: *mut MainWindowHandle, page: c_int);
     pub fn qt_set_total_pages(handle: *mut MainWindowHandle, total: c_int);
     pub fn qt_set_word_count(handle: *mut MainWindowHandle, count: c_int);
+    pub fn qt_show_book_editor(handle: *mut MainWindowHandle);
+    pub fn qt_show_note_editor(handle: *mut MainWindowHandle);
+    pub fn qt_show_list_view(handle: *mut MainWindowHandle);
     pub fn qt_set_password_error(handle: *mut MainWindowHandle, error: *const c_char);
     pub fn qt_show_password_error(handle: *mut MainWindowHandle, show: c_int);
+    pub fn qt_unlock_finished(handle: *mut MainWindowHandle, unlocked: c_int, error: *const c_char);
+    pub fn qt_post_to_gui(handle: *mut MainWindowHandle, cb: Option<GuiTaskCallback>, user_data: *mut c_void);
+    pub fn qt_set_autosave_interval(handle: *mut MainWindowHandle, msec: c_int);
+    pub fn qt_provide_page_content(handle: *mut MainWindowHandle, page: c_int, content: *const c_char);
+    pub fn qt_provide_page_content_utf8(
+        handle: *mut MainWindowHandle,
+        page: c_int,
+        content: *const c_char,
+        length: c_longlong,
+    );
+    pub fn qt_provide_page_content_utf16(
+        handle: *mut MainWindowHandle,
+        page: c_int,
+        content: *const u16,
+        length: c_longlong,
+    );
+    pub fn qt_set_note_checkboxes(
+        handle: *mut MainWindowHandle,
+        ids: *const c_longlong,
+        checked: *const c_int,
+        count: c_int,
+    );
+    pub fn qt_set_images(
+        handle: *mut MainWindowHandle,
+        ids: *const c_longlong,
+        paths: *const *const c_char,
+        hashes: *const *const c_char,
+        positions: *const c_int,
+        widths: *const c_int,
+        heights: *const c_int,
+        count: c_int,
+    );
+    pub fn qt_provide_thumbnail(
+        handle: *mut MainWindowHandle,
+        hash: *const c_char,
+        size: c_int,
+        data: *const c_uchar,
+        length: c_longlong,
+    );
+    pub fn qt_provide_original(
+        handle: *mut MainWindowHandle,
+        image_id: c_longlong,
+        data: *const c_uchar,
+        length: c_longlong,
+    );
 
     // Callback Registration
     pub fn qt_register_password_submitted(
@@ -97,4 +219,79 @@ extern "C" {
         cb: Option<AddNewPageCallback>,
         user_data: *mut c_void,
     );
+
+    pub fn qt_register_split_page(
+        handle: *mut MainWindowHandle,
+        cb: Option<SplitPageCallback>,
+        user_data: *mut c_void,
+    );
+
+    pub fn qt_register_save_delta(
+        handle: *mut MainWindowHandle,
+        cb: Option<SaveDeltaCallback>,
+        user_data: *mut c_void,
+    );
+
+    pub fn qt_register_prefetch_page(
+        handle: *mut MainWindowHandle,
+        cb: Option<PrefetchPageCallback>,
+        user_data: *mut c_void,
+    );
+
+    pub fn qt_register_add_checkbox(
+        handle: *mut MainWindowHandle,
+        cb: Option<AddCheckboxCallback>,
+        user_data: *mut c_void,
+    );
+
+    pub fn qt_register_checkbox_toggled(
+        handle: *mut MainWindowHandle,
+        cb: Option<CheckboxToggledCallback>,
+        user_data: *mut c_void,
+    );
+
+    pub fn qt_register_checkbox_order(
+        handle: *mut MainWindowHandle,
+        cb: Option<CheckboxOrderCallback>,
+        user_data: *mut c_void,
+    );
+
+    pub fn qt_register_image_inserted(
+        handle: *mut MainWindowHandle,
+        cb: Option<ImageInsertedCallback>,
+        user_data: *mut c_void,
+    );
+
+    pub fn qt_register_image_positions(
+        handle: *mut MainWindowHandle,
+        cb: Option<ImagePositionsCallback>,
+        user_data: *mut c_void,
+    );
+
+    pub fn qt_register_thumbnail_requested(
+        handle: *mut MainWindowHandle,
+        cb: Option<ThumbnailRequestedCallback>,
+        user_data: *mut c_void,
+    );
+
+    pub fn qt_register_original_requested(
+        handle: *mut MainWindowHandle,
+        cb: Option<OriginalRequestedCallback>,
+        user_data: *mut c_void,
+    );
+
+    pub fn qt_register_thumbnails_ready(
+        handle: *mut MainWindowHandle,
+        cb: Option<ThumbnailsReadyCallback>,
+        user_data: *mut c_void,
+    );
+
+    // Event Ring
+    pub fn qt_enable_event_ring(
+        handle: *mut MainWindowHandle,
+        capacity: c_longlong,
+        cb: Option<EventsAvailableCallback>,
+        user_data: *mut c_void,
+    );
+    pub fn qt_next_event(handle: *mut MainWindowHandle, event: *mut UiEvent) -> c_int;
 }
\ No newline at end of file
@@ -0,0 +1,167 @@
+// src/thumbnails.rs
+// Encrypted on-disk thumbnails of inserted images, keyed by content hash
+
+use std::fs;
+use std::io;
+use std::path::{Path, PathBuf};
+
+use crate::crypto::{self, MasterKey};
+
+/// Thumbnail error type
+#[derive(Debug)]
+pub enum ThumbnailError {
+    InvalidKey,
+    Io(io::Error),
+    Crypto(crypto::encryption::EncryptionError),
+}
+
+impl std::fmt::Display for ThumbnailError {
+    fn fmt(&self, f: &mut std::fmt::Formatter) -> std::fmt::Result {
+        match self {
+            ThumbnailError::InvalidKey => write!(f, "Invalid thumbnail hash or size"),
+            ThumbnailError::Io(e) => write!(f, "Thumbnail file error: {}", e),
+            ThumbnailError::Crypto(e) => write!(f, "{}", e),
+        }
+    }
+}
+
+impl std::error::Error for ThumbnailError {}
+
+impl From<io::Error> for ThumbnailError {
+    fn from(e: io::Error) -> Self {
+        ThumbnailError::Io(e)
+    }
+}
+
+impl From<crypto::encryption::EncryptionError> for ThumbnailError {
+    fn from(e: crypto::encryption::EncryptionError) -> Self {
+        ThumbnailError::Crypto(e)
+    }
+}
+
+/// Largest thumbnail side accepted, in pixels
+const MAX_SIZE: i32 = 4096;
+
+/// Thumbnails live in `<dir>/<first two hex digits>/<hash>-<size>.thumb`,
+/// one file per size, each encrypted with the master key. The hash is the
+/// SHA-256 of the original file, so the same picture inserted twice shares
+/// its thumbnails and a file is never rewritten once stored.
+pub struct ThumbnailStore {
+    dir: PathBuf,
+}
+
+impl ThumbnailStore {
+    pub fn new(dir: PathBuf) -> Self {
+        ThumbnailStore { dir }
+    }
+
+    /// Store kept in a `thumbnails` directory next to the database
+    pub fn beside(db_path: &Path) -> Self {
+        let parent = db_path.parent().unwrap_or_else(|| Path::new("."));
+        Self::new(parent.join("thumbnails"))
+    }
+
+    /// Lowercase hex SHA-256, the only form used as a file name
+    pub fn is_valid_hash(hash: &str) -> bool {
+        hash.len() == 64 && hash.bytes().all(|b| b.is_ascii_digit() || (b'a'..=b'f').contains(&b))
+    }
+
+    fn path(&self, hash: &str, size: i32) -> Result<PathBuf, ThumbnailError> {
+        if !Self::is_valid_hash(hash) || size <= 0 || size > MAX_SIZE {
+            return Err(ThumbnailError::InvalidKey);
+        }
+        Ok(self.dir.join(&hash[..2]).join(format!("{}-{}.thumb", hash, size)))
+    }
+
+    pub fn contains(&self, hash: &str, size: i32) -> bool {
+        self.path(hash, size).map(|path| path.exists()).unwrap_or(false)
+    }
+
+    /// Encrypt and write one size of a thumbnail, unless it is already there
+    pub fn store(&self, hash: &str, size: i32, data: &[u8], key: &MasterKey) -> Result<(), ThumbnailError> {
+        let path = self.path(hash, size)?;
+        if path.exists() {
+            return Ok(());
+        }
+
+        let encrypted = crypto::encrypt_bytes(data, key)?;
+        if let Some(parent) = path.parent() {
+            fs::create_dir_all(parent)?;
+        }
+
+        // Written aside and renamed, so a crash never leaves half a file
+        let partial = path.with_extension("part");
+        fs::write(&partial, &encrypted)?;
+        fs::rename(&partial, &path)?;
+        Ok(())
+    }
+
+    /// The decrypted thumbnail, or None when that size was never stored
+    pub fn load(&self, hash: &str, size: i32, key: &MasterKey) -> Result<Option<Vec<u8>>, ThumbnailError> {
+        let path = self.path(hash, size)?;
+        let encrypted = match fs::read(&path) {
+            Ok(encrypted) => encrypted,
+            Err(e) if e.kind() == io::ErrorKind::NotFound => return Ok(None),
+            Err(e) => return Err(e.into()),
+        };
+        Ok(Some(crypto::decrypt_bytes(&encrypted, key)?))
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    const HASH: &str = "9f86d081884c7d659a2feaa0c55ad015a3bf4f1b2b0b822cd15d6c15b0f00a08";
+
+    fn temp_store(name: &str) -> ThumbnailStore {
+        let dir = std::env::temp_dir().join(format!("notequarry-thumbs-{}-{}", std::process::id(), name));
+        let _ = fs::remove_dir_all(&dir);
+        ThumbnailStore::new(dir)
+    }
+
+    #[test]
+    fn test_store_and_load() {
+        let store = temp_store("roundtrip");
+        let key = MasterKey::from_bytes([7; 32]);
+
+        assert!(store.load(HASH, 256, &key).unwrap().is_none());
+        store.store(HASH, 256, &[1, 2, 3], &key).unwrap();
+
+        assert!(store.contains(HASH, 256));
+        assert!(!store.contains(HASH, 640));
+        assert_eq!(store.load(HASH, 256, &key).unwrap(), Some(vec![1, 2, 3]));
+
+        // Encrypted at rest
+        let on_disk = fs::read(store.path(HASH, 256).unwrap()).unwrap();
+        assert!(!on_disk.windows(3).any(|w| w == [1, 2, 3]));
+
+        // Content-keyed: a second store of the same hash keeps the first
+        store.store(HASH, 256, &[9], &key).unwrap();
+        assert_eq!(store.load(HASH, 256, &key).unwrap(), Some(vec![1, 2, 3]));
+
+        let _ = fs::remove_dir_all(&store.dir);
+    }
+
+    #[test]
+    fn test_wrong_key_fails() {
+        let store = temp_store("wrong-key");
+        store.store(HASH, 128, &[5; 64], &MasterKey::from_bytes([1; 32])).unwrap();
+
+        assert!(store.load(HASH, 128, &MasterKey::from_bytes([2; 32])).is_err());
+
+        let _ = fs::remove_dir_all(&store.dir);
+    }
+
+    #[test]
+    fn test_rejects_unsafe_keys() {
+        let store = temp_store("keys");
+        let key = MasterKey::from_bytes([7; 32]);
+
+        assert!(!ThumbnailStore::is_valid_hash("../../etc/passwd"));
+        assert!(!ThumbnailStore::is_valid_hash(&HASH.to_uppercase()));
+        assert!(store.store("../x", 256, &[1], &key).is_err());
+        assert!(store.store(HASH, 0, &[1], &key).is_err());
+        assert!(store.store(HASH, MAX_SIZE + 1, &[1], &key).is_err());
+    }
+}
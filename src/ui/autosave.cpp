@@ -0,0 +1,106 @@
+// autosave.cpp
+#include "autosave.h"
+#include "text_store.h"
+#include <QElapsedTimer>
+
+// ============ AutosaveScheduler Implementation ============
+AutosaveScheduler::AutosaveScheduler(QObject *parent)
+    : QObject(parent), m_idleInterval(DefaultIdleInterval), m_inFlight(false), m_flushAgain(false), m_dirty(false)
+{
+    m_idleTimer.setSingleShot(true);
+    connect(&m_idleTimer, &QTimer::timeout, this, &AutosaveScheduler::flush);
+}
+
+void AutosaveScheduler::track(TextStore *store)
+{
+    // Stores go away with their documents, e.g. evicted cached pages
+    m_stores.removeAll(QPointer<TextStore>());
+    m_stores.append(store);
+    connect(store, &TextStore::changed, this, &AutosaveScheduler::onEdited);
+}
+
+void AutosaveScheduler::setIdleInterval(int msec)
+{
+    m_idleInterval = qMax(msec, 0);
+    if (m_idleInterval == 0)
+    {
+        m_idleTimer.stop();
+    }
+}
+
+int AutosaveScheduler::idleInterval() const
+{
+    return m_idleInterval;
+}
+
+bool AutosaveScheduler::isDirty() const
+{
+    for (const QPointer<TextStore> &store : m_stores)
+    {
+        if (store && store->isModified())
+            return true;
+    }
+    return false;
+}
+
+void AutosaveScheduler::flush()
+{
+    m_idleTimer.stop();
+
+    // Edits that land while a save runs are picked up once it returns
+    if (m_inFlight)
+    {
+        m_flushAgain = true;
+        return;
+    }
+
+    do
+    {
+        m_flushAgain = false;
+
+        // A save can bring in a new page, whose store track() appends
+        const QList<QPointer<TextStore>> stores = m_stores;
+        for (const QPointer<TextStore> &store : stores)
+        {
+            // Revisions that are already stored are skipped
+            if (store && store->isModified())
+                save(store);
+        }
+    } while (m_flushAgain);
+
+    const bool dirty = isDirty();
+    if (dirty != m_dirty)
+    {
+        m_dirty = dirty;
+        emit dirtyChanged(dirty);
+    }
+}
+
+void AutosaveScheduler::onEdited()
+{
+    // Every edit pushes the save back, so it runs once typing pauses
+    if (m_idleInterval > 0)
+    {
+        m_idleTimer.start(m_idleInterval);
+    }
+
+    if (!m_dirty)
+    {
+        m_dirty = true;
+        emit dirtyChanged(true);
+    }
+}
+
+void AutosaveScheduler::save(TextStore *store)
+{
+    const qint64 revision = store->revision();
+
+    m_inFlight = true;
+    QElapsedTimer timer;
+    timer.start();
+    emit saveRequested(store);
+    const qint64 elapsed = timer.elapsed();
+    m_inFlight = false;
+
+    emit saveFinished(store->savedRevision() == revision, revision, elapsed);
+}
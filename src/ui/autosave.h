@@ -0,0 +1,58 @@
+// src/ui/autosave.h
+// Idle-coalesced autosave for the editors' text stores
+#ifndef AUTOSAVE_H
+#define AUTOSAVE_H
+
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+
+class TextStore;
+
+// ============ Autosave Scheduler ============
+// Watches the editors' TextStores and saves the ones with unsaved revisions
+// once typing has paused for the idle interval, so a burst of edits costs a
+// single encrypt-and-write. Saves run one at a time; a store counts as saved
+// only once the handler of saveRequested() has marked its revision saved.
+class AutosaveScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int DefaultIdleInterval = 2000;
+
+    explicit AutosaveScheduler(QObject *parent = nullptr);
+
+    void track(TextStore *store);
+
+    // 0 turns idle saves off; flush() still saves
+    void setIdleInterval(int msec);
+    int idleInterval() const;
+
+    bool isDirty() const;
+
+    // Saves every store with unsaved edits now, e.g. before the page changes
+    void flush();
+
+signals:
+    // Handlers save the store's current revision and mark it saved
+    void saveRequested(TextStore *store);
+    void saveFinished(bool saved, qint64 revision, qint64 elapsedMs);
+    void dirtyChanged(bool dirty);
+
+private slots:
+    void onEdited();
+
+private:
+    void save(TextStore *store);
+
+    QList<QPointer<TextStore>> m_stores;
+    QTimer m_idleTimer;
+    int m_idleInterval;
+    bool m_inFlight;
+    bool m_flushAgain;
+    bool m_dirty;
+};
+
+#endif // AUTOSAVE_H
@@ -0,0 +1,361 @@
+// book_scroll_view.cpp
+#include "book_scroll_view.h"
+#include <QAbstractTextDocumentLayout>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QScrollBar>
+#include <QTextDocument>
+#include <QThread>
+#include <QtMath>
+#include <algorithm>
+
+namespace
+{
+    const QColor BackgroundColor("#1a1a1a");
+    const QColor PageColor("#252525");
+    const QColor BorderColor("#2d5016");
+    const QColor TextColor("#c5c5c5");
+    const QColor PlaceholderColor("#5a5a5a");
+}
+
+// ============ BookScrollView Implementation ============
+BookScrollView::BookScrollView(QWidget *parent)
+    : QAbstractScrollArea(parent), m_offsets(1, 0), m_measuredTotal(0), m_measuredCount(0), m_currentPage(0), m_generation(0)
+{
+    setFrameShape(QFrame::NoFrame);
+    setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    verticalScrollBar()->setSingleStep(40);
+
+    // Two layouts in flight are enough to keep up with the scroll bar
+    m_pool.setMaxThreadCount(2);
+}
+
+void BookScrollView::setDocumentStyle(const PageEditor::DocumentStyle &style)
+{
+    m_style = style;
+}
+
+void BookScrollView::setPageCount(int count)
+{
+    count = qMax(count, 0);
+    for (int index = count; index < int(m_pages.size()); ++index)
+    {
+        if (m_pages[index].measured)
+        {
+            m_measuredTotal -= m_pages[index].height;
+            --m_measuredCount;
+        }
+        releasePage(index);
+    }
+    m_pages.resize(count, Page{nullptr, 0, false, false});
+
+    relayout();
+    updateResident();
+}
+
+int BookScrollView::pageCount() const
+{
+    return int(m_pages.size());
+}
+
+void BookScrollView::clear()
+{
+    // Layouts still running belong to the old content
+    ++m_generation;
+    for (int index : QSet<int>(m_resident))
+        releasePage(index);
+    for (Page &page : m_pages)
+        page.measured = false;
+    m_measuredTotal = 0;
+    m_measuredCount = 0;
+    m_currentPage = 0;
+
+    relayout();
+    verticalScrollBar()->setValue(0);
+}
+
+void BookScrollView::setPageContent(int page, const QString &content)
+{
+    const int index = page - 1;
+    if (index < 0 || index >= int(m_pages.size()) || !m_pages[index].requested)
+        return;
+
+    const PageEditor::DocumentStyle style = m_style;
+    const int width = textWidth();
+    const quint64 generation = m_generation;
+    QThread *guiThread = thread();
+
+    m_pool.start([this, page, content, style, width, generation, guiThread]()
+                 {
+        // Text layout into a document that is not on screen is fine off the
+        // GUI thread; only painting has to wait for it to come back
+        QTextDocument *document = new QTextDocument;
+        document->setDefaultFont(style.font);
+        document->setDefaultTextOption(style.option);
+        document->setDocumentMargin(0);
+        document->setPlainText(content);
+        document->setTextWidth(width);
+        document->documentLayout()->documentSize();
+        document->moveToThread(guiThread);
+
+        QMetaObject::invokeMethod(this, [this, page, document, width, generation]()
+                                  { onPageBuilt(page, document, width, generation); }, Qt::QueuedConnection); });
+}
+
+void BookScrollView::scrollToPage(int page)
+{
+    relayout();
+    const int index = qBound(0, page - 1, qMax(int(m_pages.size()) - 1, 0));
+    verticalScrollBar()->setValue(m_offsets[index] - PageSpacing);
+    updateResident();
+}
+
+int BookScrollView::currentPage() const
+{
+    return m_currentPage;
+}
+
+void BookScrollView::paintEvent(QPaintEvent *event)
+{
+    QPainter painter(viewport());
+    painter.fillRect(event->rect(), BackgroundColor);
+    if (m_pages.empty())
+        return;
+
+    const int top = verticalScrollBar()->value();
+    const int first = pageIndexAt(top + event->rect().top());
+    const int last = pageIndexAt(top + event->rect().bottom());
+    const int left = (viewport()->width() - pageWidth()) / 2;
+
+    for (int index = first; index <= last; ++index)
+    {
+        const QRect pageRect(left, m_offsets[index] - top, pageWidth(), pageHeight(index));
+        painter.fillRect(pageRect, PageColor);
+        painter.setPen(BorderColor);
+        painter.drawRect(pageRect.adjusted(0, 0, -1, -1));
+
+        QTextDocument *document = m_pages[index].document;
+        if (!document)
+        {
+            painter.setPen(PlaceholderColor);
+            painter.drawText(pageRect, Qt::AlignCenter, tr("Page %1").arg(index + 1));
+            continue;
+        }
+
+        const QPoint origin = pageRect.topLeft() + QPoint(PagePadding, PagePadding);
+        QAbstractTextDocumentLayout::PaintContext context;
+        context.palette.setColor(QPalette::Text, TextColor);
+        context.clip = QRectF(event->rect().translated(-origin));
+
+        painter.save();
+        painter.translate(origin);
+        document->documentLayout()->draw(&painter, context);
+        painter.restore();
+    }
+}
+
+void BookScrollView::resizeEvent(QResizeEvent *event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+
+    // A new width invalidates every measured height; pages in view are laid
+    // out again here, the rest are measured when they come back
+    const int width = textWidth();
+    const int top = verticalScrollBar()->value();
+    const int anchor = m_pages.empty() ? 0 : pageIndexAt(top);
+    const int within = m_pages.empty() ? 0 : top - m_offsets[anchor];
+
+    m_measuredTotal = 0;
+    m_measuredCount = 0;
+    for (int index = 0; index < int(m_pages.size()); ++index)
+    {
+        Page &page = m_pages[index];
+        page.measured = false;
+        if (page.document && page.document->textWidth() != width)
+        {
+            page.document->setTextWidth(width);
+        }
+        if (page.document)
+        {
+            page.height = qCeil(page.document->size().height()) + 2 * PagePadding;
+            page.measured = true;
+            m_measuredTotal += page.height;
+            ++m_measuredCount;
+        }
+    }
+
+    relayout();
+    if (!m_pages.empty())
+        verticalScrollBar()->setValue(m_offsets[anchor] + within);
+    updateResident();
+}
+
+void BookScrollView::showEvent(QShowEvent *event)
+{
+    QAbstractScrollArea::showEvent(event);
+    updateResident();
+}
+
+void BookScrollView::scrollContentsBy(int dx, int dy)
+{
+    Q_UNUSED(dx);
+    Q_UNUSED(dy);
+
+    // Pages are painted from their layouts, so there is nothing to blit
+    viewport()->update();
+    updateResident();
+}
+
+void BookScrollView::mouseDoubleClickEvent(QMouseEvent *event)
+{
+    if (m_pages.empty())
+        return;
+
+    const int index = pageIndexAt(verticalScrollBar()->value() + event->position().toPoint().y());
+    emit pageActivated(index + 1);
+}
+
+void BookScrollView::onPageBuilt(int page, QTextDocument *document, int width, quint64 generation)
+{
+    const int index = page - 1;
+    if (generation != m_generation || index >= int(m_pages.size()) || !m_pages[index].requested ||
+        m_pages[index].document)
+    {
+        delete document;
+        return;
+    }
+
+    // The view was resized while the layout ran
+    if (width != textWidth())
+        document->setTextWidth(textWidth());
+
+    document->setParent(this);
+    m_pages[index].document = document;
+    setPageHeight(index, qCeil(document->size().height()) + 2 * PagePadding);
+    viewport()->update();
+}
+
+void BookScrollView::setPageHeight(int index, int height)
+{
+    Page &page = m_pages[index];
+    if (page.measured && page.height == height)
+        return;
+
+    // Keep the text under the top of the viewport where it is while the
+    // pages above it settle to their real heights
+    const int top = verticalScrollBar()->value();
+    const int anchor = pageIndexAt(top);
+    const int within = top - m_offsets[anchor];
+
+    if (page.measured)
+    {
+        m_measuredTotal -= page.height;
+    }
+    else
+    {
+        page.measured = true;
+        ++m_measuredCount;
+    }
+    page.height = height;
+    m_measuredTotal += height;
+
+    relayout();
+    verticalScrollBar()->setValue(m_offsets[anchor] + within);
+}
+
+void BookScrollView::relayout()
+{
+    m_offsets.resize(m_pages.size() + 1);
+    int offset = PageSpacing;
+    for (size_t index = 0; index < m_pages.size(); ++index)
+    {
+        m_offsets[index] = offset;
+        offset += pageHeight(int(index)) + PageSpacing;
+    }
+    m_offsets[m_pages.size()] = offset;
+
+    const int viewportHeight = viewport()->height();
+    verticalScrollBar()->setPageStep(viewportHeight);
+    verticalScrollBar()->setRange(0, qMax(0, offset - viewportHeight));
+}
+
+void BookScrollView::updateResident()
+{
+    if (m_pages.empty() || !isVisible())
+        return;
+
+    const int top = verticalScrollBar()->value();
+    const int first = pageIndexAt(top);
+    const int last = pageIndexAt(top + viewport()->height());
+    const int low = qMax(0, first - ResidentMargin);
+    const int high = qMin(int(m_pages.size()) - 1, last + ResidentMargin);
+
+    for (int index : QSet<int>(m_resident))
+    {
+        if (index < low || index > high)
+            releasePage(index);
+    }
+
+    // Nearest first, so the pages in view are asked for before the margin
+    for (int index = first; index <= last; ++index)
+    {
+        if (!m_resident.contains(index))
+        {
+            m_resident.insert(index);
+            m_pages[index].requested = true;
+            emit pageRequested(index + 1);
+        }
+    }
+    for (int distance = 1; distance <= ResidentMargin; ++distance)
+    {
+        for (int index : {last + distance, first - distance})
+        {
+            if (index >= low && index <= high && !m_resident.contains(index))
+            {
+                m_resident.insert(index);
+                m_pages[index].requested = true;
+                emit pageRequested(index + 1);
+            }
+        }
+    }
+
+    if (first + 1 != m_currentPage)
+    {
+        m_currentPage = first + 1;
+        emit currentPageChanged(m_currentPage);
+    }
+}
+
+void BookScrollView::releasePage(int index)
+{
+    Page &page = m_pages[index];
+    delete page.document;
+    page.document = nullptr;
+    page.requested = false;
+    m_resident.remove(index);
+}
+
+int BookScrollView::pageHeight(int index) const
+{
+    const Page &page = m_pages[index];
+    if (page.measured)
+        return page.height;
+    return m_measuredCount > 0 ? int(m_measuredTotal / m_measuredCount) : EstimatedPageHeight;
+}
+
+int BookScrollView::pageIndexAt(int y) const
+{
+    // Last page whose top is at or above y
+    const auto it = std::upper_bound(m_offsets.begin(), m_offsets.end() - 1, y);
+    return qBound(0, int(it - m_offsets.begin()) - 1, int(m_pages.size()) - 1);
+}
+
+int BookScrollView::pageWidth() const
+{
+    return qMax(qMin(viewport()->width() - 2 * PageSpacing, MaxPageWidth), 2 * PagePadding + 1);
+}
+
+int BookScrollView::textWidth() const
+{
+    return pageWidth() - 2 * PagePadding;
+}
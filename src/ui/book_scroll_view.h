@@ -0,0 +1,97 @@
+// src/ui/book_scroll_view.h
+// Continuous, read-only view of all pages of a book
+#ifndef BOOK_SCROLL_VIEW_H
+#define BOOK_SCROLL_VIEW_H
+
+#include "page_editor.h"
+#include <QAbstractScrollArea>
+#include <QSet>
+#include <QThreadPool>
+#include <vector>
+
+class QTextDocument;
+
+// ============ Book Scroll View ============
+// Stacks the pages of a book vertically. Only the pages in view, plus
+// ResidentMargin either side, hold a document; every other page is just a
+// height, measured once it has been seen and estimated from the measured
+// ones before that, so memory stays flat however long the book is. Content
+// is asked for with pageRequested() and laid out on a worker thread; painting
+// draws straight from the finished layouts.
+class BookScrollView : public QAbstractScrollArea
+{
+    Q_OBJECT
+
+public:
+    static constexpr int ResidentMargin = 2;
+    static constexpr int PageSpacing = 24;
+    static constexpr int PagePadding = 30;
+    static constexpr int MaxPageWidth = 820;
+    static constexpr int EstimatedPageHeight = 900;
+
+    explicit BookScrollView(QWidget *parent = nullptr);
+
+    void setDocumentStyle(const PageEditor::DocumentStyle &style);
+    void setPageCount(int count);
+    int pageCount() const;
+
+    // Drops every document and measurement, e.g. when another entry opens
+    void clear();
+
+    // Answer to pageRequested(); content nobody asked for is ignored
+    void setPageContent(int page, const QString &content);
+
+    void scrollToPage(int page);
+
+    // Topmost page in view
+    int currentPage() const;
+
+signals:
+    void pageRequested(int page);
+    void currentPageChanged(int page);
+    void pageActivated(int page);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void showEvent(QShowEvent *event) override;
+    void scrollContentsBy(int dx, int dy) override;
+    void mouseDoubleClickEvent(QMouseEvent *event) override;
+
+private:
+    struct Page
+    {
+        QTextDocument *document;
+        int height;
+        bool measured;
+        bool requested;
+    };
+
+    void onPageBuilt(int page, QTextDocument *document, int textWidth, quint64 generation);
+    void setPageHeight(int index, int height);
+    void relayout();
+    void updateResident();
+    void releasePage(int index);
+    int pageHeight(int index) const;
+    int pageIndexAt(int y) const;
+    int pageWidth() const;
+    int textWidth() const;
+
+    PageEditor::DocumentStyle m_style;
+    std::vector<Page> m_pages;
+
+    // Top of each page, plus the end of the last one
+    std::vector<int> m_offsets;
+
+    // Pages holding a document or waiting for one
+    QSet<int> m_resident;
+    qint64 m_measuredTotal;
+    int m_measuredCount;
+    int m_currentPage;
+    quint64 m_generation;
+
+    // Last, so its destructor waits for running layouts before the rest goes
+    QThreadPool m_pool;
+};
+
+#endif // BOOK_SCROLL_VIEW_H
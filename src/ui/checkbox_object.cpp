@@ -0,0 +1,92 @@
+// checkbox_object.cpp
+#include "checkbox_object.h"
+#include <QAbstractTextDocumentLayout>
+#include <QFontMetricsF>
+#include <QPainter>
+#include <QPainterPath>
+#include <QTextDocument>
+
+namespace
+{
+    const QColor BoxColor("#5a8c3a");
+    const QColor CheckedFillColor("#2d5016");
+    const QColor CheckColor("#a8d08d");
+}
+
+// ============ CheckboxObject Implementation ============
+CheckboxObject::CheckboxObject(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void CheckboxObject::install(QTextDocument *document)
+{
+    if (document->findChild<CheckboxObject *>(QString(), Qt::FindDirectChildrenOnly))
+        return;
+
+    // The layout does not own handlers; the document does
+    document->documentLayout()->registerHandler(Type, new CheckboxObject(document));
+}
+
+QTextCharFormat CheckboxObject::format(qint64 id, bool checked)
+{
+    QTextCharFormat format;
+    format.setObjectType(Type);
+    format.setProperty(IdProperty, id);
+    format.setProperty(CheckedProperty, checked);
+    return format;
+}
+
+bool CheckboxObject::isCheckbox(const QTextFormat &format)
+{
+    return format.objectType() == Type;
+}
+
+qint64 CheckboxObject::id(const QTextFormat &format)
+{
+    return format.hasProperty(IdProperty) ? format.property(IdProperty).toLongLong() : -1;
+}
+
+bool CheckboxObject::isChecked(const QTextFormat &format)
+{
+    return format.boolProperty(CheckedProperty);
+}
+
+QSizeF CheckboxObject::intrinsicSize(QTextDocument *document, int position, const QTextFormat &format)
+{
+    Q_UNUSED(position);
+    Q_UNUSED(format);
+
+    // A square the height of a capital letter, sitting on the baseline
+    const QFontMetricsF metrics(document->defaultFont());
+    const qreal side = metrics.ascent();
+    return QSizeF(side, side);
+}
+
+void CheckboxObject::drawObject(QPainter *painter, const QRectF &rect, QTextDocument *document, int position,
+                                const QTextFormat &format)
+{
+    Q_UNUSED(document);
+    Q_UNUSED(position);
+
+    const QRectF box = rect.adjusted(1, 1, -1, -1);
+    const bool checked = isChecked(format);
+
+    painter->save();
+    painter->setRenderHint(QPainter::Antialiasing);
+    painter->setPen(QPen(BoxColor, 1.5));
+    painter->setBrush(checked ? CheckedFillColor : Qt::transparent);
+    painter->drawRoundedRect(box, 2, 2);
+
+    if (checked)
+    {
+        QPainterPath tick;
+        tick.moveTo(box.left() + box.width() * 0.2, box.top() + box.height() * 0.55);
+        tick.lineTo(box.left() + box.width() * 0.42, box.top() + box.height() * 0.78);
+        tick.lineTo(box.left() + box.width() * 0.8, box.top() + box.height() * 0.25);
+        painter->setPen(QPen(CheckColor, 2, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin));
+        painter->setBrush(Qt::NoBrush);
+        painter->drawPath(tick);
+    }
+    painter->restore();
+}
@@ -0,0 +1,52 @@
+// src/ui/checkbox_object.h
+// Checklist items drawn inline in a note
+#ifndef CHECKBOX_OBJECT_H
+#define CHECKBOX_OBJECT_H
+
+#include <QObject>
+#include <QTextCharFormat>
+#include <QTextObjectInterface>
+
+class QTextDocument;
+
+// ============ Checkbox Object ============
+// A checklist item is an object replacement character (U+FFFC) in the note
+// text whose char format carries the item's row id and checked state. The
+// plain text saved for the note keeps the U+FFFC, and ticking an item only
+// changes its format, which the note's TextStore does not count as an edit,
+// so a toggle never re-saves the note.
+class CheckboxObject : public QObject, public QTextObjectInterface
+{
+    Q_OBJECT
+    Q_INTERFACES(QTextObjectInterface)
+
+public:
+    enum
+    {
+        Type = QTextFormat::UserObject + 1
+    };
+
+    enum Property
+    {
+        IdProperty = QTextFormat::UserProperty + 1,
+        CheckedProperty
+    };
+
+    // Registers the handler with the document's layout, once per document
+    static void install(QTextDocument *document);
+
+    // id -1 marks an item whose row has not been created yet
+    static QTextCharFormat format(qint64 id, bool checked);
+    static bool isCheckbox(const QTextFormat &format);
+    static qint64 id(const QTextFormat &format);
+    static bool isChecked(const QTextFormat &format);
+
+    QSizeF intrinsicSize(QTextDocument *document, int position, const QTextFormat &format) override;
+    void drawObject(QPainter *painter, const QRectF &rect, QTextDocument *document, int position,
+                    const QTextFormat &format) override;
+
+private:
+    explicit CheckboxObject(QObject *parent);
+};
+
+#endif // CHECKBOX_OBJECT_H
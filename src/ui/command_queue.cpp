@@ -0,0 +1,88 @@
+// command_queue.cpp
+#include "command_queue.h"
+#include <utility>
+
+// ============ UiCommand Implementation ============
+UiCommand UiCommand::typed(Type type, const QString &text, int value)
+{
+    UiCommand command;
+    command.type = type;
+    command.text = text;
+    command.value = value;
+    return command;
+}
+
+UiCommand UiCommand::function(std::function<void(MainWindowHandle *)> call)
+{
+    UiCommand command;
+    command.type = Call;
+    command.call = std::move(call);
+    return command;
+}
+
+// ============ UiCommandQueue Implementation ============
+UiCommandQueue::UiCommandQueue()
+    : m_head(&m_stub), m_tail(&m_stub)
+{
+}
+
+UiCommandQueue::~UiCommandQueue()
+{
+    UiCommand command;
+    while (pop(&command))
+    {
+    }
+}
+
+void UiCommandQueue::push(UiCommand command)
+{
+    Node *node = new Node;
+    node->command = std::move(command);
+    pushNode(node);
+}
+
+void UiCommandQueue::pushNode(Node *node)
+{
+    node->next.store(nullptr, std::memory_order_relaxed);
+    Node *previous = m_head.exchange(node, std::memory_order_acq_rel);
+    // Between these two lines the queue is cut at `previous`; pop() stops there
+    previous->next.store(node, std::memory_order_release);
+}
+
+bool UiCommandQueue::pop(UiCommand *command)
+{
+    Node *tail = m_tail;
+    Node *next = tail->next.load(std::memory_order_acquire);
+    if (tail == &m_stub)
+    {
+        if (!next)
+            return false;
+        m_tail = next;
+        tail = next;
+        next = next->next.load(std::memory_order_acquire);
+    }
+
+    if (next)
+    {
+        m_tail = next;
+        *command = std::move(tail->command);
+        delete tail;
+        return true;
+    }
+
+    // `tail` is the last node, unless a producer is halfway through pushing
+    if (tail != m_head.load(std::memory_order_acquire))
+        return false;
+
+    // Put the stub back behind the last node so it can be taken
+    pushNode(&m_stub);
+    next = tail->next.load(std::memory_order_acquire);
+    if (next)
+    {
+        m_tail = next;
+        *command = std::move(tail->command);
+        delete tail;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,71 @@
+// src/ui/command_queue.h
+// UI updates from the bridge and the lock-free queue that carries them to the GUI thread
+#ifndef COMMAND_QUEUE_H
+#define COMMAND_QUEUE_H
+
+#include <QString>
+#include <atomic>
+#include <functional>
+
+struct MainWindowHandle;
+
+// One update made through the bridge. The frequent per-transition setters
+// are typed, so a batch can replace an earlier one of the same kind; the
+// rest carry their already-converted arguments in a call.
+struct UiCommand
+{
+    enum Type
+    {
+        EntryTitle,
+        TotalPages,
+        CurrentPage,
+        Content,
+        WordCount,
+        Call
+    };
+
+    Type type = Call;
+    QString text;
+    int value = 0;
+    std::function<void(MainWindowHandle *)> call;
+
+    static UiCommand typed(Type type, const QString &text, int value);
+    static UiCommand function(std::function<void(MainWindowHandle *)> call);
+};
+
+// ============ UI Command Queue ============
+// Vyukov's intrusive multi-producer, single-consumer queue. Any thread may
+// push without locking or waiting; only the GUI thread pops. A pop can come
+// back empty while a push is halfway through; the producer's wakeup, made
+// after its push completes, brings the consumer back for it.
+class UiCommandQueue
+{
+public:
+    UiCommandQueue();
+    ~UiCommandQueue();
+
+    UiCommandQueue(const UiCommandQueue &) = delete;
+    UiCommandQueue &operator=(const UiCommandQueue &) = delete;
+
+    // Any thread
+    void push(UiCommand command);
+
+    // Consumer only; false when there is nothing (yet) to take
+    bool pop(UiCommand *command);
+
+private:
+    struct Node
+    {
+        std::atomic<Node *> next{nullptr};
+        UiCommand command;
+    };
+
+    void pushNode(Node *node);
+
+    // Producers swap themselves in at the head; the consumer walks from the tail
+    std::atomic<Node *> m_head;
+    Node *m_tail;
+    Node m_stub;
+};
+
+#endif // COMMAND_QUEUE_H
@@ -0,0 +1,105 @@
+// event_ring.cpp
+#include "event_ring.h"
+#include <cstring>
+
+// ============ UiEventRing Implementation ============
+UiEventRing::UiEventRing(qsizetype capacity)
+    : m_capacity(MinCapacity), m_head(0), m_tail(0), m_held(0)
+{
+    while (m_capacity < capacity)
+        m_capacity *= 2;
+    m_storage.resize(std::size_t(m_capacity) / sizeof(quint64));
+}
+
+qsizetype UiEventRing::recordSize(qsizetype length)
+{
+    return (qsizetype(sizeof(Record)) + length + 7) & ~qsizetype(7);
+}
+
+char *UiEventRing::at(quint64 position)
+{
+    return reinterpret_cast<char *>(m_storage.data()) + (position & quint64(m_capacity - 1));
+}
+
+bool UiEventRing::push(int type, int value, qint64 id, const char *text, qsizetype length)
+{
+    if (length < 0 || (length > 0 && !text))
+        return false;
+
+    const qsizetype size = recordSize(length);
+    if (size > m_capacity)
+        return false;
+
+    quint64 head = m_head.load(std::memory_order_relaxed);
+    const quint64 tail = m_tail.load(std::memory_order_acquire);
+
+    // Records are never split; when this one would not fit before the end,
+    // the rest of the buffer is skipped
+    const qsizetype toEnd = m_capacity - qsizetype(head & quint64(m_capacity - 1));
+    const qsizetype skip = size > toEnd ? toEnd : 0;
+    if (head + quint64(skip + size) - tail > quint64(m_capacity))
+        return false;
+
+    if (skip > 0)
+    {
+        // Too short a gap for a header is skipped by the reader unmarked
+        if (skip >= qsizetype(sizeof(Record)))
+        {
+            const Record padding = {Padding, 0, 0, 0};
+            std::memcpy(at(head), &padding, sizeof(Record));
+        }
+        head += quint64(skip);
+    }
+
+    const Record record = {qint32(type), qint32(value), id, qint64(length)};
+    char *out = at(head);
+    std::memcpy(out, &record, sizeof(Record));
+    if (length > 0)
+        std::memcpy(out + sizeof(Record), text, std::size_t(length));
+
+    m_head.store(head + quint64(size), std::memory_order_release);
+    return true;
+}
+
+bool UiEventRing::pop(UiEvent *event)
+{
+    quint64 tail = m_tail.load(std::memory_order_relaxed);
+    if (m_held > 0)
+    {
+        tail += m_held;
+        m_held = 0;
+        m_tail.store(tail, std::memory_order_release);
+    }
+
+    for (;;)
+    {
+        const quint64 head = m_head.load(std::memory_order_acquire);
+        if (tail == head)
+            return false;
+
+        const qsizetype toEnd = m_capacity - qsizetype(tail & quint64(m_capacity - 1));
+        Record record = {Padding, 0, 0, 0};
+        if (toEnd >= qsizetype(sizeof(Record)))
+            std::memcpy(&record, at(tail), sizeof(Record));
+
+        if (record.type == Padding)
+        {
+            tail += quint64(toEnd);
+            m_tail.store(tail, std::memory_order_release);
+            continue;
+        }
+
+        event->type = record.type;
+        event->value = record.value;
+        event->id = record.id;
+        event->text = at(tail) + sizeof(Record);
+        event->text_length = record.length;
+        m_held = quint64(recordSize(qsizetype(record.length)));
+        return true;
+    }
+}
+
+bool UiEventRing::isEmpty() const
+{
+    return m_tail.load(std::memory_order_relaxed) + m_held == m_head.load(std::memory_order_acquire);
+}
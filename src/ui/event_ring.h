@@ -0,0 +1,67 @@
+// src/ui/event_ring.h
+// Ring buffer of tagged UI event records, written by the bridge and drained by Rust
+#ifndef EVENT_RING_H
+#define EVENT_RING_H
+
+#include "qt_bridge.h"
+#include <QtGlobal>
+#include <atomic>
+#include <vector>
+
+// ============ UI Event Ring ============
+// Single-producer, single-consumer byte ring. Each record is a fixed header
+// followed by its text, padded to 8 bytes; a record that would run past the
+// end of the buffer starts again at the front. The producer only moves the
+// head and the consumer only moves the tail, so neither side locks.
+//
+// A popped record's text points into the ring and stays valid until the
+// next pop, which is when its bytes are given back to the producer.
+class UiEventRing
+{
+public:
+    // Rounded up to a power of two, and to at least MinCapacity
+    explicit UiEventRing(qsizetype capacity);
+
+    UiEventRing(const UiEventRing &) = delete;
+    UiEventRing &operator=(const UiEventRing &) = delete;
+
+    static constexpr qsizetype MinCapacity = 4096;
+
+    qsizetype capacity() const { return m_capacity; }
+
+    // Producer only; false when there is no room (or the text could never fit)
+    bool push(int type, int value, qint64 id, const char *text, qsizetype length);
+
+    // Consumer only; false when the ring is empty
+    bool pop(UiEvent *event);
+
+    // Consumer only
+    bool isEmpty() const;
+
+private:
+    struct Record
+    {
+        qint32 type;
+        qint32 value;
+        qint64 id;
+        qint64 length;
+    };
+
+    // Marks the unused end of the buffer when a record wrapped to the front
+    static constexpr qint32 Padding = 0;
+
+    static qsizetype recordSize(qsizetype length);
+    char *at(quint64 position);
+
+    std::vector<quint64> m_storage;
+    qsizetype m_capacity;
+
+    // Byte counts since the start; their difference is the space in use
+    std::atomic<quint64> m_head;
+    std::atomic<quint64> m_tail;
+
+    // Bytes of the record last handed out by pop(), freed on the next one
+    quint64 m_held;
+};
+
+#endif // EVENT_RING_H
@@ -0,0 +1,170 @@
+// image_loader.cpp
+#include "image_loader.h"
+#include "image_scaler.h"
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QFile>
+#include <QImageReader>
+#include <QImageWriter>
+#include <QThread>
+#include <iterator>
+
+// ============ ImageLoader Implementation ============
+ImageLoader::ImageLoader(QObject *parent)
+    : QObject(parent), m_nextTicket(1)
+{
+    // Decoding a large photo is memory hungry; two at a time is plenty
+    m_pool.setMaxThreadCount(2);
+    m_pool.setThreadPriority(QThread::LowPriority);
+}
+
+quint64 ImageLoader::load(const QString &path, int maxSide)
+{
+    const quint64 ticket = m_nextTicket++;
+
+    m_pool.start([this, ticket, path, maxSide]()
+                 {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly))
+        {
+            finish(ticket, QImage(), ImageThumbnails(), file.errorString());
+            return;
+        }
+
+        decodeFile(ticket, file.readAll(), maxSide); });
+
+    return ticket;
+}
+
+quint64 ImageLoader::loadFileData(const QByteArray &file, int maxSide)
+{
+    const quint64 ticket = m_nextTicket++;
+
+    m_pool.start([this, ticket, file, maxSide]()
+                 { decodeFile(ticket, file, maxSide); });
+
+    return ticket;
+}
+
+quint64 ImageLoader::loadData(const QByteArray &data)
+{
+    const quint64 ticket = m_nextTicket++;
+
+    m_pool.start([this, ticket, data]()
+                 {
+        QString error;
+        const QImage image = decode(data, MaxDecodedSide, &error);
+        finish(ticket, image, ImageThumbnails(), error); });
+
+    return ticket;
+}
+
+void ImageLoader::decodeFile(quint64 ticket, const QByteArray &file, int maxSide)
+{
+    QString error;
+    QImage image = decode(file, MaxDecodedSide, &error);
+    ImageThumbnails thumbnails;
+    if (!image.isNull())
+    {
+        thumbnails = makeThumbnails(file, image);
+        if (qMax(image.width(), image.height()) > maxSide)
+            image = ImageScaler::scaled(image, maxSide);
+    }
+    finish(ticket, image, thumbnails, error);
+}
+
+void ImageLoader::finish(quint64 ticket, const QImage &image, const ImageThumbnails &thumbnails, const QString &error)
+{
+    QMetaObject::invokeMethod(this, [this, ticket, image, thumbnails, error]()
+                              {
+        if (image.isNull())
+            emit failed(ticket, error);
+        else
+            emit loaded(ticket, image, thumbnails); }, Qt::QueuedConnection);
+}
+
+QSize ImageLoader::displaySize(const QSize &imageSize)
+{
+    if (imageSize.isEmpty())
+        return QSize();
+
+    // Small pictures at their own size, the rest fitted to the text width
+    if (imageSize.width() <= DisplayWidth)
+        return imageSize;
+    return QSize(DisplayWidth, qMax(1, qRound(qreal(imageSize.height()) * DisplayWidth / imageSize.width())));
+}
+
+int ImageLoader::thumbnailSize(const QSize &displaySize, qreal devicePixelRatio)
+{
+    const qreal side = qMax(displaySize.width(), displaySize.height()) * devicePixelRatio;
+    for (const int size : ThumbnailSizes)
+    {
+        if (size >= side)
+            return size;
+    }
+    return ThumbnailSizes[std::size(ThumbnailSizes) - 1];
+}
+
+QString ImageLoader::cacheKey(const QString &hash, int size)
+{
+    return QStringLiteral("notequarry-thumb:%1:%2").arg(hash).arg(size);
+}
+
+QImage ImageLoader::decode(const QByteArray &data, int maxSide, QString *error)
+{
+    QBuffer buffer;
+    buffer.setData(data);
+    buffer.open(QIODevice::ReadOnly);
+    QImageReader reader(&buffer);
+    reader.setAutoTransform(true);
+
+    // Orientation is applied after decoding, so limit the longest side
+    // either way round
+    const QSize sourceSize = reader.size();
+    const int sourceSide = qMax(sourceSize.width(), sourceSize.height());
+    if (sourceSize.isValid() && sourceSide > 2 * maxSide && reader.supportsOption(QImageIOHandler::ScaledSize))
+    {
+        // JPEG decodes at 1/2, 1/4 or 1/8 scale almost for free; leave twice
+        // the target for the smooth pass so the result is not aliased
+        const qreal factor = qreal(2 * maxSide) / sourceSide;
+        reader.setScaledSize(sourceSize * factor);
+    }
+
+    QImage image = reader.read();
+    if (image.isNull())
+    {
+        if (error)
+            *error = reader.errorString();
+        return QImage();
+    }
+
+    if (qMax(image.width(), image.height()) > maxSide)
+        image = ImageScaler::scaled(image, maxSide);
+    return image;
+}
+
+ImageThumbnails ImageLoader::makeThumbnails(const QByteArray &file, const QImage &image)
+{
+    ImageThumbnails thumbnails;
+    thumbnails.hash = QString::fromLatin1(QCryptographicHash::hash(file, QCryptographicHash::Sha256).toHex());
+
+    // Photos as JPEG; PNG keeps transparency. Pictures smaller than a size
+    // are stored as they are, so every size can be looked up.
+    const char *format = image.hasAlphaChannel() ? "png" : "jpg";
+    QImage source = image;
+    for (int i = int(std::size(ThumbnailSizes)) - 1; i >= 0; --i)
+    {
+        const int size = ThumbnailSizes[i];
+        if (qMax(source.width(), source.height()) > size)
+            source = ImageScaler::scaled(source, size);
+
+        QByteArray encoded;
+        QBuffer buffer(&encoded);
+        buffer.open(QIODevice::WriteOnly);
+        QImageWriter writer(&buffer, format);
+        writer.setQuality(85);
+        writer.write(source);
+        thumbnails.encoded.prepend(encoded);
+    }
+    return thumbnails;
+}
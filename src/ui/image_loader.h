@@ -0,0 +1,84 @@
+// src/ui/image_loader.h
+// Background decoding of pictures inserted into pages and notes
+#ifndef IMAGE_LOADER_H
+#define IMAGE_LOADER_H
+
+#include <QByteArray>
+#include <QImage>
+#include <QList>
+#include <QObject>
+#include <QThreadPool>
+
+// Content hash of a decoded file and its thumbnails, encoded, one per
+// ImageLoader::ThumbnailSizes entry
+struct ImageThumbnails
+{
+    QString hash;
+    QList<QByteArray> encoded;
+};
+
+// ============ Image Loader ============
+// Decodes image files on worker threads, applying the EXIF orientation and
+// shrinking them to display resolution, so a 40-megapixel photo never holds
+// up typing. Large JPEGs are decoded at a reduced scale straight away; the
+// rest of the way is an area-averaging downscale by ImageScaler.
+//
+// Files are hashed (SHA-256) and thumbnailed in the same pass, so a picture
+// is only ever decoded in full once; afterwards it is drawn from the
+// smallest thumbnail that covers its shown size.
+class ImageLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Longest side of a decoded image, enough for DisplayWidth at 2x
+    static constexpr int MaxDecodedSide = 1600;
+
+    // Widest an image is shown in a document, in logical pixels
+    static constexpr int DisplayWidth = 600;
+
+    // Longest side of each stored thumbnail size
+    static constexpr int ThumbnailSizes[] = {256, 640, 1280};
+
+    // Decoded thumbnails kept in QPixmapCache, in KiB
+    static constexpr int PixmapCacheLimit = 48 * 1024;
+
+    explicit ImageLoader(QObject *parent = nullptr);
+
+    // Returns a ticket that identifies the result. Files are decoded and
+    // thumbnailed, then the image is shrunk to `maxSide`; data is a stored
+    // thumbnail and is only decoded. loadFileData() takes a whole file's
+    // bytes, e.g. read back from the blob store, and treats them as load().
+    quint64 load(const QString &path, int maxSide = MaxDecodedSide);
+    quint64 loadFileData(const QByteArray &file, int maxSide = MaxDecodedSide);
+    quint64 loadData(const QByteArray &data);
+
+    // Size an image of `imageSize` takes up in a document
+    static QSize displaySize(const QSize &imageSize);
+
+    // Smallest thumbnail size that is sharp at `displaySize`
+    static int thumbnailSize(const QSize &displaySize, qreal devicePixelRatio);
+
+    // QPixmapCache key of one size of a thumbnail
+    static QString cacheKey(const QString &hash, int size);
+
+signals:
+    // `thumbnails` is empty for loadData()
+    void loaded(quint64 ticket, const QImage &image, const ImageThumbnails &thumbnails);
+    void failed(quint64 ticket, const QString &error);
+
+private:
+    // Run on the workers
+    static QImage decode(const QByteArray &data, int maxSide, QString *error);
+    void decodeFile(quint64 ticket, const QByteArray &file, int maxSide);
+    static ImageThumbnails makeThumbnails(const QByteArray &file, const QImage &image);
+
+    void finish(quint64 ticket, const QImage &image, const ImageThumbnails &thumbnails, const QString &error);
+
+    quint64 m_nextTicket;
+
+    // Last, so its destructor waits for running decodes before the rest goes
+    QThreadPool m_pool;
+};
+
+#endif // IMAGE_LOADER_H
@@ -0,0 +1,230 @@
+// image_scaler.cpp
+#include "image_scaler.h"
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadPool>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define NOTEQUARRY_SCALER_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    // Source pixels under one destination pixel along one axis: `count`
+    // pixels from `first`, each weighted by how much of it is covered.
+    // The weights of a span add up to 1.
+    struct Span
+    {
+        int first;
+        int count;
+        int weights;
+    };
+
+    struct Spans
+    {
+        std::vector<Span> spans;
+        std::vector<float> weights;
+    };
+
+    Spans makeSpans(int sourceLength, int targetLength)
+    {
+        Spans result;
+        result.spans.reserve(targetLength);
+        const double scale = double(sourceLength) / targetLength;
+        for (int i = 0; i < targetLength; ++i)
+        {
+            const double start = i * scale;
+            const double end = std::min(double(sourceLength), (i + 1) * scale);
+            const int first = int(start);
+            const int last = std::min(sourceLength, int(std::ceil(end)));
+
+            Span span;
+            span.first = first;
+            span.count = last - first;
+            span.weights = int(result.weights.size());
+            for (int s = first; s < last; ++s)
+            {
+                const double covered = std::min(end, s + 1.0) - std::max(start, double(s));
+                result.weights.push_back(float(covered / (end - start)));
+            }
+            result.spans.push_back(span);
+        }
+        return result;
+    }
+
+    // row[i] += weight * source[i], over `count` bytes
+    void accumulateRowScalar(float *row, const uchar *source, int count, float weight)
+    {
+        for (int i = 0; i < count; ++i)
+            row[i] += weight * source[i];
+    }
+
+#ifdef NOTEQUARRY_SCALER_AVX2
+    __attribute__((target("avx2,fma"))) void accumulateRowAvx2(float *row, const uchar *source, int count, float weight)
+    {
+        const __m256 w = _mm256_set1_ps(weight);
+        int i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(source + i));
+            const __m256 values = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(bytes));
+            _mm256_storeu_ps(row + i, _mm256_fmadd_ps(values, w, _mm256_loadu_ps(row + i)));
+        }
+        accumulateRowScalar(row + i, source + i, count - i, weight);
+    }
+#endif
+
+    using AccumulateRow = void (*)(float *, const uchar *, int, float);
+
+    AccumulateRow accumulateRow()
+    {
+#ifdef NOTEQUARRY_SCALER_AVX2
+        static const AccumulateRow function = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")
+                                                  ? accumulateRowAvx2
+                                                  : accumulateRowScalar;
+        return function;
+#else
+        return accumulateRowScalar;
+#endif
+    }
+
+    struct Job
+    {
+        const uchar *source;
+        qsizetype sourceStride;
+        int sourceWidth;
+        uchar *target;
+        qsizetype targetStride;
+        const Spans *columns;
+        const Spans *rows;
+    };
+
+    // Destination rows [from, to) of a 4-byte-per-pixel image: the source
+    // rows under each are summed into one float row, which is then averaged
+    // across
+    void scaleBand(const Job &job, int from, int to)
+    {
+        const AccumulateRow accumulate = accumulateRow();
+        const int rowBytes = job.sourceWidth * 4;
+        std::vector<float> row(rowBytes);
+
+        for (int y = from; y < to; ++y)
+        {
+            const Span &vertical = job.rows->spans[y];
+            std::fill(row.begin(), row.end(), 0.0f);
+            for (int k = 0; k < vertical.count; ++k)
+            {
+                const uchar *line = job.source + (vertical.first + k) * job.sourceStride;
+                accumulate(row.data(), line, rowBytes, job.rows->weights[vertical.weights + k]);
+            }
+
+            uchar *out = job.target + y * job.targetStride;
+            for (const Span &horizontal : job.columns->spans)
+            {
+                float sum[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+                const float *pixel = row.data() + horizontal.first * 4;
+                const float *weights = job.columns->weights.data() + horizontal.weights;
+                for (int k = 0; k < horizontal.count; ++k, pixel += 4)
+                {
+                    for (int c = 0; c < 4; ++c)
+                        sum[c] += weights[k] * pixel[c];
+                }
+                for (int c = 0; c < 4; ++c)
+                    *out++ = uchar(std::min(255.0f, sum[c] + 0.5f));
+            }
+        }
+    }
+
+    // Kept apart from the global pool, which ImageLoader's callers may be
+    // waiting in
+    QThreadPool &scalerPool()
+    {
+        static QThreadPool pool;
+        return pool;
+    }
+
+    // Formats whose four bytes can be averaged as they are; everything else
+    // goes through premultiplied ARGB32
+    bool isAveragable(QImage::Format format)
+    {
+        switch (format)
+        {
+        case QImage::Format_RGB32:
+        case QImage::Format_ARGB32_Premultiplied:
+        case QImage::Format_RGBX8888:
+        case QImage::Format_RGBA8888_Premultiplied:
+            return true;
+        default:
+            return false;
+        }
+    }
+}
+
+// ============ ImageScaler Implementation ============
+QImage ImageScaler::scaled(const QImage &image, int maxSide)
+{
+    return scaled(image, image.size().scaled(maxSide, maxSide, Qt::KeepAspectRatio));
+}
+
+QImage ImageScaler::scaled(const QImage &image, const QSize &size)
+{
+    if (image.isNull() || size.isEmpty())
+        return QImage();
+    if (size == image.size())
+        return image;
+
+    if (size.width() > image.width() || size.height() > image.height())
+        return image.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+
+    // Averaging straight alpha would bleed the colour of clear pixels
+    const QImage source = isAveragable(image.format()) ? image : image.convertToFormat(image.hasAlphaChannel() ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32);
+    QImage target(size, source.format());
+    if (target.isNull())
+        return QImage();
+    target.setColorSpace(source.colorSpace());
+
+    const Spans columns = makeSpans(source.width(), size.width());
+    const Spans rows = makeSpans(source.height(), size.height());
+    Job job;
+    job.source = source.constBits();
+    job.sourceStride = source.bytesPerLine();
+    job.sourceWidth = source.width();
+    job.target = target.bits();
+    job.targetStride = target.bytesPerLine();
+    job.columns = &columns;
+    job.rows = &rows;
+
+    int bands = 1;
+    if (qint64(source.width()) * source.height() >= ParallelThreshold)
+        bands = qBound(1, size.height() / MinBandRows, QThread::idealThreadCount());
+
+    // The calling thread takes the last band itself
+    QSemaphore done;
+    const int bandRows = (size.height() + bands - 1) / bands;
+    for (int band = 0; band + 1 < bands; ++band)
+    {
+        const int from = band * bandRows;
+        const int to = std::min(size.height(), from + bandRows);
+        scalerPool().start([&job, &done, from, to]()
+                           {
+            scaleBand(job, from, to);
+            done.release(); });
+    }
+    scaleBand(job, std::min(size.height(), (bands - 1) * bandRows), size.height());
+    done.acquire(bands - 1);
+
+    return target;
+}
+
+bool ImageScaler::hasAvx2()
+{
+#ifdef NOTEQUARRY_SCALER_AVX2
+    return accumulateRow() == accumulateRowAvx2;
+#else
+    return false;
+#endif
+}
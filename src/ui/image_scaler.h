@@ -0,0 +1,35 @@
+// src/ui/image_scaler.h
+// Multithreaded area-averaging downscale of large pictures
+#ifndef IMAGE_SCALER_H
+#define IMAGE_SCALER_H
+
+#include <QImage>
+#include <QSize>
+
+// ============ Image Scaler ============
+// Shrinks an image by averaging every source pixel that falls under each
+// destination pixel, the same box filter QImage::scaled() uses for smooth
+// downscales. Rows are split into bands that run on all cores, and the
+// vertical pass (which touches every source pixel) uses AVX2 where the CPU
+// has it. Enlarging falls back to QImage::scaled().
+//
+// Safe to call from any thread, including ImageLoader's workers.
+class ImageScaler
+{
+public:
+    // Sources smaller than this, in pixels, are scaled on the calling
+    // thread alone
+    static constexpr qint64 ParallelThreshold = 1024 * 1024;
+
+    // Fewest destination rows handed to one thread
+    static constexpr int MinBandRows = 16;
+
+    // Fit within `maxSide` x `maxSide`, keeping the aspect ratio
+    static QImage scaled(const QImage &image, int maxSide);
+    static QImage scaled(const QImage &image, const QSize &size);
+
+    // Whether the AVX2 kernel is in use on this CPU
+    static bool hasAvx2();
+};
+
+#endif // IMAGE_SCALER_H
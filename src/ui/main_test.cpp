@@ -15,8 +15,12 @@ int main(int argc, char *argv[])
     window.show();
 
     // Test: Connect signals to debug output
-    QObject::connect(&window, &MainWindow::passwordSubmitted, [](const QString &pwd)
-                     { qDebug() << "Password submitted:" << (pwd.isEmpty() ? "<empty>" : "<hidden>"); });
+    QObject::connect(&window, &MainWindow::passwordSubmitted, [&window](const QString &pwd)
+                     {
+        qDebug() << "Password submitted:" << (pwd.isEmpty() ? "<empty>" : "<hidden>");
+        // Stands in for the key derivation worker
+        QTimer::singleShot(300, &window, [&window]()
+                           { window.finishUnlock(true, QString()); }); });
 
     QObject::connect(&window, &MainWindow::newEntryClicked, []()
                      { qDebug() << "New entry clicked"; });
@@ -24,8 +28,8 @@ int main(int argc, char *argv[])
     QObject::connect(&window, &MainWindow::entrySelected, [](int index)
                      { qDebug() << "Entry selected:" << index; });
 
-    QObject::connect(&window, &MainWindow::saveContent, [](const QString &content)
-                     { qDebug() << "Save content:" << content.left(50) << "..."; });
+    QObject::connect(&window, &MainWindow::saveContent, [](const QString &content, int page)
+                     { qDebug() << "Save content for page" << page << ":" << content.left(50) << "..."; });
 
     // Test: Populate with dummy data
     QStringList dummyEntries = {
@@ -1,30 +1,51 @@
 // mainwindow.cpp
 #include "mainwindow.h"
+#include "autosave.h"
+#include "book_scroll_view.h"
+#include "checkbox_object.h"
+#include "page_editor.h"
+#include "page_navigator.h"
+#include "page_prefetch.h"
+#include "page_thumbnails.h"
+#include "text_store.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QScrollArea>
 #include <QFrame>
 #include <QStyle>
 #include <QApplication>
+#include <QCloseEvent>
+#include <QFileDialog>
+#include <QHash>
 #include <QRegularExpression>
 #include <QKeyEvent>
+#include <QLocale>
 #include <QMessageBox>
 #include <QMenu>
+#include <QMetaMethod>
+#include <QMouseEvent>
+#include <QProgressBar>
+#include <QTextBlock>
+#include <QTextDocumentFragment>
+#include <QTimer>
 
 // ============ MainWindow Implementation ============
 MainWindow::MainWindow(QWidget *parent)
-    : QMainWindow(parent), m_stackedWidget(new QStackedWidget(this)), m_statusBar(nullptr), m_passwordDialog(nullptr), m_listViewWidget(nullptr), m_bookEditor(nullptr), m_noteEditor(nullptr), m_modeDialog(nullptr), m_currentPage(1), m_totalPages(1), m_wordCount(0)
+    : QMainWindow(parent), m_stackedWidget(new QStackedWidget(this)), m_statusBar(nullptr), m_saveLabel(nullptr), m_memoryLabel(nullptr), m_passwordDialog(nullptr), m_listViewWidget(nullptr), m_bookEditor(nullptr), m_noteEditor(nullptr), m_modeDialog(nullptr), m_autosave(nullptr), m_currentPage(1), m_totalPages(1), m_wordCount(0)
 {
     setupUI();
+    setupMenuBar();
     setupStatusBar();
     applyDarkTheme();
     updateWindowTitle();
 
-    // Show password dialog on startup
+    // Show password dialog on startup, once the event loop runs: the bridge
+    // registers its callbacks after construction, and the window keeps
+    // painting while the key is derived
     m_passwordDialog = new PasswordDialog(this);
     connect(m_passwordDialog, &PasswordDialog::passwordSubmitted,
             this, &MainWindow::passwordSubmitted);
-    m_passwordDialog->exec();
+    QTimer::singleShot(0, m_passwordDialog, &QDialog::open);
 }
 
 MainWindow::~MainWindow()
@@ -44,23 +65,51 @@ void MainWindow::setupUI()
     m_bookEditor = new BookEditor(this);
     m_stackedWidget->addWidget(m_bookEditor);
     connect(m_bookEditor, &BookEditor::backClicked, this, &MainWindow::onBackToList);
-    connect(m_bookEditor, &BookEditor::saveClicked, this, &MainWindow::saveContent);
+    connect(m_bookEditor, &BookEditor::saveClicked, this, &MainWindow::onSaveContent);
     connect(m_bookEditor, &BookEditor::previousPage, this, &MainWindow::onPreviousPage);
     connect(m_bookEditor, &BookEditor::nextPage, this, &MainWindow::onNextPage);
     connect(m_bookEditor, &BookEditor::addPage, this, &MainWindow::onAddPage);
-    connect(m_bookEditor, &BookEditor::insertImage, this, &MainWindow::insertImage);
-    connect(m_bookEditor, &BookEditor::contentChanged, [this](const QString &text)
+    connect(m_bookEditor, &BookEditor::imageInserted, this, &MainWindow::imageInserted);
+    connect(m_bookEditor, &BookEditor::thumbnailRequested, this, &MainWindow::thumbnailRequested);
+    connect(m_bookEditor, &BookEditor::originalRequested, this, &MainWindow::originalRequested);
+    connect(m_bookEditor, &BookEditor::thumbnailsReady, this, &MainWindow::thumbnailsReady);
+    connect(m_bookEditor, &BookEditor::splitPage, this, &MainWindow::splitPage);
+    connect(m_bookEditor, &BookEditor::prefetchPage, this, &MainWindow::prefetchPage);
+    connect(m_bookEditor, &BookEditor::pageChanged, this, [this](int page)
             {
-        m_wordCount = text.split(QRegularExpression("\\s+"), Qt::SkipEmptyParts).count();
-        m_bookEditor->setWordCount(m_wordCount); });
+        m_autosave->flush();
+        emit pageChanged(page); });
+    connect(m_bookEditor, &BookEditor::continuousChanged, this, [this](bool enabled)
+            {
+        // The scroll view reads pages back from storage
+        if (enabled)
+            m_autosave->flush(); });
+    connect(m_bookEditor, &BookEditor::wordCountChanged, [this](int count)
+            { m_wordCount = count; });
 
     // Setup note editor
     m_noteEditor = new NoteEditor(this);
     m_stackedWidget->addWidget(m_noteEditor);
     connect(m_noteEditor, &NoteEditor::backClicked, this, &MainWindow::onBackToList);
-    connect(m_noteEditor, &NoteEditor::saveClicked, this, &MainWindow::saveContent);
+    connect(m_noteEditor, &NoteEditor::saveClicked, this, &MainWindow::onSaveContent);
     connect(m_noteEditor, &NoteEditor::addCheckbox, this, &MainWindow::addCheckbox);
-    connect(m_noteEditor, &NoteEditor::insertImage, this, &MainWindow::insertImage);
+    connect(m_noteEditor, &NoteEditor::checkboxToggled, this, &MainWindow::checkboxToggled);
+    connect(m_noteEditor, &NoteEditor::imageInserted, this, &MainWindow::imageInserted);
+    connect(m_noteEditor, &NoteEditor::thumbnailRequested, this, &MainWindow::thumbnailRequested);
+    connect(m_noteEditor, &NoteEditor::originalRequested, this, &MainWindow::originalRequested);
+    connect(m_noteEditor, &NoteEditor::thumbnailsReady, this, &MainWindow::thumbnailsReady);
+
+    // Autosave every editor document
+    m_autosave = new AutosaveScheduler(this);
+    for (TextStore *store : m_bookEditor->findChildren<TextStore *>())
+        m_autosave->track(store);
+    for (TextStore *store : m_noteEditor->findChildren<TextStore *>())
+        m_autosave->track(store);
+    connect(m_bookEditor, &BookEditor::textStoreCreated, m_autosave, &AutosaveScheduler::track);
+    connect(m_autosave, &AutosaveScheduler::saveRequested, this, &MainWindow::saveStore);
+    connect(m_autosave, &AutosaveScheduler::saveFinished, this, &MainWindow::onSaveFinished);
+    connect(m_autosave, &AutosaveScheduler::dirtyChanged, this, [this](bool dirty)
+            { if (dirty) m_saveLabel->setText(tr("Unsaved changes")); });
 
     // Show list view by default
     m_stackedWidget->setCurrentWidget(m_listViewWidget);
@@ -85,6 +134,10 @@ void MainWindow::setupMenuBar()
     connect(m_saveAction, &QAction::triggered, this, &MainWindow::onSaveContent);
     fileMenu->addAction(m_saveAction);
 
+    // Ctrl+S flushes through the scheduler, so it is only live while some
+    // store holds unsaved edits
+    connect(m_autosave, &AutosaveScheduler::dirtyChanged, m_saveAction, &QAction::setEnabled);
+
     fileMenu->addSeparator();
 
     QAction *exitAction = new QAction(tr("E&xit"), this);
@@ -97,20 +150,51 @@ void MainWindow::setupMenuBar()
 
     QAction *undoAction = editMenu->addAction(tr("&Undo"));
     undoAction->setShortcut(QKeySequence::Undo);
+    connect(undoAction, &QAction::triggered, this, [this]()
+            { undoRedo(false); });
 
     QAction *redoAction = editMenu->addAction(tr("&Redo"));
     redoAction->setShortcut(QKeySequence::Redo);
+    connect(redoAction, &QAction::triggered, this, [this]()
+            { undoRedo(true); });
+
+    // The editors take the shortcuts while focused; the menu follows the
+    // shown editor's TextStore
+    connect(editMenu, &QMenu::aboutToShow, this, [this, undoAction, redoAction]()
+            {
+        TextStore *store = currentTextStore();
+        undoAction->setEnabled(store && store->canUndo());
+        redoAction->setEnabled(store && store->canRedo()); });
+    connect(editMenu, &QMenu::aboutToHide, this, [undoAction, redoAction]()
+            {
+        // Left disabled, the shortcuts would stay dead outside the editors
+        undoAction->setEnabled(true);
+        redoAction->setEnabled(true); });
 
     editMenu->addSeparator();
 
+    // The clipboard actions go to whichever text field has focus
+    const auto focusSlot = [](const char *slot)
+    {
+        return [slot]()
+        {
+            QWidget *focus = QApplication::focusWidget();
+            if (focus && focus->metaObject()->indexOfSlot(QByteArray(slot).append("()").constData()) >= 0)
+                QMetaObject::invokeMethod(focus, slot);
+        };
+    };
+
     QAction *cutAction = editMenu->addAction(tr("Cu&t"));
     cutAction->setShortcut(QKeySequence::Cut);
+    connect(cutAction, &QAction::triggered, this, focusSlot("cut"));
 
     QAction *copyAction = editMenu->addAction(tr("&Copy"));
     copyAction->setShortcut(QKeySequence::Copy);
+    connect(copyAction, &QAction::triggered, this, focusSlot("copy"));
 
     QAction *pasteAction = editMenu->addAction(tr("&Paste"));
     pasteAction->setShortcut(QKeySequence::Paste);
+    connect(pasteAction, &QAction::triggered, this, focusSlot("paste"));
 
     // View Menu
     QMenu *viewMenu = menuBar->addMenu(tr("&View"));
@@ -137,6 +221,27 @@ void MainWindow::setupStatusBar()
 {
     m_statusBar = statusBar();
     m_statusBar->showMessage(tr("Ready"));
+
+    m_saveLabel = new QLabel;
+    m_statusBar->addPermanentWidget(m_saveLabel);
+
+    m_memoryLabel = new QLabel;
+    m_statusBar->addPermanentWidget(m_memoryLabel);
+
+    QTimer *memoryTimer = new QTimer(this);
+    connect(memoryTimer, &QTimer::timeout, this, &MainWindow::updateMemoryLabel);
+    memoryTimer->start(30000);
+}
+
+void MainWindow::updateMemoryLabel()
+{
+    qint64 bytes = 0;
+    if (m_bookEditor)
+        bytes += m_bookEditor->textStore()->memoryUsage();
+    if (m_noteEditor)
+        bytes += m_noteEditor->textStore()->memoryUsage();
+
+    m_memoryLabel->setText(tr("Text store: %1").arg(QLocale().formattedDataSize(bytes)));
 }
 
 void MainWindow::setupListView()
@@ -347,7 +452,7 @@ void MainWindow::applyDarkTheme()
             background-color: #1a1a1a;
         }
         
-        QTextEdit {
+        QTextEdit, QPlainTextEdit {
             background-color: #252525;
             border: 2px solid #2d5016;
             border-radius: 6px;
@@ -359,7 +464,7 @@ void MainWindow::applyDarkTheme()
             selection-background-color: #2d5016;
         }
         
-        QTextEdit:focus {
+        QTextEdit:focus, QPlainTextEdit:focus {
             border: 2px solid #5a8c3a;
         }
         
@@ -504,8 +609,64 @@ void MainWindow::setCurrentEntryTitle(const QString &title)
 
 void MainWindow::setCurrentContent(const QString &content)
 {
+    // Only the shown editor takes it: a note loaded into the book editor
+    // would be cached as the last page and prefetched around
+    if (m_stackedWidget->currentWidget() == m_noteEditor)
+    {
+        m_noteEditor->setContent(content);
+        return;
+    }
+    if (m_stackedWidget->currentWidget() != m_bookEditor)
+        return;
     m_bookEditor->setContent(content);
-    m_noteEditor->setContent(content);
+
+    // A page shown again with its unsaved edits is saved once this load,
+    // which Rust is still in the middle of, has returned
+    TextStore *store = m_bookEditor->textStore();
+    if (store && store->isModified())
+        QTimer::singleShot(0, m_autosave, &AutosaveScheduler::flush);
+}
+
+void MainWindow::setNoteCheckboxes(const QList<qint64> &ids, const QList<bool> &checked)
+{
+    m_noteEditor->setCheckboxes(ids, checked);
+}
+
+void MainWindow::setCheckboxId(int index, qint64 id)
+{
+    m_noteEditor->setCheckboxId(index, id);
+}
+
+void MainWindow::pageSplit(int page, int keepLength)
+{
+    m_bookEditor->pageSplit(page, keepLength);
+}
+
+void MainWindow::setImages(const QList<StoredImage> &images)
+{
+    // Placed into the content, so they go where setCurrentContent() put it
+    if (m_stackedWidget->currentWidget() == m_bookEditor)
+        m_bookEditor->setImages(images);
+    else if (m_stackedWidget->currentWidget() == m_noteEditor)
+        m_noteEditor->setImages(images);
+}
+
+void MainWindow::setImageId(int position, qint64 id)
+{
+    m_bookEditor->setImageId(position, id);
+    m_noteEditor->setImageId(position, id);
+}
+
+void MainWindow::provideThumbnail(const QString &hash, int size, const QByteArray &data)
+{
+    m_bookEditor->provideThumbnail(hash, size, data);
+    m_noteEditor->provideThumbnail(hash, size, data);
+}
+
+void MainWindow::provideOriginal(qint64 id, const QByteArray &data)
+{
+    m_bookEditor->provideOriginal(id, data);
+    m_noteEditor->provideOriginal(id, data);
 }
 
 void MainWindow::setCurrentPage(int page)
@@ -526,6 +687,16 @@ void MainWindow::setWordCount(int count)
     m_bookEditor->setWordCount(count);
 }
 
+void MainWindow::setAutosaveInterval(int msec)
+{
+    m_autosave->setIdleInterval(msec);
+}
+
+void MainWindow::providePageContent(int page, const QString &content)
+{
+    m_bookEditor->addPrefetchedContent(page, content);
+}
+
 void MainWindow::setPasswordError(const QString &error)
 {
     if (m_passwordDialog)
@@ -542,6 +713,14 @@ void MainWindow::setShowPasswordError(bool show)
     }
 }
 
+void MainWindow::finishUnlock(bool unlocked, const QString &error)
+{
+    if (m_passwordDialog)
+    {
+        m_passwordDialog->finishUnlock(unlocked, error);
+    }
+}
+
 QString MainWindow::getCurrentContent() const
 {
     if (m_stackedWidget->currentWidget() == m_bookEditor)
@@ -555,6 +734,31 @@ QString MainWindow::getCurrentContent() const
     return QString();
 }
 
+void MainWindow::undoRedo(bool redo)
+{
+    if (m_stackedWidget->currentWidget() == m_bookEditor)
+    {
+        m_bookEditor->undoRedo(redo);
+    }
+    else if (m_stackedWidget->currentWidget() == m_noteEditor)
+    {
+        m_noteEditor->undoRedo(redo);
+    }
+}
+
+TextStore *MainWindow::currentTextStore() const
+{
+    if (m_stackedWidget->currentWidget() == m_bookEditor)
+    {
+        return m_bookEditor->textStore();
+    }
+    else if (m_stackedWidget->currentWidget() == m_noteEditor)
+    {
+        return m_noteEditor->textStore();
+    }
+    return nullptr;
+}
+
 int MainWindow::getCurrentPage() const
 {
     return m_bookEditor->getCurrentPage();
@@ -563,18 +767,21 @@ int MainWindow::getCurrentPage() const
 void MainWindow::showListView()
 {
     m_stackedWidget->setCurrentWidget(m_listViewWidget);
+    m_backAction->setEnabled(false);
     updateWindowTitle();
 }
 
 void MainWindow::showBookEditor()
 {
     m_stackedWidget->setCurrentWidget(m_bookEditor);
+    m_backAction->setEnabled(true);
     updateWindowTitle();
 }
 
 void MainWindow::showNoteEditor()
 {
     m_stackedWidget->setCurrentWidget(m_noteEditor);
+    m_backAction->setEnabled(true);
     updateWindowTitle();
 }
 
@@ -624,9 +831,73 @@ void MainWindow::onDeleteEntry()
 
 void MainWindow::onSaveContent()
 {
-    QString content = getCurrentContent();
-    emit saveContent(content);
-    m_statusBar->showMessage(tr("Entry saved"), 3000);
+    // Explicit saves go through the scheduler too, so repeated Ctrl+S
+    // presses on an unchanged page do not write anything
+    if (!m_autosave->isDirty())
+    {
+        m_statusBar->showMessage(tr("No changes to save"), 3000);
+        return;
+    }
+    m_autosave->flush();
+}
+
+void MainWindow::saveStore(TextStore *store)
+{
+    // Every store is saved to the page it holds, which need not be the one
+    // Rust has open: a cached page left dirty, or a page turn not yet applied
+    const int page = store == m_noteEditor->textStore() ? 0 : m_bookEditor->pageOfStore(store);
+    if (page < 0)
+        return;
+
+    // Send only the edits since the last save when the bridge takes deltas;
+    // the bridge marks the revision saved once Rust has stored it
+    if (isSignalConnected(QMetaMethod::fromSignal(&MainWindow::saveDelta)))
+    {
+        emit saveDelta(store, page);
+    }
+    else
+    {
+        const qint64 revision = store->revision();
+        emit saveContent(store->snapshot().toString(), page);
+        store->markSaved(revision);
+    }
+
+    if (!store->isModified())
+    {
+        m_bookEditor->pageSaved(store);
+
+        // Rows follow the items left in the text once it is stored
+        QList<qint64> checkboxIds;
+        QList<int> checkboxPositions;
+        if (store == m_noteEditor->textStore() && m_noteEditor->checkboxPositions(&checkboxIds, &checkboxPositions))
+            emit checkboxOrderChanged(checkboxIds, checkboxPositions);
+
+        QList<qint64> imageIds;
+        QList<int> imagePositions;
+        if (store == m_bookEditor->textStore() && m_bookEditor->imagePositions(&imageIds, &imagePositions))
+            emit imagePositionsChanged(imageIds, imagePositions);
+        else if (store == m_noteEditor->textStore() && m_noteEditor->imagePositions(&imageIds, &imagePositions))
+            emit imagePositionsChanged(imageIds, imagePositions);
+    }
+}
+
+void MainWindow::onSaveFinished(bool saved, qint64 revision, qint64 elapsedMs)
+{
+    if (saved)
+    {
+        m_saveLabel->setText(tr("Saved in %1 ms").arg(elapsedMs));
+    }
+    else
+    {
+        m_saveLabel->setText(tr("Save failed"));
+        m_statusBar->showMessage(tr("Could not save revision %1").arg(revision), 5000);
+    }
+}
+
+void MainWindow::closeEvent(QCloseEvent *event)
+{
+    m_autosave->flush();
+    QMainWindow::closeEvent(event);
 }
 
 void MainWindow::onSearchTextChanged(const QString &text)
@@ -644,6 +915,8 @@ void MainWindow::onPreviousPage()
 {
     if (m_currentPage > 1)
     {
+        // The page's edits must be stored before its content is replaced
+        m_autosave->flush();
         emit pageChanged(m_currentPage - 1);
     }
 }
@@ -652,24 +925,27 @@ void MainWindow::onNextPage()
 {
     if (m_currentPage < m_totalPages)
     {
+        m_autosave->flush();
         emit pageChanged(m_currentPage + 1);
     }
 }
 
 void MainWindow::onAddPage()
 {
+    m_autosave->flush();
     emit addNewPage();
 }
 
 void MainWindow::onBackToList()
 {
+    m_autosave->flush();
     showListView();
     emit backToList();
 }
 
 // ============ PasswordDialog Implementation ============
 PasswordDialog::PasswordDialog(QWidget *parent)
-    : QDialog(parent)
+    : QDialog(parent), m_busy(false)
 {
     setModal(true);
     setFixedSize(420, 320);
@@ -720,6 +996,13 @@ PasswordDialog::PasswordDialog(QWidget *parent)
     errorLayout->addWidget(errorIcon);
     errorLayout->addWidget(m_errorLabel, 1);
 
+    // Shown while the key is derived; Argon2 reports no progress of its own
+    m_progressBar = new QProgressBar;
+    m_progressBar->setRange(0, 0);
+    m_progressBar->setTextVisible(false);
+    m_progressBar->setMaximumHeight(6);
+    m_progressBar->setVisible(false);
+
     // Buttons
     QHBoxLayout *buttonLayout = new QHBoxLayout;
     buttonLayout->setSpacing(10);
@@ -789,6 +1072,7 @@ PasswordDialog::PasswordDialog(QWidget *parent)
     mainLayout->addSpacing(10);
     mainLayout->addWidget(m_passwordInput);
     mainLayout->addWidget(m_errorWidget);
+    mainLayout->addWidget(m_progressBar);
     mainLayout->addSpacing(10);
     mainLayout->addLayout(buttonLayout);
     mainLayout->addWidget(infoLabel);
@@ -829,6 +1113,9 @@ void PasswordDialog::setShowError(bool show)
 
 void PasswordDialog::accept()
 {
+    if (m_busy)
+        return;
+
     QString password = m_passwordInput->text().trimmed();
 
     if (password.isEmpty())
@@ -838,8 +1125,45 @@ void PasswordDialog::accept()
         return;  // ← Don't close dialog!
     }
 
+    // Closed by finishUnlock() once the key is ready
+    setShowError(false);
+    setBusy(true);
     emit passwordSubmitted(password);
-    QDialog::accept();  // ← Only close if password valid
+}
+
+void PasswordDialog::reject()
+{
+    if (m_busy)
+        return;
+    QDialog::reject();
+}
+
+void PasswordDialog::finishUnlock(bool unlocked, const QString &error)
+{
+    if (!m_busy)
+        return;
+
+    setBusy(false);
+    if (unlocked)
+    {
+        m_passwordInput->clear();
+        QDialog::accept();
+        return;
+    }
+
+    setErrorMessage(error);
+    setShowError(true);
+    m_passwordInput->selectAll();
+    m_passwordInput->setFocus();
+}
+
+void PasswordDialog::setBusy(bool busy)
+{
+    m_busy = busy;
+    m_passwordInput->setEnabled(!busy);
+    m_unlockButton->setEnabled(!busy);
+    m_unlockButton->setText(busy ? tr("Unlocking...") : tr("Unlock"));
+    m_progressBar->setVisible(busy);
 }
 
 void PasswordDialog::keyPressEvent(QKeyEvent *event)
@@ -1023,9 +1347,23 @@ void ModeSelectionDialog::keyPressEvent(QKeyEvent *event)
 
 // ============ BookEditor Implementation ============
 BookEditor::BookEditor(QWidget *parent)
-    : QWidget(parent), m_currentPage(1), m_totalPages(1), m_wordCount(0)
+    : QWidget(parent), m_prefetcher(new PagePrefetcher(this)), m_navigator(new PageNavigator(this)), m_currentPage(1), m_totalPages(1), m_wordCount(0), m_blockCount(1), m_autoPaginate(false), m_splitPending(false), m_loadingContent(false), m_pendingCaretOffset(-1)
 {
     setupUI();
+
+    // Prefetched pages arrive with their word counts cached, like a page
+    // that has been shown before
+    m_prefetcher->setPrepare([](QTextDocument *document)
+                             {
+        for (QTextBlock block = document->begin(); block.isValid(); block = block.next())
+            block.setUserState(countWords(block.text())); });
+    connect(m_prefetcher, &PagePrefetcher::requestPage, this, &BookEditor::onPrefetchRequested);
+    connect(m_prefetcher, &PagePrefetcher::documentReady, this, &BookEditor::onPrefetchedDocument);
+
+    connect(m_navigator, &PageNavigator::navigate, this, [this](int page)
+            {
+        m_currentPage = page;
+        emit pageChanged(page); });
 }
 
 void BookEditor::setupUI()
@@ -1078,24 +1416,50 @@ void BookEditor::setupUI()
     infoLayout->addStretch();
     infoLayout->addWidget(m_wordCountLabel);
 
-    // Content editor
-    QScrollArea *scrollArea = new QScrollArea;
-    scrollArea->setWidgetResizable(true);
-    scrollArea->setFrameShape(QFrame::NoFrame);
-    scrollArea->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
-
-    QWidget *editorContainer = new QWidget;
-    QVBoxLayout *editorLayout = new QVBoxLayout(editorContainer);
-    editorLayout->setContentsMargins(40, 30, 40, 30);
-
-    m_contentEditor = new QTextEdit;
-    m_contentEditor->setMinimumHeight(500);
-    m_contentEditor->setAcceptRichText(false);
-    m_contentEditor->setTabStopDistance(40);
-    connect(m_contentEditor, &QTextEdit::textChanged, this, &BookEditor::onContentChanged);
-
-    editorLayout->addWidget(m_contentEditor);
-    scrollArea->setWidget(editorContainer);
+    // Content editor. The text edit is the only scroller; the page margin
+    // is the editor's own, so resizes and keystrokes lay out one viewport
+    m_contentEditor = new PageEditor;
+    m_contentEditor->setContentsMargins(40, 30, 40, 30);
+    connect(m_contentEditor, &PageEditor::textChanged, this, &BookEditor::onContentChanged);
+    connect(m_contentEditor, &PageEditor::contentsChange, this, &BookEditor::onContentsChange);
+    connect(m_contentEditor, &PageEditor::textStoreCreated, this, &BookEditor::textStoreCreated);
+    connect(m_contentEditor, &PageEditor::largeInsertFinished, [this]()
+            {
+        // Splits are held back while a large paste is streaming in
+        setAutoPaginate(m_autoPaginate); });
+    connect(m_contentEditor, &PageEditor::imageInserted, this, &BookEditor::imageInserted);
+    connect(m_contentEditor, &PageEditor::thumbnailRequested, this, &BookEditor::thumbnailRequested);
+    connect(m_contentEditor, &PageEditor::originalRequested, this, &BookEditor::originalRequested);
+    connect(m_contentEditor, &PageEditor::thumbnailsReady, this, &BookEditor::thumbnailsReady);
+    connect(m_contentEditor, &PageEditor::imageFailed, this, [this](const QString &path, const QString &error)
+            { QMessageBox::warning(this, tr("Insert Image"), tr("Could not load %1:\n%2").arg(path, error)); });
+
+    m_pageView = m_contentEditor;
+
+    // Continuous scroll through the whole book, read-only
+    m_scrollView = new BookScrollView;
+    connect(m_scrollView, &BookScrollView::pageRequested, this, &BookEditor::prefetchPage);
+    connect(m_scrollView, &BookScrollView::pageActivated, this, &BookEditor::onScrollPageActivated);
+    connect(m_scrollView, &BookScrollView::currentPageChanged, [this](int page)
+            { m_pageInfoLabel->setText(tr("Page %1 of %2").arg(page).arg(m_totalPages)); });
+
+    m_viewStack = new QStackedWidget;
+    m_viewStack->addWidget(m_pageView);
+    m_viewStack->addWidget(m_scrollView);
+
+    // Page overview sidebar
+    m_thumbnailModel = new PageThumbnailModel(this);
+    connect(m_thumbnailModel, &PageThumbnailModel::pageRequested, this, &BookEditor::onThumbnailRequested);
+    m_thumbnailStrip = new PageThumbnailStrip(m_thumbnailModel);
+    m_thumbnailStrip->hide();
+    connect(m_thumbnailStrip, &PageThumbnailStrip::pageActivated, this, &BookEditor::onThumbnailActivated);
+
+    QWidget *contentRow = new QWidget;
+    QHBoxLayout *contentLayout = new QHBoxLayout(contentRow);
+    contentLayout->setContentsMargins(0, 0, 0, 0);
+    contentLayout->setSpacing(0);
+    contentLayout->addWidget(m_thumbnailStrip);
+    contentLayout->addWidget(m_viewStack);
 
     // Toolbar
     QWidget *toolbar = new QWidget;
@@ -1106,10 +1470,30 @@ void BookEditor::setupUI()
     toolbarLayout->setSpacing(10);
 
     m_imageButton = new QPushButton(tr("🖼️ Insert Image"));
-    connect(m_imageButton, &QPushButton::clicked, this, &BookEditor::insertImage);
+    connect(m_imageButton, &QPushButton::clicked, this, &BookEditor::onInsertImageClicked);
+
+    m_autoPaginateCheck = new QCheckBox(tr("Auto-paginate"));
+    m_autoPaginateCheck->setToolTip(tr("Move text past %1 words onto the next page").arg(PageWordBudget));
+    connect(m_autoPaginateCheck, &QCheckBox::toggled, this, &BookEditor::setAutoPaginate);
+
+    m_continuousCheck = new QCheckBox(tr("Continuous scroll"));
+    m_continuousCheck->setToolTip(tr("Read all pages in one scroll; double-click a page to edit it"));
+    connect(m_continuousCheck, &QCheckBox::toggled, this, &BookEditor::setContinuous);
+
+    m_overviewCheck = new QCheckBox(tr("Page overview"));
+    m_overviewCheck->setToolTip(tr("Show miniature pages to jump between"));
+    connect(m_overviewCheck, &QCheckBox::toggled, this, &BookEditor::setOverviewVisible);
+
+    m_markdownCheck = new QCheckBox(tr("Markdown"));
+    m_markdownCheck->setToolTip(tr("Highlight Markdown headings, emphasis, lists and code"));
+    connect(m_markdownCheck, &QCheckBox::toggled, m_contentEditor, &PageEditor::setMarkdownEnabled);
 
     toolbarLayout->addWidget(m_imageButton);
     toolbarLayout->addStretch();
+    toolbarLayout->addWidget(m_markdownCheck);
+    toolbarLayout->addWidget(m_overviewCheck);
+    toolbarLayout->addWidget(m_continuousCheck);
+    toolbarLayout->addWidget(m_autoPaginateCheck);
 
     // Navigation footer
     QWidget *footer = new QWidget;
@@ -1131,6 +1515,7 @@ void BookEditor::setupUI()
     m_pageSpinBox->setButtonSymbols(QAbstractSpinBox::NoButtons);
     connect(m_pageSpinBox, QOverload<int>::of(&QSpinBox::valueChanged),
             this, &BookEditor::onPageSpinBoxChanged);
+    connect(m_pageSpinBox, &QSpinBox::editingFinished, m_navigator, &PageNavigator::commit);
 
     m_nextButton = new QPushButton(tr("Next ▶"));
     m_nextButton->setMinimumWidth(100);
@@ -1149,7 +1534,7 @@ void BookEditor::setupUI()
 
     mainLayout->addWidget(headerWidget);
     mainLayout->addWidget(infoBar);
-    mainLayout->addWidget(scrollArea);
+    mainLayout->addWidget(contentRow);
     mainLayout->addWidget(toolbar);
     mainLayout->addWidget(footer);
 
@@ -1161,22 +1546,109 @@ void BookEditor::setupUI()
 void BookEditor::setEntryTitle(const QString &title)
 {
     m_titleLabel->setText(title);
+
+    // Cached pages belong to the entry that was open before
+    clearPageCache();
+    m_scrollView->clear();
+    m_thumbnailModel->clear();
 }
 
 void BookEditor::setContent(const QString &content)
 {
-    m_contentEditor->blockSignals(true);
-    m_contentEditor->setPlainText(content);
-    m_contentEditor->blockSignals(false);
-    onContentChanged();
+    // Loading a page never triggers a split; only edits made here do
+    m_loadingContent = true;
+
+    // Note how the page being left looks, so coming back to it can reuse
+    // its document
+    if (!m_pageCache.isEmpty() && m_contentEditor->document() == m_pageCache.first().document)
+    {
+        CachedPage &shown = m_pageCache.first();
+        TextStore *store = TextStore::forDocument(shown.document);
+        if (store->revision() != 0)
+        {
+            shown.contentHash = qHash(store->snapshot().toString());
+        }
+        shown.caret = m_contentEditor->textCursor().position();
+    }
+
+    const size_t contentHash = qHash(content);
+    const int index = cachedPageIndex(m_currentPage);
+    TextStore *cachedStore = index >= 0 ? TextStore::forDocument(m_pageCache.at(index).document) : nullptr;
+
+    int caret = 0;
+    if (cachedStore && cachedStore->isModified())
+    {
+        // Edits that never reached storage are newer than the text loaded,
+        // so the page is shown as it was left and its next save sends it whole
+        const CachedPage cached = m_pageCache.takeAt(index);
+        m_pageCache.prepend(cached);
+        cachedStore->invalidateBase();
+        m_contentEditor->setDocument(cached.document);
+        caret = cached.caret;
+    }
+    else if (cachedStore && m_pageCache.at(index).contentHash == contentHash &&
+             cachedStore->size() == content.size() && cachedStore->snapshot().toString() == content)
+    {
+        // Same text as the cached document: swap it in, no relayout
+        const CachedPage cached = m_pageCache.takeAt(index);
+        m_pageCache.prepend(cached);
+        TextStore::forDocument(cached.document)->markLoaded();
+        m_contentEditor->setDocument(cached.document);
+        caret = cached.caret;
+    }
+    else
+    {
+        if (index >= 0)
+        {
+            const CachedPage stale = m_pageCache.takeAt(index);
+            if (m_contentEditor->document() == stale.document)
+                m_contentEditor->setDocument(nullptr);
+            delete stale.document;
+        }
+
+        if (content.size() > PageEditor::LargeDocumentThreshold)
+        {
+            // The large-document editor keeps a single document
+            m_contentEditor->setPlainText(content);
+        }
+        else
+        {
+            QTextDocument *document = m_contentEditor->createDocument(content, this);
+            m_pageCache.prepend({m_currentPage, document, contentHash, 0});
+            m_contentEditor->setDocument(document);
+
+            // The shown page is always first, so it is never evicted
+            while (m_pageCache.size() > PageCacheSize)
+                delete m_pageCache.takeLast().document;
+        }
+    }
+
+    m_loadingContent = false;
+    refreshWordCount();
+
+    // Caret followed overflow text onto this page
+    if (m_pendingCaretOffset >= 0)
+    {
+        caret = m_pendingCaretOffset;
+        m_pendingCaretOffset = -1;
+    }
+    QTextCursor cursor = m_contentEditor->textCursor();
+    cursor.setPosition(qMin(caret, content.length()));
+    m_contentEditor->setTextCursor(cursor);
+
+    m_prefetcher->pageShown(m_currentPage);
 }
 
 void BookEditor::setCurrentPage(int page)
 {
+    // Another page turn supersedes a number still being typed
+    m_navigator->cancel();
     m_currentPage = page;
     m_pageSpinBox->blockSignals(true);
     m_pageSpinBox->setValue(page);
     m_pageSpinBox->blockSignals(false);
+    if (m_thumbnailStrip->isVisible())
+        m_thumbnailStrip->setCurrentPage(page);
     updateNavigationButtons();
     updatePageInfo();
 }
@@ -1185,6 +1657,8 @@ void BookEditor::setTotalPages(int total)
 {
     m_totalPages = total;
     m_pageSpinBox->setMaximum(total);
+    m_scrollView->setPageCount(total);
+    m_thumbnailModel->setPageCount(total);
     updateNavigationButtons();
     updatePageInfo();
 }
@@ -1195,6 +1669,133 @@ void BookEditor::setWordCount(int count)
     updateWordCount();
 }
 
+void BookEditor::setAutoPaginate(bool enabled)
+{
+    m_autoPaginate = enabled;
+    m_autoPaginateCheck->blockSignals(true);
+    m_autoPaginateCheck->setChecked(enabled);
+    m_autoPaginateCheck->blockSignals(false);
+
+    if (enabled && m_wordCount > PageWordBudget && !m_splitPending)
+    {
+        m_splitPending = true;
+        QTimer::singleShot(0, this, &BookEditor::splitOverflow);
+    }
+}
+
+TextStore *BookEditor::textStore() const
+{
+    return m_contentEditor->textStore();
+}
+
+void BookEditor::undoRedo(bool redo)
+{
+    m_contentEditor->undoRedo(redo);
+}
+
+bool BookEditor::autoPaginate() const
+{
+    return m_autoPaginate;
+}
+
+void BookEditor::setContinuous(bool enabled)
+{
+    m_continuousCheck->blockSignals(true);
+    m_continuousCheck->setChecked(enabled);
+    m_continuousCheck->blockSignals(false);
+    if (enabled == isContinuous())
+        return;
+
+    emit continuousChanged(enabled);
+    if (enabled)
+    {
+        m_scrollView->setDocumentStyle(m_contentEditor->documentStyle());
+        m_scrollView->setPageCount(m_totalPages);
+
+        // Positioned before it shows, so the first pages asked for are these
+        m_scrollView->scrollToPage(m_currentPage);
+        m_viewStack->setCurrentWidget(m_scrollView);
+    }
+    else
+    {
+        m_viewStack->setCurrentWidget(m_pageView);
+
+        // Nothing is kept for next time; the view fills back in on demand
+        m_scrollView->clear();
+        updatePageInfo();
+    }
+
+    m_imageButton->setEnabled(!enabled);
+    m_autoPaginateCheck->setEnabled(!enabled);
+}
+
+bool BookEditor::isContinuous() const
+{
+    return m_viewStack->currentWidget() == m_scrollView;
+}
+
+void BookEditor::setOverviewVisible(bool visible)
+{
+    m_overviewCheck->blockSignals(true);
+    m_overviewCheck->setChecked(visible);
+    m_overviewCheck->blockSignals(false);
+
+    if (visible)
+    {
+        m_thumbnailModel->setDocumentStyle(m_contentEditor->documentStyle());
+        m_thumbnailModel->setPageCount(m_totalPages);
+    }
+    m_thumbnailStrip->setVisible(visible);
+    if (visible)
+        m_thumbnailStrip->setCurrentPage(m_currentPage);
+}
+
+void BookEditor::pageSaved(TextStore *store)
+{
+    if (store == textStore())
+        m_thumbnailModel->invalidatePage(m_currentPage);
+}
+
+void BookEditor::setImages(const QList<StoredImage> &images)
+{
+    m_contentEditor->placeImages(images);
+}
+
+void BookEditor::setImageId(int position, qint64 id)
+{
+    m_contentEditor->setImageId(position, id);
+}
+
+void BookEditor::provideThumbnail(const QString &hash, int size, const QByteArray &data)
+{
+    m_contentEditor->provideThumbnail(hash, size, data);
+}
+
+void BookEditor::provideOriginal(qint64 id, const QByteArray &data)
+{
+    m_contentEditor->provideOriginal(id, data);
+}
+
+bool BookEditor::imagePositions(QList<qint64> *ids, QList<int> *positions) const
+{
+    if (m_contentEditor->isLargeMode())
+        return false;
+
+    PageEditor::imagePositions(m_contentEditor->document(), ids, positions);
+    return true;
+}
+
+void BookEditor::onInsertImageClicked()
+{
+    const QString path = QFileDialog::getOpenFileName(this, tr("Insert Image"), QString(),
+                                                      tr("Images (*.png *.jpg *.jpeg *.gif *.bmp *.webp)"));
+    if (path.isEmpty())
+        return;
+
+    if (!m_contentEditor->insertImageFile(path))
+        QMessageBox::information(this, tr("Insert Image"), tr("Images cannot be shown in a page this large."));
+}
+
 QString BookEditor::getContent() const
 {
     return m_contentEditor->toPlainText();
@@ -1205,18 +1806,297 @@ int BookEditor::getCurrentPage() const
     return m_currentPage;
 }
 
+void BookEditor::addPrefetchedContent(int page, const QString &content)
+{
+    // Each view ignores pages it did not ask for
+    m_thumbnailModel->setPageContent(page, content);
+    if (isContinuous())
+    {
+        m_scrollView->setPageContent(page, content);
+        return;
+    }
+
+    // Large pages go to the single-document editor, so they load when shown
+    if (!m_prefetchWanted.remove(page) || page == m_currentPage || cachedPageIndex(page) >= 0 || content.size() > PageEditor::LargeDocumentThreshold)
+        return;
+
+    m_prefetcher->build(page, content, m_contentEditor->documentStyle());
+}
+
+void BookEditor::onPrefetchRequested(int page)
+{
+    if (isContinuous() || page > m_totalPages || cachedPageIndex(page) >= 0 || pageCacheMemory() >= PrefetchMemoryBudget)
+        return;
+
+    m_prefetchWanted.insert(page);
+    emit prefetchPage(page);
+}
+
+void BookEditor::onPrefetchedDocument(int page, QTextDocument *document, size_t contentHash)
+{
+    // The reader may have got there first, or the budget filled up meanwhile
+    if (page == m_currentPage || page > m_totalPages || cachedPageIndex(page) >= 0 ||
+        pageCacheMemory() >= PrefetchMemoryBudget)
+    {
+        delete document;
+        return;
+    }
+
+    m_contentEditor->adoptDocument(document, this);
+
+    // Right behind the shown page, ahead of pages visited earlier
+    m_pageCache.insert(qMin(1, m_pageCache.size()), {page, document, contentHash, 0});
+    while (m_pageCache.size() > PageCacheSize)
+        delete m_pageCache.takeLast().document;
+}
+
+void BookEditor::onScrollPageActivated(int page)
+{
+    setContinuous(false);
+    if (page != m_currentPage)
+        emit pageChanged(page);
+}
+
+void BookEditor::onThumbnailRequested(int page)
+{
+    // Pages held as documents render from their current text
+    const int index = cachedPageIndex(page);
+    if (index >= 0)
+    {
+        const TextStore *store = TextStore::forDocument(m_pageCache.at(index).document);
+        m_thumbnailModel->setPageContent(page, store->snapshot().toString());
+        return;
+    }
+
+    emit prefetchPage(page);
+}
+
+void BookEditor::onThumbnailActivated(int page)
+{
+    if (isContinuous())
+        m_scrollView->scrollToPage(page);
+    else if (page != m_currentPage)
+        emit pageChanged(page);
+}
+
 void BookEditor::onContentChanged()
 {
-    emit contentChanged(m_contentEditor->toPlainText());
+    // Flattening the document is only worth it when somebody listens
+    if (isSignalConnected(QMetaMethod::fromSignal(&BookEditor::contentChanged)))
+    {
+        emit contentChanged(m_contentEditor->toPlainText());
+    }
 }
 
-void BookEditor::onPageSpinBoxChanged(int value)
+void BookEditor::onContentsChange(int position, int charsRemoved, int charsAdded)
+{
+    Q_UNUSED(charsRemoved);
+
+    // Each block caches its own word count in userState(), so a keystroke
+    // only recounts the paragraph it touched
+    QTextDocument *doc = m_contentEditor->document();
+    QTextBlock first = doc->findBlock(position);
+    QTextBlock last = doc->findBlock(position + charsAdded);
+
+    if (first.isValid() && first == last && first.userState() >= 0 && doc->blockCount() == m_blockCount)
+    {
+        int words = countWords(first.text());
+        m_wordCount += words - first.userState();
+        first.setUserState(words);
+    }
+    else
+    {
+        for (QTextBlock block = first; block.isValid(); block = block.next())
+        {
+            block.setUserState(countWords(block.text()));
+            if (block == last)
+                break;
+        }
+        recountAllBlocks();
+    }
+
+    m_blockCount = doc->blockCount();
+    updateWordCount();
+    emit wordCountChanged(m_wordCount);
+
+    if (m_autoPaginate && !m_loadingContent && !m_splitPending && !m_contentEditor->isReadOnly() && m_wordCount > PageWordBudget)
+    {
+        // Never edit the document from inside its own change notification
+        m_splitPending = true;
+        QTimer::singleShot(0, this, &BookEditor::splitOverflow);
+    }
+}
+
+void BookEditor::refreshWordCount()
+{
+    // A swapped-in document sends no contentsChange; its blocks still carry
+    // their cached counts
+    recountAllBlocks();
+    m_blockCount = m_contentEditor->document()->blockCount();
+    updateWordCount();
+    emit wordCountChanged(m_wordCount);
+}
+
+void BookEditor::clearPageCache()
+{
+    m_navigator->cancel();
+    m_prefetcher->reset();
+    m_prefetchWanted.clear();
+    if (m_pageCache.isEmpty())
+        return;
+
+    m_contentEditor->setPlainText(QString());
+    for (const CachedPage &cached : m_pageCache)
+        delete cached.document;
+    m_pageCache.clear();
+}
+
+int BookEditor::pageOfStore(const TextStore *store) const
+{
+    for (const CachedPage &cached : m_pageCache)
+    {
+        if (TextStore::forDocument(cached.document) == store)
+            return cached.page;
+    }
+
+    // The large-document editor's single document is not cached
+    return store == textStore() ? m_currentPage : -1;
+}
+
+int BookEditor::cachedPageIndex(int page) const
+{
+    for (int i = 0; i < m_pageCache.size(); ++i)
+    {
+        if (m_pageCache.at(i).page == page)
+            return i;
+    }
+    return -1;
+}
+
+qint64 BookEditor::pageCacheMemory() const
+{
+    // Undo history and piece table, plus QTextDocument's own copy of the text
+    qint64 bytes = 0;
+    for (const CachedPage &cached : m_pageCache)
+    {
+        bytes += TextStore::forDocument(cached.document)->memoryUsage();
+        bytes += qint64(cached.document->characterCount()) * qint64(sizeof(QChar));
+    }
+    return bytes;
+}
+
+void BookEditor::recountAllBlocks()
+{
+    int total = 0;
+    for (QTextBlock block = m_contentEditor->document()->begin(); block.isValid(); block = block.next())
+    {
+        if (block.userState() < 0)
+            block.setUserState(countWords(block.text()));
+        total += block.userState();
+    }
+    m_wordCount = total;
+}
+
+int BookEditor::countWords(const QString &text)
 {
-    if (value != m_currentPage)
+    int count = 0;
+    bool inWord = false;
+    for (const QChar ch : text)
     {
-        m_currentPage = value;
-        emit pageChanged(value);
+        if (ch.isSpace())
+        {
+            inWord = false;
+        }
+        else if (!inWord)
+        {
+            inWord = true;
+            ++count;
+        }
     }
+    return count;
+}
+
+void BookEditor::splitOverflow()
+{
+    m_splitPending = false;
+    if (!m_autoPaginate || m_wordCount <= PageWordBudget)
+        return;
+
+    // Find the first paragraph that pushes the page past its budget
+    QTextDocument *doc = m_contentEditor->document();
+    QTextBlock splitBlock;
+    int running = 0;
+    for (QTextBlock block = doc->begin(); block.isValid(); block = block.next())
+    {
+        running += qMax(block.userState(), 0);
+        if (running > PageWordBudget)
+        {
+            splitBlock = block;
+            break;
+        }
+    }
+
+    // Only split between paragraphs; a single oversized paragraph stays put
+    if (!splitBlock.isValid() || splitBlock == doc->begin())
+        return;
+
+    // The overflow is prepended to the stored next page; a cached copy of it
+    // with unsaved edits would be shown instead and hide the moved text, so
+    // the split waits until the autosave has stored it
+    const int nextIndex = cachedPageIndex(m_currentPage + 1);
+    if (nextIndex >= 0 && TextStore::forDocument(m_pageCache.at(nextIndex).document)->isModified())
+        return;
+
+    // The text is only cut once the split is stored, through pageSplit();
+    // a failed split leaves it in place and unsaved
+    const QString text = m_contentEditor->toPlainText();
+    const int keepLength = splitBlock.position() - 1;
+    emit splitPage(m_currentPage, text.left(keepLength), text.mid(splitBlock.position()));
+}
+
+void BookEditor::pageSplit(int page, int keepLength)
+{
+    // The bridge may have applied a page change before storing the split,
+    // leaving the split page in the cache
+    QTextDocument *doc = nullptr;
+    if (page == m_currentPage)
+    {
+        doc = m_contentEditor->document();
+    }
+    else if (const int index = cachedPageIndex(page); index >= 0)
+    {
+        doc = m_pageCache.at(index).document;
+    }
+    TextStore *store = TextStore::forDocument(doc);
+    if (!store || keepLength < 0 || keepLength >= doc->characterCount() - 1)
+        return;
+
+    const bool current = doc == m_contentEditor->document();
+    const int caret = current ? m_contentEditor->textCursor().position() : -1;
+
+    // Drop the overflow together with the paragraph break in front of it
+    QTextCursor cursor(doc);
+    cursor.setPosition(keepLength);
+    cursor.movePosition(QTextCursor::End, QTextCursor::KeepAnchor);
+    cursor.removeSelectedText();
+
+    // The moved text now lives on the next page, so undoing past the
+    // split would duplicate it
+    store->clearHistory();
+    store->markSaved(store->revision());
+    m_thumbnailModel->invalidatePage(page);
+    m_thumbnailModel->invalidatePage(page + 1);
+
+    if (current && caret > keepLength)
+    {
+        m_pendingCaretOffset = caret - keepLength - 1;
+        emit nextPage();
+    }
+}
+
+void BookEditor::onPageSpinBoxChanged(int value)
+{
+    m_navigator->request(value, m_currentPage);
 }
 
 void BookEditor::updateNavigationButtons()
@@ -1232,8 +2112,8 @@ void BookEditor::updatePageInfo()
 
 void BookEditor::updateWordCount()
 {
-    m_wordCountLabel->setText(tr("Words: %1 / 800").arg(m_wordCount));
-    if (m_wordCount > 800)
+    m_wordCountLabel->setText(tr("Words: %1 / %2").arg(m_wordCount).arg(PageWordBudget));
+    if (m_wordCount > PageWordBudget)
     {
         m_wordCountLabel->setStyleSheet("color: #ff6b6b; font-size: 14px; font-weight: 600;");
     }
@@ -1245,7 +2125,7 @@ void BookEditor::updateWordCount()
 
 // ============ NoteEditor Implementation ============
 NoteEditor::NoteEditor(QWidget *parent)
-    : QWidget(parent)
+    : QWidget(parent), m_updatingCheckboxes(false)
 {
     setupUI();
 }
@@ -1294,34 +2174,38 @@ void NoteEditor::setupUI()
     connect(m_checkboxButton, &QPushButton::clicked, this, &NoteEditor::onAddCheckboxClicked);
 
     m_imageButton = new QPushButton(tr("🖼️ Insert Image"));
-    connect(m_imageButton, &QPushButton::clicked, this, &NoteEditor::insertImage);
+    connect(m_imageButton, &QPushButton::clicked, this, &NoteEditor::onInsertImageClicked);
+
+    m_markdownCheck = new QCheckBox(tr("Markdown"));
+    m_markdownCheck->setToolTip(tr("Highlight Markdown headings, emphasis, lists and code"));
 
     toolbarLayout->addWidget(m_checkboxButton);
     toolbarLayout->addWidget(m_imageButton);
     toolbarLayout->addStretch();
-
-    // Content editor
-    QScrollArea *scrollArea = new QScrollArea;
-    scrollArea->setWidgetResizable(true);
-    scrollArea->setFrameShape(QFrame::NoFrame);
-    scrollArea->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
-
-    QWidget *editorContainer = new QWidget;
-    QVBoxLayout *editorLayout = new QVBoxLayout(editorContainer);
-    editorLayout->setContentsMargins(40, 30, 40, 30);
-
-    m_contentEditor = new QTextEdit;
-    m_contentEditor->setMinimumHeight(500);
-    m_contentEditor->setAcceptRichText(false);
-    m_contentEditor->setTabStopDistance(40);
-    connect(m_contentEditor, &QTextEdit::textChanged, this, &NoteEditor::onContentChanged);
-
-    editorLayout->addWidget(m_contentEditor);
-    scrollArea->setWidget(editorContainer);
+    toolbarLayout->addWidget(m_markdownCheck);
+
+    // Content editor. The text edit is the only scroller; the page margin
+    // is the editor's own, so resizes and keystrokes lay out one viewport
+    m_contentEditor = new PageEditor;
+    m_contentEditor->setContentsMargins(40, 30, 40, 30);
+    connect(m_contentEditor, &PageEditor::textChanged, this, &NoteEditor::onContentChanged);
+    connect(m_contentEditor, &PageEditor::contentsChange, this, &NoteEditor::onContentsChange);
+    connect(m_contentEditor, &PageEditor::imageInserted, this, &NoteEditor::imageInserted);
+    connect(m_contentEditor, &PageEditor::thumbnailRequested, this, &NoteEditor::thumbnailRequested);
+    connect(m_contentEditor, &PageEditor::originalRequested, this, &NoteEditor::originalRequested);
+    connect(m_contentEditor, &PageEditor::thumbnailsReady, this, &NoteEditor::thumbnailsReady);
+    connect(m_contentEditor, &PageEditor::imageFailed, this, [this](const QString &path, const QString &error)
+            { QMessageBox::warning(this, tr("Insert Image"), tr("Could not load %1:\n%2").arg(path, error)); });
+
+    // Checklist items are drawn by the document and ticked by clicking them
+    CheckboxObject::install(m_contentEditor->document());
+    m_contentEditor->richViewport()->installEventFilter(this);
+
+    connect(m_markdownCheck, &QCheckBox::toggled, m_contentEditor, &PageEditor::setMarkdownEnabled);
 
     mainLayout->addWidget(headerWidget);
     mainLayout->addWidget(toolbar);
-    mainLayout->addWidget(scrollArea);
+    mainLayout->addWidget(m_contentEditor);
 }
 
 void NoteEditor::setEntryTitle(const QString &title)
@@ -1341,11 +2225,226 @@ QString NoteEditor::getContent() const
     return m_contentEditor->toPlainText();
 }
 
+TextStore *NoteEditor::textStore() const
+{
+    return m_contentEditor->textStore();
+}
+
+void NoteEditor::undoRedo(bool redo)
+{
+    m_contentEditor->undoRedo(redo);
+}
+
+void NoteEditor::setCheckboxes(const QList<qint64> &ids, const QList<bool> &checked)
+{
+    if (m_contentEditor->isLargeMode())
+        return;
+
+    const QList<int> markers = markerPositions();
+    for (int index = 0; index < markers.size() && index < ids.size(); ++index)
+        setCheckboxFormat(markers[index], CheckboxObject::format(ids[index], checked.value(index)));
+
+    // Items with no stored row yet, e.g. the row could not be written. This
+    // is called from inside the bridge while Rust holds its state, so the
+    // rows are asked for once that call has returned
+    QTimer::singleShot(0, this, &NoteEditor::assignNewCheckboxes);
+}
+
+void NoteEditor::setCheckboxId(int index, qint64 id)
+{
+    const QList<int> markers = markerPositions();
+    if (index < 0 || index >= markers.size())
+        return;
+
+    QTextCursor cursor(m_contentEditor->document());
+    cursor.setPosition(markers[index] + 1);
+    setCheckboxFormat(markers[index], CheckboxObject::format(id, CheckboxObject::isChecked(cursor.charFormat())));
+}
+
+bool NoteEditor::checkboxPositions(QList<qint64> *ids, QList<int> *positions) const
+{
+    if (m_contentEditor->isLargeMode())
+        return false;
+
+    QTextCursor cursor(m_contentEditor->document());
+    for (int position : markerPositions())
+    {
+        cursor.setPosition(position + 1);
+        const QTextCharFormat format = cursor.charFormat();
+        if (CheckboxObject::isCheckbox(format) && CheckboxObject::id(format) >= 0)
+        {
+            ids->append(CheckboxObject::id(format));
+            positions->append(position);
+        }
+    }
+    return true;
+}
+
+void NoteEditor::setImages(const QList<StoredImage> &images)
+{
+    m_contentEditor->placeImages(images);
+}
+
+void NoteEditor::setImageId(int position, qint64 id)
+{
+    m_contentEditor->setImageId(position, id);
+}
+
+void NoteEditor::provideThumbnail(const QString &hash, int size, const QByteArray &data)
+{
+    m_contentEditor->provideThumbnail(hash, size, data);
+}
+
+void NoteEditor::provideOriginal(qint64 id, const QByteArray &data)
+{
+    m_contentEditor->provideOriginal(id, data);
+}
+
+bool NoteEditor::imagePositions(QList<qint64> *ids, QList<int> *positions) const
+{
+    if (m_contentEditor->isLargeMode())
+        return false;
+
+    PageEditor::imagePositions(m_contentEditor->document(), ids, positions);
+    return true;
+}
+
+void NoteEditor::onInsertImageClicked()
+{
+    const QString path = QFileDialog::getOpenFileName(this, tr("Insert Image"), QString(),
+                                                      tr("Images (*.png *.jpg *.jpeg *.gif *.bmp *.webp)"));
+    if (path.isEmpty())
+        return;
+
+    if (!m_contentEditor->insertImageFile(path))
+        QMessageBox::information(this, tr("Insert Image"), tr("Images cannot be shown in a note this large."));
+}
+
+bool NoteEditor::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched == m_contentEditor->richViewport() && event->type() == QEvent::MouseButtonPress &&
+        !m_contentEditor->isLargeMode())
+    {
+        QMouseEvent *mouseEvent = static_cast<QMouseEvent *>(event);
+        if (mouseEvent->button() == Qt::LeftButton && toggleCheckboxAt(mouseEvent->position().toPoint()))
+            return true;
+    }
+    return QWidget::eventFilter(watched, event);
+}
+
+QList<int> NoteEditor::markerPositions() const
+{
+    // Images share the object replacement character
+    QList<int> positions;
+    QTextCursor cursor(m_contentEditor->document());
+    const QString text = m_contentEditor->document()->toRawText();
+    for (int position = text.indexOf(QChar::ObjectReplacementCharacter); position >= 0;
+         position = text.indexOf(QChar::ObjectReplacementCharacter, position + 1))
+    {
+        cursor.setPosition(position + 1);
+        if (!cursor.charFormat().isImageFormat())
+            positions.append(position);
+    }
+    return positions;
+}
+
+void NoteEditor::setCheckboxFormat(int position, const QTextCharFormat &format)
+{
+    // Format-only, so the TextStore sees no edit and nothing is re-saved
+    m_updatingCheckboxes = true;
+    QTextCursor cursor(m_contentEditor->document());
+    cursor.setPosition(position);
+    cursor.setPosition(position + 1, QTextCursor::KeepAnchor);
+    cursor.setCharFormat(format);
+    m_updatingCheckboxes = false;
+}
+
+void NoteEditor::assignNewCheckboxes()
+{
+    // Markers typed, pasted or brought back by undo arrive without a
+    // checkbox format, and copies of an item share its id; each of those
+    // becomes a new item with its own row
+    const QList<int> markers = markerPositions();
+    QSet<qint64> seen;
+    QTextCursor cursor(m_contentEditor->document());
+    for (int index = 0; index < markers.size(); ++index)
+    {
+        cursor.setPosition(markers[index] + 1);
+        const QTextCharFormat format = cursor.charFormat();
+        const qint64 id = CheckboxObject::id(format);
+        if (CheckboxObject::isCheckbox(format) && (id < 0 || !seen.contains(id)))
+        {
+            seen.insert(id);
+            continue;
+        }
+
+        setCheckboxFormat(markers[index], CheckboxObject::format(-1, CheckboxObject::isChecked(format)));
+        emit addCheckbox(index);
+    }
+}
+
+bool NoteEditor::toggleCheckboxAt(const QPoint &pos)
+{
+    // The hit position lands before or after the object depending on which
+    // half was clicked
+    const QTextCursor hit = m_contentEditor->cursorForPosition(pos);
+    QTextDocument *document = m_contentEditor->document();
+    for (int position : {hit.position(), hit.position() - 1})
+    {
+        if (position < 0 || document->characterAt(position) != QChar::ObjectReplacementCharacter)
+            continue;
+
+        QTextCursor cursor(document);
+        cursor.setPosition(position + 1);
+        const QTextCharFormat format = cursor.charFormat();
+        if (!CheckboxObject::isCheckbox(format))
+            continue;
+
+        const qint64 id = CheckboxObject::id(format);
+        const bool checked = !CheckboxObject::isChecked(format);
+        setCheckboxFormat(position, CheckboxObject::format(id, checked));
+        if (id >= 0)
+            emit checkboxToggled(id, checked);
+        return true;
+    }
+    return false;
+}
+
 void NoteEditor::onAddCheckboxClicked()
 {
+    if (m_contentEditor->isLargeMode())
+        return;
+
     QTextCursor cursor = m_contentEditor->textCursor();
-    cursor.insertText("☐ ");
-    emit addCheckbox();
+    TextStore *store = m_contentEditor->textStore();
+    store->beginGroup();
+    m_updatingCheckboxes = true;
+    if (!cursor.atBlockStart())
+        cursor.insertBlock();
+    const int position = cursor.position();
+    cursor.insertText(QString(QChar::ObjectReplacementCharacter), CheckboxObject::format(-1, false));
+    cursor.insertText(" ", QTextCharFormat());
+    m_updatingCheckboxes = false;
+    store->endGroup();
+    m_contentEditor->setTextCursor(cursor);
+
+    emit addCheckbox(markerPositions().indexOf(position));
+}
+
+void NoteEditor::onContentsChange(int position, int charsRemoved, int charsAdded)
+{
+    Q_UNUSED(charsRemoved);
+    if (m_updatingCheckboxes || m_contentEditor->isLargeMode() || charsAdded == 0)
+        return;
+
+    QTextCursor cursor(m_contentEditor->document());
+    cursor.setPosition(position);
+    cursor.setPosition(qMin(position + charsAdded, m_contentEditor->document()->characterCount() - 1), QTextCursor::KeepAnchor);
+    if (!cursor.selectedText().contains(QChar::ObjectReplacementCharacter))
+        return;
+
+    // Formats cannot change while the document is still applying the edit
+    QTimer::singleShot(0, this, &NoteEditor::assignNewCheckboxes);
 }
 
 void NoteEditor::onContentChanged()
@@ -17,13 +17,25 @@
 #include <QToolBar>
 #include <QStatusBar>
 #include <QAction>
+#include <QCheckBox>
+#include <QSet>
 #include <memory>
 
 // Forward declarations
 class PasswordDialog;
+class QProgressBar;
 class ModeSelectionDialog;
 class BookEditor;
 class NoteEditor;
+class PageEditor;
+class TextStore;
+class AutosaveScheduler;
+class PagePrefetcher;
+class PageNavigator;
+class BookScrollView;
+class PageThumbnailModel;
+class PageThumbnailStrip;
+struct StoredImage;
 
 class MainWindow : public QMainWindow
 {
@@ -42,8 +54,19 @@ public:
     void setWordCount(int count);
     void setPasswordError(const QString &error);
     void setShowPasswordError(bool show);
+    void finishUnlock(bool unlocked, const QString &error);
+    void setAutosaveInterval(int msec);
+    void providePageContent(int page, const QString &content);
+    void setNoteCheckboxes(const QList<qint64> &ids, const QList<bool> &checked);
+    void setCheckboxId(int index, qint64 id);
+    void pageSplit(int page, int keepLength);
+    void setImages(const QList<StoredImage> &images);
+    void setImageId(int position, qint64 id);
+    void provideThumbnail(const QString &hash, int size, const QByteArray &data);
+    void provideOriginal(qint64 id, const QByteArray &data);
 
     QString getCurrentContent() const;
+    TextStore *currentTextStore() const;
     int getCurrentPage() const;
 
     // View switching (for Rust bridge)
@@ -58,14 +81,23 @@ signals:
     void modeSelected(const QString &data, const QString &unused);
     void entrySelected(int index);
     void deleteEntryClicked(int index);
-    void saveContent(const QString &content);
+    void saveContent(const QString &content, int page);
+    void saveDelta(TextStore *store, int page);
     void backToList();
     void searchEntries(const QString &query);
     void clearSearch();
     void pageChanged(int newPage);
     void addNewPage();
-    void insertImage();
-    void addCheckbox();
+    void splitPage(int page, const QString &keep, const QString &overflow);
+    void prefetchPage(int page);
+    void imageInserted(const QString &path, const QString &hash, int position, const QSize &size);
+    void imagePositionsChanged(const QList<qint64> &ids, const QList<int> &positions);
+    void thumbnailRequested(const QString &hash, int size);
+    void originalRequested(qint64 id);
+    void thumbnailsReady(qint64 id, const QString &hash, const QList<QByteArray> &encoded);
+    void addCheckbox(int index);
+    void checkboxToggled(qint64 id, bool checked);
+    void checkboxOrderChanged(const QList<qint64> &ids, const QList<int> &positions);
 
 private slots:
     void onNewEntry();
@@ -79,12 +111,19 @@ private slots:
     void onNextPage();
     void onAddPage();
     void onBackToList();
+    void saveStore(TextStore *store);
+    void onSaveFinished(bool saved, qint64 revision, qint64 elapsedMs);
+
+protected:
+    void closeEvent(QCloseEvent *event) override;
 
 private:
     void setupUI();
     void setupMenuBar();
+    void undoRedo(bool redo);
     void setupToolBar();
     void setupStatusBar();
+    void updateMemoryLabel();
     void setupListView();
     void applyDarkTheme();
     void updateWindowTitle();
@@ -93,6 +132,8 @@ private:
     QStackedWidget *m_stackedWidget;
     QToolBar *m_toolBar;
     QStatusBar *m_statusBar;
+    QLabel *m_saveLabel;
+    QLabel *m_memoryLabel;
 
     // Actions
     QAction *m_newEntryAction;
@@ -115,6 +156,8 @@ private:
     // Mode Selection Dialog
     ModeSelectionDialog *m_modeDialog;
 
+    AutosaveScheduler *m_autosave;
+
     // State
     QStringList m_entryList;
     QString m_currentEntryTitle;
@@ -134,6 +177,10 @@ public:
     void setErrorMessage(const QString &message);
     void setShowError(bool show);
 
+    // The key is derived off the GUI thread; the dialog stays up, busy,
+    // until the result comes back
+    void finishUnlock(bool unlocked, const QString &error);
+
 signals:
     void passwordSubmitted(const QString &password);
 
@@ -142,12 +189,16 @@ protected:
 
 private:
     void accept() override;
+    void reject() override;
+    void setBusy(bool busy);
 
     QLineEdit *m_passwordInput;
     QLabel *m_errorLabel;
     QWidget *m_errorWidget;
+    QProgressBar *m_progressBar;
     QPushButton *m_unlockButton;
     QPushButton *m_cancelButton;
+    bool m_busy;
 };
 
 // ============ Mode Selection Dialog ============
@@ -184,14 +235,51 @@ class BookEditor : public QWidget
 public:
     explicit BookEditor(QWidget *parent = nullptr);
 
+    // Word budget per page; the counter turns red and auto-pagination
+    // kicks in once a page goes past it
+    static constexpr int PageWordBudget = 800;
+
+    // Recently shown and prefetched pages kept as documents
+    static constexpr int PageCacheSize = 5;
+
+    // Prefetching stops once the cached pages use this much
+    static constexpr qint64 PrefetchMemoryBudget = 8 * 1024 * 1024;
+
     void setEntryTitle(const QString &title);
     void setContent(const QString &content);
     void setCurrentPage(int page);
     void setTotalPages(int total);
     void setWordCount(int count);
+    void setAutoPaginate(bool enabled);
+    void setContinuous(bool enabled);
+    void setOverviewVisible(bool visible);
+    void addPrefetchedContent(int page, const QString &content);
+
+    // The store's text reached storage; refreshes the page's thumbnail
+    void pageSaved(TextStore *store);
+
+    // Page whose text `store` holds, or -1 if it is not one of this editor's
+    int pageOfStore(const TextStore *store) const;
+
+    // The split asked for by splitPage() was stored: the page's text past
+    // keepLength moved to the next page and is dropped here
+    void pageSplit(int page, int keepLength);
+
+    // Stored images of the shown page; setImages() is applied after
+    // setContent(). imagePositions() is false while the large-document
+    // editor, which shows none, is up.
+    void setImages(const QList<StoredImage> &images);
+    void setImageId(int position, qint64 id);
+    void provideThumbnail(const QString &hash, int size, const QByteArray &data);
+    void provideOriginal(qint64 id, const QByteArray &data);
+    bool imagePositions(QList<qint64> *ids, QList<int> *positions) const;
 
     QString getContent() const;
     int getCurrentPage() const;
+    bool autoPaginate() const;
+    bool isContinuous() const;
+    TextStore *textStore() const;
+    void undoRedo(bool redo);
 
 signals:
     void backClicked();
@@ -199,22 +287,55 @@ signals:
     void previousPage();
     void nextPage();
     void addPage();
-    void insertImage();
+    void imageInserted(const QString &path, const QString &hash, int position, const QSize &size);
+    void thumbnailRequested(const QString &hash, int size);
+    void originalRequested(qint64 id);
+    void thumbnailsReady(qint64 id, const QString &hash, const QList<QByteArray> &encoded);
     void contentChanged(const QString &text);
+    void wordCountChanged(int count);
     void pageChanged(int newPage);
+    void splitPage(int page, const QString &keep, const QString &overflow);
+    void textStoreCreated(TextStore *store);
+    void prefetchPage(int page);
+    void continuousChanged(bool enabled);
 
 private slots:
     void onContentChanged();
+    void onContentsChange(int position, int charsRemoved, int charsAdded);
     void onPageSpinBoxChanged(int value);
+    void splitOverflow();
+    void onPrefetchRequested(int page);
+    void onPrefetchedDocument(int page, QTextDocument *document, size_t contentHash);
+    void onScrollPageActivated(int page);
+    void onThumbnailRequested(int page);
+    void onThumbnailActivated(int page);
+    void onInsertImageClicked();
 
 private:
     void setupUI();
     void updateNavigationButtons();
     void updatePageInfo();
     void updateWordCount();
+    void recountAllBlocks();
+    void refreshWordCount();
+    void clearPageCache();
+    int cachedPageIndex(int page) const;
+    qint64 pageCacheMemory() const;
+    static int countWords(const QString &text);
+
+    // Page documents keep their layout, undo history and caret. contentHash
+    // is the text as last loaded or left, so a reload of unchanged content
+    // just swaps the document back in.
+    struct CachedPage
+    {
+        int page;
+        QTextDocument *document;
+        size_t contentHash;
+        int caret;
+    };
 
     QLabel *m_titleLabel;
-    QTextEdit *m_contentEditor;
+    PageEditor *m_contentEditor;
     QLabel *m_pageInfoLabel;
     QLabel *m_wordCountLabel;
     QSpinBox *m_pageSpinBox;
@@ -224,10 +345,30 @@ private:
     QPushButton *m_backButton;
     QPushButton *m_saveButton;
     QPushButton *m_imageButton;
+    QCheckBox *m_autoPaginateCheck;
+    QCheckBox *m_continuousCheck;
+    QCheckBox *m_overviewCheck;
+    QCheckBox *m_markdownCheck;
+    QStackedWidget *m_viewStack;
+    QWidget *m_pageView;
+    BookScrollView *m_scrollView;
+    PageThumbnailModel *m_thumbnailModel;
+    PageThumbnailStrip *m_thumbnailStrip;
+    QList<CachedPage> m_pageCache;
+    PagePrefetcher *m_prefetcher;
+    PageNavigator *m_navigator;
+
+    // Pages the prefetcher asked for; other content is not cached
+    QSet<int> m_prefetchWanted;
 
     int m_currentPage;
     int m_totalPages;
     int m_wordCount;
+    int m_blockCount;
+    bool m_autoPaginate;
+    bool m_splitPending;
+    bool m_loadingContent;
+    int m_pendingCaretOffset;
 };
 
 // ============ Note Editor ============
@@ -241,27 +382,59 @@ public:
     void setEntryTitle(const QString &title);
     void setContent(const QString &content);
     QString getContent() const;
+    TextStore *textStore() const;
+    void undoRedo(bool redo);
+
+    // Checklist items in text order; setCheckboxes() is applied after
+    // setContent() with the rows stored for the note
+    void setCheckboxes(const QList<qint64> &ids, const QList<bool> &checked);
+    void setCheckboxId(int index, qint64 id);
+    bool checkboxPositions(QList<qint64> *ids, QList<int> *positions) const;
+
+    // As BookEditor's
+    void setImages(const QList<StoredImage> &images);
+    void setImageId(int position, qint64 id);
+    void provideThumbnail(const QString &hash, int size, const QByteArray &data);
+    void provideOriginal(qint64 id, const QByteArray &data);
+    bool imagePositions(QList<qint64> *ids, QList<int> *positions) const;
 
 signals:
     void backClicked();
     void saveClicked(const QString &content);
-    void addCheckbox();
-    void insertImage();
+    void addCheckbox(int index);
+    void checkboxToggled(qint64 id, bool checked);
+    void imageInserted(const QString &path, const QString &hash, int position, const QSize &size);
+    void thumbnailRequested(const QString &hash, int size);
+    void originalRequested(qint64 id);
+    void thumbnailsReady(qint64 id, const QString &hash, const QList<QByteArray> &encoded);
     void contentChanged(const QString &text);
 
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
 private slots:
     void onAddCheckboxClicked();
+    void onInsertImageClicked();
     void onContentChanged();
+    void onContentsChange(int position, int charsRemoved, int charsAdded);
 
 private:
     void setupUI();
+    QList<int> markerPositions() const;
+    void setCheckboxFormat(int position, const QTextCharFormat &format);
+    void assignNewCheckboxes();
+    bool toggleCheckboxAt(const QPoint &pos);
 
     QLabel *m_titleLabel;
-    QTextEdit *m_contentEditor;
+    PageEditor *m_contentEditor;
     QPushButton *m_backButton;
     QPushButton *m_saveButton;
     QPushButton *m_checkboxButton;
     QPushButton *m_imageButton;
+    QCheckBox *m_markdownCheck;
+
+    // Set while the editor itself changes checkbox formats
+    bool m_updatingCheckboxes;
 };
 
 #endif // MAINWINDOW_H
\ No newline at end of file
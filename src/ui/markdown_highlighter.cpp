@@ -0,0 +1,220 @@
+// markdown_highlighter.cpp
+#include "markdown_highlighter.h"
+#include <QFontDatabase>
+#include <QRegularExpression>
+#include <QTextDocument>
+
+namespace
+{
+    const QColor HeadingColor("#a8d08d");
+    const QColor CodeColor("#a8d08d");
+    const QColor CodeBackgroundColor("#252525");
+    const QColor LinkColor("#5a8c3a");
+    const QColor QuoteColor("#7a9b68");
+    const QColor MarkerColor("#5a8c3a");
+
+    // Line-level constructs all start, after at most three spaces, with one
+    // of these; other lines skip straight to the inline rules
+    const QString LineStarters = QStringLiteral("#>-*+_`~0123456789");
+    const QString InlineStarters = QStringLiteral("*_`[");
+
+    const QRegularExpression FencePattern(QStringLiteral("^ {0,3}(`{3,}|~{3,})(.*)$"));
+    const QRegularExpression HeadingPattern(QStringLiteral("^ {0,3}#{1,6}(?=\\s|$)"));
+    const QRegularExpression RulePattern(QStringLiteral("^ {0,3}([-*_])( *\\1){2,} *$"));
+    const QRegularExpression QuotePattern(QStringLiteral("^ {0,3}>"));
+    const QRegularExpression ListPattern(QStringLiteral("^\\s*([-*+]|\\d{1,9}[.)])(?=\\s)"));
+
+    const QRegularExpression EmphasisPattern(QStringLiteral("(?<![*_\\w])([*_])(?![*_\\s])(.+?)(?<![*_\\s])\\1(?![*_\\w])"));
+    const QRegularExpression StrongPattern(QStringLiteral("(?<![*_])(\\*\\*|__)(?=\\S)(.+?)(?<=\\S)\\1(?![*_])"));
+    const QRegularExpression LinkPattern(QStringLiteral("!?\\[[^\\]]+\\]\\([^)\\s]+\\)"));
+    const QRegularExpression CodeSpanPattern(QStringLiteral("`[^`]+`"));
+
+    struct BlockData : public QTextBlockUserData
+    {
+        explicit BlockData(int state) : state(state) {}
+        int state;
+    };
+
+    bool startsWithAny(const QString &text, const QString &starters)
+    {
+        for (int i = 0; i < text.size() && i <= 3; ++i)
+        {
+            if (text[i] != QLatin1Char(' '))
+                return starters.contains(text[i]);
+        }
+        return false;
+    }
+
+    bool containsAny(const QString &text, const QString &characters)
+    {
+        for (const QChar ch : text)
+        {
+            if (characters.contains(ch))
+                return true;
+        }
+        return false;
+    }
+}
+
+// ============ MarkdownHighlighter Implementation ============
+MarkdownHighlighter::MarkdownHighlighter(QTextDocument *document)
+    : QSyntaxHighlighter(document), m_propagateFrom(-1), m_propagating(false)
+{
+    m_headingFormat.setForeground(HeadingColor);
+    m_headingFormat.setFontWeight(QFont::Bold);
+
+    m_emphasisFormat.setFontItalic(true);
+    m_strongFormat.setFontWeight(QFont::Bold);
+
+    m_codeFormat.setForeground(CodeColor);
+    m_codeFormat.setBackground(CodeBackgroundColor);
+    m_codeFormat.setFontFamilies({QFontDatabase::systemFont(QFontDatabase::FixedFont).family()});
+    m_codeFormat.setFontFixedPitch(true);
+
+    m_linkFormat.setForeground(LinkColor);
+    m_linkFormat.setFontUnderline(true);
+
+    m_quoteFormat.setForeground(QuoteColor);
+    m_quoteFormat.setFontItalic(true);
+
+    m_markerFormat.setForeground(MarkerColor);
+}
+
+void MarkdownHighlighter::install(QTextDocument *document)
+{
+    if (document->findChild<MarkdownHighlighter *>(QString(), Qt::FindDirectChildrenOnly))
+        return;
+    new MarkdownHighlighter(document);
+}
+
+void MarkdownHighlighter::uninstall(QTextDocument *document)
+{
+    // Detaching clears the formats it applied
+    delete document->findChild<MarkdownHighlighter *>(QString(), Qt::FindDirectChildrenOnly);
+}
+
+void MarkdownHighlighter::highlightBlock(const QString &text)
+{
+    // This block is being highlighted anyway
+    if (m_propagateFrom >= 0 && m_propagateFrom == currentBlock().blockNumber())
+        m_propagateFrom = -1;
+
+    const State previous = blockState(currentBlock().previous());
+    if (previous != Normal)
+    {
+        setFormat(0, text.size(), m_codeFormat);
+        const QRegularExpressionMatch fence = FencePattern.match(text);
+        const State fenceState = fence.hasMatch() && fence.captured(1).startsWith(QLatin1Char('`')) ? BacktickFence : TildeFence;
+        const bool closes = fence.hasMatch() && fenceState == previous && fence.captured(2).trimmed().isEmpty();
+        setBlockState(closes ? Normal : previous);
+        return;
+    }
+
+    if (startsWithAny(text, LineStarters))
+    {
+        const QRegularExpressionMatch fence = FencePattern.match(text);
+        if (fence.hasMatch())
+        {
+            setFormat(0, text.size(), m_markerFormat);
+            setBlockState(fence.captured(1).startsWith(QLatin1Char('`')) ? BacktickFence : TildeFence);
+            return;
+        }
+        setBlockState(Normal);
+
+        if (HeadingPattern.match(text).hasMatch())
+        {
+            setFormat(0, text.size(), m_headingFormat);
+            return;
+        }
+        if (RulePattern.match(text).hasMatch())
+        {
+            setFormat(0, text.size(), m_markerFormat);
+            return;
+        }
+        if (QuotePattern.match(text).hasMatch())
+        {
+            setFormat(0, text.size(), m_quoteFormat);
+        }
+        const QRegularExpressionMatch list = ListPattern.match(text);
+        if (list.hasMatch())
+        {
+            setFormat(list.capturedStart(1), list.capturedLength(1), m_markerFormat);
+        }
+    }
+    else
+    {
+        setBlockState(Normal);
+    }
+
+    highlightInline(text);
+}
+
+void MarkdownHighlighter::highlightInline(const QString &text)
+{
+    if (!containsAny(text, InlineStarters))
+        return;
+
+    // Later rules win where spans overlap; nothing is formatted inside code
+    auto apply = [this, &text](const QRegularExpression &pattern, const QTextCharFormat &format)
+    {
+        QRegularExpressionMatchIterator it = pattern.globalMatch(text);
+        while (it.hasNext())
+        {
+            const QRegularExpressionMatch match = it.next();
+            setFormat(match.capturedStart(), match.capturedLength(), format);
+        }
+    };
+    apply(EmphasisPattern, m_emphasisFormat);
+    apply(StrongPattern, m_strongFormat);
+    apply(LinkPattern, m_linkFormat);
+    apply(CodeSpanPattern, m_codeFormat);
+}
+
+MarkdownHighlighter::State MarkdownHighlighter::blockState(const QTextBlock &block)
+{
+    // Blocks without data have only ever ended outside a fence
+    const BlockData *data = block.isValid() ? dynamic_cast<BlockData *>(block.userData()) : nullptr;
+    return data ? State(data->state) : Normal;
+}
+
+void MarkdownHighlighter::setBlockState(State state)
+{
+    BlockData *data = dynamic_cast<BlockData *>(currentBlockUserData());
+    if ((data ? State(data->state) : Normal) == state)
+        return;
+
+    if (data)
+    {
+        data->state = state;
+    }
+    else
+    {
+        setCurrentBlockUserData(new BlockData(state));
+    }
+
+    // The next block started from the old state; QSyntaxHighlighter only
+    // follows userState(), so carrying it on is up to us
+    const QTextBlock next = currentBlock().next();
+    if (!next.isValid())
+        return;
+
+    const bool queued = m_propagateFrom >= 0;
+    m_propagateFrom = next.blockNumber();
+    if (!queued && !m_propagating)
+        QMetaObject::invokeMethod(this, &MarkdownHighlighter::propagate, Qt::QueuedConnection);
+}
+
+void MarkdownHighlighter::propagate()
+{
+    // Each block re-highlighted here queues the next one only if its own
+    // state changed, so this stops at the first block that was already right
+    m_propagating = true;
+    while (m_propagateFrom >= 0)
+    {
+        const QTextBlock block = document()->findBlockByNumber(m_propagateFrom);
+        m_propagateFrom = -1;
+        if (block.isValid())
+            rehighlightBlock(block);
+    }
+    m_propagating = false;
+}
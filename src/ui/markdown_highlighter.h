@@ -0,0 +1,61 @@
+// src/ui/markdown_highlighter.h
+// Optional Markdown highlighting for the page and note editors
+#ifndef MARKDOWN_HIGHLIGHTER_H
+#define MARKDOWN_HIGHLIGHTER_H
+
+#include <QSyntaxHighlighter>
+#include <QTextCharFormat>
+
+class QTextDocument;
+
+// ============ Markdown Highlighter ============
+// Highlights one block at a time. The only construct that spans blocks is a
+// fenced code block, so the state a block hands to the next one is just
+// "inside a fence or not". It is kept in the block's user data, because
+// BookEditor caches word counts in userState(); when an edit changes the
+// state a block ends in, the blocks after it are re-highlighted one by one
+// until one ends in the state it already had.
+class MarkdownHighlighter : public QSyntaxHighlighter
+{
+    Q_OBJECT
+
+public:
+    // Attaches a highlighter to the document, once per document
+    static void install(QTextDocument *document);
+
+    // Removes the document's highlighter and its formats, if it has one
+    static void uninstall(QTextDocument *document);
+
+protected:
+    void highlightBlock(const QString &text) override;
+
+private:
+    enum State
+    {
+        Normal,
+        BacktickFence,
+        TildeFence
+    };
+
+    explicit MarkdownHighlighter(QTextDocument *document);
+
+    static State blockState(const QTextBlock &block);
+    void setBlockState(State state);
+    void highlightInline(const QString &text);
+    void propagate();
+
+    QTextCharFormat m_headingFormat;
+    QTextCharFormat m_emphasisFormat;
+    QTextCharFormat m_strongFormat;
+    QTextCharFormat m_codeFormat;
+    QTextCharFormat m_linkFormat;
+    QTextCharFormat m_quoteFormat;
+    QTextCharFormat m_markerFormat;
+
+    // Block to carry a changed state into once the current pass is done, or
+    // -1
+    int m_propagateFrom;
+    bool m_propagating;
+};
+
+#endif // MARKDOWN_HIGHLIGHTER_H
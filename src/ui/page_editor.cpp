@@ -0,0 +1,658 @@
+// page_editor.cpp
+#include "page_editor.h"
+#include "image_loader.h"
+#include "markdown_highlighter.h"
+#include "text_insert.h"
+#include "text_store.h"
+#include <QAbstractTextDocumentLayout>
+#include <QFileInfo>
+#include <QKeyEvent>
+#include <QMenu>
+#include <QPixmapCache>
+#include <QScrollBar>
+#include <QTextBlock>
+#include <QTextDocument>
+#include <QTextImageFormat>
+#include <QTextLayout>
+#include <utility>
+
+namespace
+{
+    const QColor PlaceholderColor("#252525");
+
+    // Drawn stretched to each unloaded image's size
+    QPixmap placeholderPixmap()
+    {
+        static QPixmap pixmap;
+        if (pixmap.isNull())
+        {
+            pixmap = QPixmap(1, 1);
+            pixmap.fill(PlaceholderColor);
+        }
+        return pixmap;
+    }
+}
+
+// ============ PageEditor Implementation ============
+PageEditor::PageEditor(QWidget *parent)
+    : QStackedWidget(parent), m_richDocument(nullptr), m_imageLoader(new ImageLoader(this)), m_largeMode(false), m_markdown(false)
+{
+    m_richEditor = new PasteAwareTextEdit;
+    m_richEditor->setAcceptRichText(false);
+
+    // The regular editor shows documents owned elsewhere (BookEditor's page
+    // cache), so its own document is one this widget owns too
+    m_richDocument = createDocument(QString(), this);
+    m_richEditor->setDocument(m_richDocument);
+    m_richEditor->setTabStopDistance(40);
+
+    m_plainEditor = new PasteAwarePlainTextEdit;
+    m_plainEditor->setTabStopDistance(40);
+
+    addWidget(m_richEditor);
+    addWidget(m_plainEditor);
+    setCurrentWidget(m_richEditor);
+
+    m_plainStore = new TextStore(m_plainEditor->document());
+
+    // The documents' own undo stacks are off; route the shortcuts and the
+    // context menus' Undo and Redo to the stores
+    m_richEditor->installEventFilter(this);
+    m_plainEditor->installEventFilter(this);
+    m_richEditor->setContextMenuPolicy(Qt::CustomContextMenu);
+    m_plainEditor->setContextMenuPolicy(Qt::CustomContextMenu);
+    connect(m_richEditor, &QWidget::customContextMenuRequested, this, &PageEditor::showContextMenu);
+    connect(m_plainEditor, &QWidget::customContextMenuRequested, this, &PageEditor::showContextMenu);
+
+    // Only the active editor's notifications reach the page
+    connect(m_richEditor, &QTextEdit::textChanged, this, [this]()
+            { if (!m_largeMode) emit textChanged(); });
+    connect(m_plainEditor, &QPlainTextEdit::textChanged, this, [this]()
+            { if (m_largeMode) emit textChanged(); });
+
+    connectRichDocument();
+    connect(m_plainEditor->document(), &QTextDocument::contentsChange, this, [this](int position, int removed, int added)
+            { if (m_largeMode) emit contentsChange(position, removed, added); });
+
+    connect(m_richEditor, &PasteAwareTextEdit::largeInsertFinished, this, &PageEditor::largeInsertFinished);
+    connect(m_plainEditor, &PasteAwarePlainTextEdit::largeInsertFinished, this, &PageEditor::largeInsertFinished);
+
+    connect(m_imageLoader, &ImageLoader::loaded, this, &PageEditor::onImageLoaded);
+    connect(m_imageLoader, &ImageLoader::failed, this, &PageEditor::onImageFailed);
+
+    // Shared by every editor; only ever raised
+    QPixmapCache::setCacheLimit(qMax(QPixmapCache::cacheLimit(), ImageLoader::PixmapCacheLimit));
+
+    // Scrolling, resizes and relayouts all move images in or out of range;
+    // one pass per event loop turn covers them
+    m_imageTimer.setSingleShot(true);
+    m_imageTimer.setInterval(0);
+    connect(&m_imageTimer, &QTimer::timeout, this, &PageEditor::updateVisibleImages);
+    connect(m_richEditor->verticalScrollBar(), &QScrollBar::valueChanged, &m_imageTimer, qOverload<>(&QTimer::start));
+    connect(m_richEditor->verticalScrollBar(), &QScrollBar::rangeChanged, &m_imageTimer, qOverload<>(&QTimer::start));
+}
+
+void PageEditor::setPlainText(const QString &text)
+{
+    setLargeMode(text.size() > LargeDocumentThreshold);
+    if (!m_largeMode)
+    {
+        showRichDocument(m_richDocument);
+    }
+
+    TextStore *store = textStore();
+    store->suspendTracking();
+    if (m_largeMode)
+    {
+        m_plainEditor->setPlainText(text);
+    }
+    else
+    {
+        m_richEditor->setPlainText(text);
+    }
+    store->reset(document()->toPlainText());
+}
+
+QTextDocument *PageEditor::createDocument(const QString &text, QObject *parent)
+{
+    QTextDocument *document = buildDocument(text, documentStyle());
+    adoptDocument(document, parent);
+    return document;
+}
+
+PageEditor::DocumentStyle PageEditor::documentStyle() const
+{
+    DocumentStyle style;
+    style.font = m_richEditor->font();
+    if (m_richDocument)
+    {
+        style.option = m_richDocument->defaultTextOption();
+        style.margin = m_richDocument->documentMargin();
+    }
+    else
+    {
+        style.margin = QTextDocument().documentMargin();
+    }
+    return style;
+}
+
+QTextDocument *PageEditor::buildDocument(const QString &text, const DocumentStyle &style)
+{
+    QTextDocument *document = new QTextDocument;
+    document->setDefaultFont(style.font);
+    document->setDefaultTextOption(style.option);
+    document->setDocumentMargin(style.margin);
+    document->setPlainText(text);
+
+    new TextStore(document);
+    return document;
+}
+
+void PageEditor::adoptDocument(QTextDocument *document, QObject *parent)
+{
+    document->setParent(parent);
+    emit textStoreCreated(TextStore::forDocument(document));
+}
+
+void PageEditor::setDocument(QTextDocument *document)
+{
+    setLargeMode(false);
+    showRichDocument(document ? document : m_richDocument);
+}
+
+QString PageEditor::toPlainText() const
+{
+    return m_largeMode ? m_plainEditor->toPlainText() : m_richEditor->toPlainText();
+}
+
+QTextDocument *PageEditor::document() const
+{
+    return m_largeMode ? m_plainEditor->document() : m_richEditor->document();
+}
+
+QTextCursor PageEditor::textCursor() const
+{
+    return m_largeMode ? m_plainEditor->textCursor() : m_richEditor->textCursor();
+}
+
+void PageEditor::setTextCursor(const QTextCursor &cursor)
+{
+    if (m_largeMode)
+    {
+        m_plainEditor->setTextCursor(cursor);
+    }
+    else
+    {
+        m_richEditor->setTextCursor(cursor);
+    }
+}
+
+bool PageEditor::isReadOnly() const
+{
+    return m_largeMode ? m_plainEditor->isReadOnly() : m_richEditor->isReadOnly();
+}
+
+QWidget *PageEditor::richViewport() const
+{
+    return m_richEditor->viewport();
+}
+
+QTextCursor PageEditor::cursorForPosition(const QPoint &pos) const
+{
+    return m_largeMode ? m_plainEditor->cursorForPosition(pos) : m_richEditor->cursorForPosition(pos);
+}
+
+void PageEditor::setMarkdownEnabled(bool enabled)
+{
+    if (enabled == m_markdown)
+        return;
+
+    m_markdown = enabled;
+    updateHighlighter();
+}
+
+bool PageEditor::isMarkdownEnabled() const
+{
+    return m_markdown;
+}
+
+bool PageEditor::insertImageFile(const QString &path)
+{
+    // The large-document editor shows plain text only
+    if (m_largeMode || m_richEditor->isReadOnly())
+        return false;
+
+    PendingImage pending;
+    pending.document = m_richEditor->document();
+    pending.cursor = m_richEditor->textCursor();
+    pending.path = path;
+    m_pendingImages.insert(m_imageLoader->load(path), pending);
+    return true;
+}
+
+void PageEditor::placeImages(const QList<StoredImage> &images)
+{
+    if (m_largeMode)
+        return;
+
+    // Placing the shown page again keeps what is already on screen
+    QTextDocument *document = m_richEditor->document();
+    const QHash<QString, LazyImage> previous = std::exchange(m_lazyImages, QHash<QString, LazyImage>());
+    for (const StoredImage &image : images)
+    {
+        if (image.position < 0 || document->characterAt(image.position) != QChar::ObjectReplacementCharacter)
+            continue;
+
+        // Sized up front, so the page does not reflow when the pixels arrive
+        const QString name = QStringLiteral("image://%1").arg(image.id);
+        QTextImageFormat format;
+        format.setName(name);
+        format.setWidth(image.size.width());
+        format.setHeight(image.size.height());
+        format.setProperty(ImageIdProperty, image.id);
+
+        QTextCursor cursor(document);
+        cursor.setPosition(image.position);
+        cursor.setPosition(image.position + 1, QTextCursor::KeepAnchor);
+        cursor.setCharFormat(format);
+
+        LazyImage lazy;
+        lazy.cursor = QTextCursor(document);
+        lazy.cursor.setPosition(image.position);
+        lazy.path = image.path;
+        lazy.hash = image.hash;
+        lazy.id = image.id;
+        lazy.thumbnailSize = ImageLoader::thumbnailSize(image.size, devicePixelRatioF());
+        lazy.state = previous.value(name).state;
+        if (lazy.state == LazyImage::Placeholder)
+            document->addResource(QTextDocument::ImageResource, QUrl(name), placeholderPixmap());
+        m_lazyImages.insert(name, lazy);
+    }
+
+    m_imageTimer.start();
+}
+
+void PageEditor::updateVisibleImages()
+{
+    if (m_lazyImages.isEmpty() || m_largeMode)
+        return;
+
+    const int top = m_richEditor->verticalScrollBar()->value();
+    const int height = qMax(1, m_richEditor->viewport()->height());
+    const qreal loadTop = top - ImageLoadMargin * height;
+    const qreal loadBottom = top + (ImageLoadMargin + 1) * height;
+
+    QStringList names;
+    for (auto it = m_lazyImages.cbegin(); it != m_lazyImages.cend(); ++it)
+    {
+        if (it->state != LazyImage::Placeholder)
+            continue;
+
+        const QRectF rect = imageRect(it->cursor.position());
+        if (rect.isValid() && rect.bottom() >= loadTop && rect.top() <= loadBottom)
+            names.append(it.key());
+    }
+    for (const QString &name : names)
+        loadImage(name);
+
+    evictImages(false);
+}
+
+void PageEditor::loadImage(const QString &name)
+{
+    LazyImage &lazy = m_lazyImages[name];
+    QTextDocument *document = m_richEditor->document();
+    lazy.state = LazyImage::Loading;
+
+    if (!lazy.hash.isEmpty())
+    {
+        QPixmap pixmap;
+        if (QPixmapCache::find(ImageLoader::cacheKey(lazy.hash, lazy.thumbnailSize), &pixmap))
+        {
+            document->addResource(QTextDocument::ImageResource, QUrl(name), pixmap);
+            document->markContentsDirty(lazy.cursor.position(), 1);
+            lazy.state = LazyImage::Loaded;
+            return;
+        }
+    }
+
+    PendingImage pending;
+    pending.document = document;
+    pending.cursor = lazy.cursor;
+    pending.path = lazy.path;
+    pending.name = name;
+    pending.hash = lazy.hash;
+    pending.id = lazy.id;
+    pending.thumbnailSize = lazy.thumbnailSize;
+
+    if (!lazy.hash.isEmpty())
+    {
+        const QByteArray data = requestThumbnail(lazy.hash, lazy.thumbnailSize);
+        if (!data.isEmpty())
+        {
+            m_pendingImages.insert(m_imageLoader->loadData(data), pending);
+            return;
+        }
+    }
+
+    // No thumbnails yet: the one full decode of the file makes them
+    if (lazy.id >= 0 && !QFileInfo::exists(lazy.path))
+    {
+        emit originalRequested(lazy.id);
+        return;
+    }
+    m_pendingImages.insert(m_imageLoader->load(lazy.path, lazy.thumbnailSize), pending);
+}
+
+void PageEditor::provideOriginal(qint64 id, const QByteArray &data)
+{
+    for (auto it = m_lazyImages.begin(); it != m_lazyImages.end(); ++it)
+    {
+        // Evicted or turned away from meanwhile: the next load asks again
+        if (it->id != id || it->state != LazyImage::Loading)
+            continue;
+
+        if (data.isEmpty())
+        {
+            it->state = LazyImage::Loaded;
+            return;
+        }
+
+        PendingImage pending;
+        pending.document = m_richEditor->document();
+        pending.cursor = it->cursor;
+        pending.path = it->path;
+        pending.name = it.key();
+        pending.hash = it->hash;
+        pending.id = it->id;
+        pending.thumbnailSize = it->thumbnailSize;
+        m_pendingImages.insert(m_imageLoader->loadFileData(data, it->thumbnailSize), pending);
+        return;
+    }
+}
+
+void PageEditor::evictImages(bool all)
+{
+    // The pixels stay in QPixmapCache for a while, so coming back is cheap
+    const int top = m_richEditor->verticalScrollBar()->value();
+    const int height = qMax(1, m_richEditor->viewport()->height());
+    const qreal keepTop = top - ImageKeepMargin * height;
+    const qreal keepBottom = top + (ImageKeepMargin + 1) * height;
+
+    QTextDocument *document = m_richEditor->document();
+    for (auto it = m_lazyImages.begin(); it != m_lazyImages.end(); ++it)
+    {
+        if (it->state == LazyImage::Placeholder)
+            continue;
+
+        if (!all)
+        {
+            const QRectF rect = imageRect(it->cursor.position());
+            if (!rect.isValid() || (rect.bottom() >= keepTop && rect.top() <= keepBottom))
+                continue;
+        }
+
+        // A decode still running is dropped when it lands
+        it->state = LazyImage::Placeholder;
+        document->addResource(QTextDocument::ImageResource, QUrl(it.key()), placeholderPixmap());
+        if (!all)
+            document->markContentsDirty(it->cursor.position(), 1);
+    }
+}
+
+QRectF PageEditor::imageRect(int position) const
+{
+    // Invalid once the image's character has been deleted
+    QTextDocument *document = m_richEditor->document();
+    if (document->characterAt(position) != QChar::ObjectReplacementCharacter)
+        return QRectF();
+
+    const QTextBlock block = document->findBlock(position);
+    const QRectF blockRect = document->documentLayout()->blockBoundingRect(block);
+    const QTextLine line = block.layout() ? block.layout()->lineForTextPosition(position - block.position()) : QTextLine();
+    return line.isValid() ? line.rect().translated(blockRect.topLeft()) : blockRect;
+}
+
+void PageEditor::provideThumbnail(const QString &hash, int size, const QByteArray &data)
+{
+    if (!m_thumbnailRequest.isEmpty() && ImageLoader::cacheKey(hash, size) == m_thumbnailRequest)
+        m_thumbnailData = data;
+}
+
+QByteArray PageEditor::requestThumbnail(const QString &hash, int size)
+{
+    m_thumbnailRequest = ImageLoader::cacheKey(hash, size);
+    m_thumbnailData.clear();
+    emit thumbnailRequested(hash, size);
+    m_thumbnailRequest.clear();
+    return std::exchange(m_thumbnailData, QByteArray());
+}
+
+void PageEditor::setImageId(int position, qint64 id)
+{
+    QTextCursor cursor(document());
+    cursor.setPosition(position);
+    cursor.setPosition(position + 1, QTextCursor::KeepAnchor);
+    if (!cursor.charFormat().isImageFormat())
+        return;
+
+    QTextCharFormat format;
+    format.setProperty(ImageIdProperty, id);
+    cursor.mergeCharFormat(format);
+}
+
+void PageEditor::imagePositions(QTextDocument *document, QList<qint64> *ids, QList<int> *positions)
+{
+    const QString text = document->toRawText();
+    QTextCursor cursor(document);
+    for (int position = text.indexOf(QChar::ObjectReplacementCharacter); position >= 0;
+         position = text.indexOf(QChar::ObjectReplacementCharacter, position + 1))
+    {
+        cursor.setPosition(position + 1);
+        const QTextCharFormat format = cursor.charFormat();
+        if (format.isImageFormat() && format.hasProperty(ImageIdProperty))
+        {
+            ids->append(format.property(ImageIdProperty).toLongLong());
+            positions->append(position);
+        }
+    }
+}
+
+bool PageEditor::isLargeMode() const
+{
+    return m_largeMode;
+}
+
+TextStore *PageEditor::textStore() const
+{
+    return m_largeMode ? m_plainStore : TextStore::forDocument(m_richEditor->document());
+}
+
+bool PageEditor::eventFilter(QObject *watched, QEvent *event)
+{
+    if (event->type() == QEvent::ShortcutOverride || event->type() == QEvent::KeyPress)
+    {
+        QKeyEvent *keyEvent = static_cast<QKeyEvent *>(event);
+        const bool undo = keyEvent->matches(QKeySequence::Undo);
+        const bool redo = keyEvent->matches(QKeySequence::Redo);
+        if (undo || redo)
+        {
+            if (event->type() == QEvent::KeyPress)
+            {
+                undoRedo(redo);
+            }
+            event->accept();
+            return event->type() == QEvent::KeyPress;
+        }
+    }
+    return QStackedWidget::eventFilter(watched, event);
+}
+
+void PageEditor::undoRedo(bool redo)
+{
+    if (isReadOnly())
+        return;
+
+    TextStore *store = textStore();
+    const int caret = redo ? store->redo() : store->undo();
+    if (caret < 0)
+        return;
+
+    QTextCursor cursor = textCursor();
+    cursor.setPosition(caret);
+    setTextCursor(cursor);
+}
+
+void PageEditor::showContextMenu(const QPoint &pos)
+{
+    // `pos` is in viewport coordinates, as the standard menu expects
+    QMenu *menu = m_largeMode ? m_plainEditor->createStandardContextMenu(pos)
+                              : m_richEditor->createStandardContextMenu(pos);
+    QWidget *viewport = m_largeMode ? m_plainEditor->viewport() : m_richEditor->viewport();
+
+    // Its Undo and Redo follow the document's stack, which is always empty
+    TextStore *store = textStore();
+    for (QAction *action : menu->actions())
+    {
+        const bool undo = action->objectName() == QLatin1String("edit-undo");
+        const bool redo = action->objectName() == QLatin1String("edit-redo");
+        if (!undo && !redo)
+            continue;
+
+        disconnect(action, &QAction::triggered, nullptr, nullptr);
+        action->setEnabled(!isReadOnly() && (redo ? store->canRedo() : store->canUndo()));
+        connect(action, &QAction::triggered, this, [this, redo]()
+                { undoRedo(redo); });
+    }
+
+    menu->exec(viewport->mapToGlobal(pos));
+    delete menu;
+}
+
+void PageEditor::showRichDocument(QTextDocument *document)
+{
+    if (m_richEditor->document() == document)
+        return;
+
+    // A page kept in the cache holds placeholders, not pixels; placeImages()
+    // follows when it is shown again
+    evictImages(true);
+    m_lazyImages.clear();
+
+    m_richEditor->setDocument(document);
+    connectRichDocument();
+    updateHighlighter();
+}
+
+void PageEditor::connectRichDocument()
+{
+    disconnect(m_richContentsConnection);
+    m_richContentsConnection = connect(m_richEditor->document(), &QTextDocument::contentsChange, this, [this](int position, int removed, int added)
+                                       { if (!m_largeMode) emit contentsChange(position, removed, added); });
+}
+
+void PageEditor::updateHighlighter()
+{
+    // Cached documents that are not shown keep theirs until they are
+    if (m_markdown)
+    {
+        MarkdownHighlighter::install(document());
+    }
+    else
+    {
+        MarkdownHighlighter::uninstall(document());
+    }
+}
+
+void PageEditor::onImageLoaded(quint64 ticket, const QImage &image, const ImageThumbnails &thumbnails)
+{
+    PendingImage pending = m_pendingImages.take(ticket);
+
+    // A stored image decoded from its file: keep the thumbnails even if the
+    // page was left meanwhile
+    if (pending.id >= 0 && !thumbnails.hash.isEmpty())
+        emit thumbnailsReady(pending.id, thumbnails.hash, thumbnails.encoded);
+
+    if (!pending.document)
+        return;
+
+    if (!pending.name.isEmpty())
+    {
+        const QPixmap pixmap = QPixmap::fromImage(image);
+        const QString hash = pending.hash.isEmpty() ? thumbnails.hash : pending.hash;
+        if (!hash.isEmpty())
+            QPixmapCache::insert(ImageLoader::cacheKey(hash, pending.thumbnailSize), pixmap);
+
+        // Only while it is still wanted: on the shown page and not evicted
+        auto lazy = m_lazyImages.find(pending.name);
+        if (pending.document != m_richEditor->document() || lazy == m_lazyImages.end() ||
+            lazy->state != LazyImage::Loading)
+            return;
+
+        lazy->state = LazyImage::Loaded;
+        pending.document->addResource(QTextDocument::ImageResource, QUrl(pending.name), pixmap);
+        pending.document->markContentsDirty(pending.cursor.position(), 1);
+        return;
+    }
+
+    // New image: only onto the page it was asked for, while it is shown
+    if (m_largeMode || pending.document != m_richEditor->document())
+        return;
+
+    emit thumbnailsReady(-1, thumbnails.hash, thumbnails.encoded);
+
+    const QString name = QStringLiteral("image://new-%1").arg(ticket);
+    const QSize size = ImageLoader::displaySize(image.size());
+    pending.document->addResource(QTextDocument::ImageResource, QUrl(name), image);
+
+    QTextImageFormat format;
+    format.setName(name);
+    format.setWidth(size.width());
+    format.setHeight(size.height());
+
+    QTextCursor cursor = pending.cursor;
+    cursor.clearSelection();
+    cursor.insertImage(format);
+    emit imageInserted(pending.path, thumbnails.hash, cursor.position() - 1, size);
+}
+
+void PageEditor::onImageFailed(quint64 ticket, const QString &error)
+{
+    const PendingImage pending = m_pendingImages.take(ticket);
+
+    // Not retried on every scroll
+    auto lazy = m_lazyImages.find(pending.name);
+    if (!pending.name.isEmpty() && lazy != m_lazyImages.end() && lazy->state == LazyImage::Loading)
+        lazy->state = LazyImage::Loaded;
+
+    // A stored image that cannot be read keeps its empty frame
+    if (pending.name.isEmpty())
+        emit imageFailed(pending.path, error);
+}
+
+void PageEditor::setLargeMode(bool large)
+{
+    if (large == m_largeMode)
+        return;
+
+    m_largeMode = large;
+    setCurrentWidget(large ? static_cast<QWidget *>(m_plainEditor) : static_cast<QWidget *>(m_richEditor));
+
+    // Release the idle editor's document and its undo history
+    if (large)
+    {
+        // Leave a cached page document alone and empty the editor's own
+        showRichDocument(m_richDocument);
+        TextStore *richStore = TextStore::forDocument(m_richDocument);
+        richStore->suspendTracking();
+        m_richEditor->clear();
+        richStore->reset(QString());
+    }
+    else
+    {
+        m_plainStore->suspendTracking();
+        m_plainEditor->clear();
+        m_plainStore->reset(QString());
+    }
+    updateHighlighter();
+}
@@ -0,0 +1,209 @@
+// src/ui/page_editor.h
+// Text area shared by BookEditor and NoteEditor
+#ifndef PAGE_EDITOR_H
+#define PAGE_EDITOR_H
+
+#include <QFont>
+#include <QHash>
+#include <QPointer>
+#include <QStackedWidget>
+#include <QTextCursor>
+#include <QTextFormat>
+#include <QTextOption>
+#include <QTimer>
+
+class QImage;
+class QTextDocument;
+class TextStore;
+class ImageLoader;
+struct ImageThumbnails;
+class PasteAwareTextEdit;
+class PasteAwarePlainTextEdit;
+
+// A stored picture to put back into a loaded page: its row, the file it
+// came from, the content hash its thumbnails are kept under (empty while it
+// has none), its character's offset and the size it is shown at
+struct StoredImage
+{
+    qint64 id;
+    QString path;
+    QString hash;
+    int position;
+    QSize size;
+};
+
+// ============ Page Editor ============
+// Regular pages are edited in a QTextEdit, which lays out the whole document
+// up front. Pages above LargeDocumentThreshold switch to a QPlainTextEdit,
+// whose block layout only lays out paragraphs as they scroll into view.
+// Each editor's document is mirrored by a TextStore, which also owns undo.
+class PageEditor : public QStackedWidget
+{
+    Q_OBJECT
+
+public:
+    // Content size (UTF-16 units) above which the large-document editor is used
+    static constexpr qsizetype LargeDocumentThreshold = 512 * 1024;
+
+    // Font, tab stops and margin shared by the regular editor's documents.
+    // A plain value, so it can be handed to worker threads.
+    struct DocumentStyle
+    {
+        QFont font;
+        QTextOption option;
+        qreal margin;
+    };
+
+    explicit PageEditor(QWidget *parent = nullptr);
+
+    void setPlainText(const QString &text);
+    QString toPlainText() const;
+
+    // Documents made here match the regular editor's font and tab stops and
+    // come with a TextStore. setDocument() shows one in the regular editor
+    // without taking ownership; nullptr goes back to the editor's own.
+    QTextDocument *createDocument(const QString &text, QObject *parent);
+    void setDocument(QTextDocument *document);
+
+    // createDocument() in two halves: buildDocument() is safe on any thread
+    // and returns a parentless document; adoptDocument() takes it over on
+    // the GUI thread once it has been moved there
+    DocumentStyle documentStyle() const;
+    static QTextDocument *buildDocument(const QString &text, const DocumentStyle &style);
+    void adoptDocument(QTextDocument *document, QObject *parent);
+
+    QTextDocument *document() const;
+    QTextCursor textCursor() const;
+    void setTextCursor(const QTextCursor &cursor);
+    bool isReadOnly() const;
+    bool isLargeMode() const;
+    TextStore *textStore() const;
+
+    // Undo or redo through the shown document's TextStore and put the caret
+    // after the step. The shortcuts, the context menu and the Edit menu all
+    // come here, since the documents' own undo stacks are off.
+    void undoRedo(bool redo);
+
+    // The regular editor's viewport and hit testing, for inline objects
+    QWidget *richViewport() const;
+    QTextCursor cursorForPosition(const QPoint &pos) const;
+
+    // Markdown highlighting of whichever document is shown. Documents keep
+    // their highlighter while cached, so turning back to a page does not
+    // highlight it again.
+    void setMarkdownEnabled(bool enabled);
+    bool isMarkdownEnabled() const;
+
+    // Images are object replacement characters with an image format that
+    // carries the image's row id. insertImageFile() decodes in the
+    // background and inserts at the caret as it was when asked, unless the
+    // page has been left by then; thumbnailsReady() and imageInserted()
+    // follow. Stored images are put back with placeImages() after the text
+    // is loaded, as placeholders of their stored size. Only those within
+    // ImageLoadMargin viewports of the visible area are loaded, drawn from a
+    // thumbnail: QPixmapCache first, then thumbnailRequested(), and the
+    // original file only for pictures that have no thumbnails yet. When that
+    // file is gone, originalRequested() asks for the stored copy. Past
+    // ImageKeepMargin viewports, and when the page is left, they go back to
+    // placeholders.
+    static constexpr int ImageIdProperty = QTextFormat::UserProperty + 3;
+    static constexpr int ImageLoadMargin = 1;
+    static constexpr int ImageKeepMargin = 3;
+    bool insertImageFile(const QString &path);
+    void placeImages(const QList<StoredImage> &images);
+    void setImageId(int position, qint64 id);
+
+    // Answer to thumbnailRequested(), given while it is being emitted; no
+    // answer or empty data falls back to the file
+    void provideThumbnail(const QString &hash, int size, const QByteArray &data);
+
+    // Answer to originalRequested(), now or later: the file's bytes, or
+    // empty to leave the image's frame empty
+    void provideOriginal(qint64 id, const QByteArray &data);
+
+    // Row ids and positions of the stored images in `document`, in order
+    static void imagePositions(QTextDocument *document, QList<qint64> *ids, QList<int> *positions);
+
+signals:
+    // Forwarded from whichever editor is active
+    void textChanged();
+    void contentsChange(int position, int charsRemoved, int charsAdded);
+    void largeInsertFinished(bool completed);
+    void textStoreCreated(TextStore *store);
+    void imageInserted(const QString &path, const QString &hash, int position, const QSize &size);
+    void imageFailed(const QString &path, const QString &error);
+    void thumbnailRequested(const QString &hash, int size);
+    void originalRequested(qint64 id);
+
+    // One encoded thumbnail per ImageLoader::ThumbnailSizes entry; `id` is
+    // the image's row, or -1 for a picture about to be inserted
+    void thumbnailsReady(qint64 id, const QString &hash, const QList<QByteArray> &encoded);
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    void setLargeMode(bool large);
+    void showRichDocument(QTextDocument *document);
+    void connectRichDocument();
+    void updateHighlighter();
+    void showContextMenu(const QPoint &pos);
+    void updateVisibleImages();
+    void loadImage(const QString &name);
+    void evictImages(bool all);
+    QRectF imageRect(int position) const;
+    QByteArray requestThumbnail(const QString &hash, int size);
+    void onImageLoaded(quint64 ticket, const QImage &image, const ImageThumbnails &thumbnails);
+    void onImageFailed(quint64 ticket, const QString &error);
+
+    // A decode in flight: new images keep the caret to insert at, stored
+    // ones a cursor on their character, the resource name to fill and the
+    // thumbnail size they are drawn from
+    struct PendingImage
+    {
+        QPointer<QTextDocument> document;
+        QTextCursor cursor;
+        QString path;
+        QString name;
+        QString hash;
+        qint64 id = -1;
+        int thumbnailSize = 0;
+    };
+
+    // A stored image of the shown document, keyed by resource name. The
+    // cursor sits before its character and follows edits.
+    struct LazyImage
+    {
+        enum State
+        {
+            Placeholder,
+            Loading,
+            Loaded
+        };
+
+        QTextCursor cursor;
+        QString path;
+        QString hash;
+        qint64 id = -1;
+        int thumbnailSize = 0;
+        State state = Placeholder;
+    };
+
+    PasteAwareTextEdit *m_richEditor;
+    PasteAwarePlainTextEdit *m_plainEditor;
+    QTextDocument *m_richDocument;
+    TextStore *m_plainStore;
+    QMetaObject::Connection m_richContentsConnection;
+    ImageLoader *m_imageLoader;
+    QHash<quint64, PendingImage> m_pendingImages;
+    QHash<QString, LazyImage> m_lazyImages;
+    QTimer m_imageTimer;
+
+    // Cache key of the thumbnail being asked for, and the answer
+    QString m_thumbnailRequest;
+    QByteArray m_thumbnailData;
+    bool m_largeMode;
+    bool m_markdown;
+};
+
+#endif // PAGE_EDITOR_H
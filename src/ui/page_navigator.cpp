@@ -0,0 +1,45 @@
+// page_navigator.cpp
+#include "page_navigator.h"
+
+// ============ PageNavigator Implementation ============
+PageNavigator::PageNavigator(QObject *parent)
+    : QObject(parent), m_target(0)
+{
+    m_settleTimer.setSingleShot(true);
+    connect(&m_settleTimer, &QTimer::timeout, this, &PageNavigator::commit);
+}
+
+void PageNavigator::request(int page, int current)
+{
+    if (page == current)
+    {
+        cancel();
+        return;
+    }
+
+    m_target = page;
+    m_settleTimer.start(SettleDelay);
+}
+
+void PageNavigator::commit()
+{
+    m_settleTimer.stop();
+    if (m_target <= 0)
+        return;
+
+    // Cleared first: the load answers synchronously and may request again
+    const int page = m_target;
+    m_target = 0;
+    emit navigate(page);
+}
+
+void PageNavigator::cancel()
+{
+    m_settleTimer.stop();
+    m_target = 0;
+}
+
+bool PageNavigator::isPending() const
+{
+    return m_target > 0;
+}
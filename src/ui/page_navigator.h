@@ -0,0 +1,40 @@
+// src/ui/page_navigator.h
+// Coalesced page jumps from the page number box
+#ifndef PAGE_NAVIGATOR_H
+#define PAGE_NAVIGATOR_H
+
+#include <QObject>
+#include <QTimer>
+
+// ============ Page Navigator ============
+// The page box reports every intermediate value: typing "1250" passes
+// through 1, 12 and 125, and a held arrow key steps at key-repeat rate.
+// Each of those would load and decrypt a page. Requests here only restart
+// a settle timer; the last one is committed once input pauses, or at once
+// on commit() (Enter). A target still waiting when some other page turn
+// lands is dropped.
+class PageNavigator : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int SettleDelay = 300;
+
+    explicit PageNavigator(QObject *parent = nullptr);
+
+    // `current` is the page shown; asking for it drops any waiting target
+    void request(int page, int current);
+    void commit();
+    void cancel();
+
+    bool isPending() const;
+
+signals:
+    void navigate(int page);
+
+private:
+    QTimer m_settleTimer;
+    int m_target;
+};
+
+#endif // PAGE_NAVIGATOR_H
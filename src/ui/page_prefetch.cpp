@@ -0,0 +1,114 @@
+// page_prefetch.cpp
+#include "page_prefetch.h"
+#include <QTextDocument>
+#include <QThread>
+
+// ============ PagePrefetcher Implementation ============
+PagePrefetcher::PagePrefetcher(QObject *parent)
+    : QObject(parent), m_generation(0), m_page(0), m_direction(0), m_streak(0)
+{
+    m_idleTimer.setSingleShot(true);
+    connect(&m_idleTimer, &QTimer::timeout, this, &PagePrefetcher::requestNeighbours);
+
+    // One build at a time, below the GUI thread
+    m_pool.setMaxThreadCount(1);
+    m_pool.setThreadPriority(QThread::LowPriority);
+}
+
+void PagePrefetcher::setPrepare(Prepare prepare)
+{
+    m_prepare = std::move(prepare);
+}
+
+void PagePrefetcher::pageShown(int page)
+{
+    const int step = page - m_page;
+    const int direction = (step == 1 || step == -1) ? step : 0;
+
+    // Jumps and reloads of the same page reset the streak
+    if (direction != 0 && direction == m_direction)
+        ++m_streak;
+    else
+        m_streak = 0;
+
+    m_direction = direction;
+    m_page = page;
+
+    // Rapid paging only fetches for the page the reader stops on
+    m_idleTimer.start(IdleDelay);
+}
+
+void PagePrefetcher::build(int page, const QString &text, const PageEditor::DocumentStyle &style)
+{
+    if (m_building.contains(page))
+        return;
+    m_building.insert(page);
+
+    const quint64 generation = m_generation;
+    const Prepare prepare = m_prepare;
+    QThread *guiThread = thread();
+
+    m_pool.start([this, page, text, style, generation, prepare, guiThread]()
+                 {
+        QTextDocument *document = PageEditor::buildDocument(text, style);
+        if (prepare)
+            prepare(document);
+        const size_t contentHash = qHash(text);
+
+        // Hand the document (and its TextStore) to the GUI thread
+        document->moveToThread(guiThread);
+
+        QMetaObject::invokeMethod(this, [this, page, document, contentHash, generation]()
+                                  {
+            // A build from before reset() no longer owns the in-flight
+            // marker; a newer build of the same page may hold it
+            if (generation != m_generation)
+            {
+                delete document;
+                return;
+            }
+            m_building.remove(page);
+            emit documentReady(page, document, contentHash); }, Qt::QueuedConnection); });
+}
+
+void PagePrefetcher::reset()
+{
+    m_idleTimer.stop();
+    m_building.clear();
+    ++m_generation;
+    m_page = 0;
+    m_direction = 0;
+    m_streak = 0;
+}
+
+void PagePrefetcher::requestNeighbours()
+{
+    for (int page : candidates())
+        emit requestPage(page);
+}
+
+QList<int> PagePrefetcher::candidates() const
+{
+    QList<int> pages;
+    if (m_direction == 0)
+    {
+        pages << m_page + 1 << m_page - 1;
+    }
+    else
+    {
+        // Further ahead the longer the reader keeps going one way, and one
+        // page back in case they turn around
+        const int depth = qMin(1 + m_streak, MaxDepth);
+        for (int i = 1; i <= depth; ++i)
+            pages << m_page + i * m_direction;
+        pages << m_page - m_direction;
+    }
+
+    QList<int> valid;
+    for (int page : pages)
+    {
+        if (page >= 1 && !m_building.contains(page))
+            valid << page;
+    }
+    return valid;
+}
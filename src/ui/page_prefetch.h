@@ -0,0 +1,72 @@
+// src/ui/page_prefetch.h
+// Speculative loading of the pages next to the one being read
+#ifndef PAGE_PREFETCH_H
+#define PAGE_PREFETCH_H
+
+#include "page_editor.h"
+#include <QObject>
+#include <QSet>
+#include <QThreadPool>
+#include <QTimer>
+#include <functional>
+
+class QTextDocument;
+
+// ============ Page Prefetcher ============
+// Once the reader has settled on a page, asks for its neighbours so the next
+// page turn can swap in a ready document. The look-ahead follows the way the
+// reader is paging: one page either side at first, growing up to MaxDepth
+// pages ahead while they keep going the same way. Documents are built and
+// word-counted on a low-priority worker thread; results for an entry that is
+// no longer open are dropped.
+class PagePrefetcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int IdleDelay = 300;
+    static constexpr int MaxDepth = 3;
+
+    // Run on the worker after a document is built, e.g. to cache word counts
+    using Prepare = std::function<void(QTextDocument *)>;
+
+    explicit PagePrefetcher(QObject *parent = nullptr);
+
+    void setPrepare(Prepare prepare);
+
+    // The reader is now on `page`; neighbours are requested once idle
+    void pageShown(int page);
+
+    // Content for a requested page; the document arrives via documentReady()
+    void build(int page, const QString &text, const PageEditor::DocumentStyle &style);
+
+    // The entry changed: forget the direction and drop builds in flight
+    void reset();
+
+signals:
+    // Nearest first; the handler decides whether the page is worth fetching
+    void requestPage(int page);
+
+    // `document` has no parent and lives on the GUI thread; the receiver
+    // takes ownership
+    void documentReady(int page, QTextDocument *document, size_t contentHash);
+
+private slots:
+    void requestNeighbours();
+
+private:
+    QList<int> candidates() const;
+
+    QTimer m_idleTimer;
+    Prepare m_prepare;
+    QSet<int> m_building;
+    quint64 m_generation;
+    int m_page;
+    int m_direction;
+    int m_streak;
+
+    // Last, so its destructor waits for running builds before the rest goes
+    QThreadPool m_pool;
+};
+
+#endif // PAGE_PREFETCH_H
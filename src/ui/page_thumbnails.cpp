@@ -0,0 +1,262 @@
+// page_thumbnails.cpp
+#include "page_thumbnails.h"
+#include <QAbstractTextDocumentLayout>
+#include <QImage>
+#include <QPainter>
+#include <QScrollBar>
+#include <QTextDocument>
+#include <QThread>
+
+namespace
+{
+    // Pages are laid out at reading width, then scaled down
+    constexpr int RenderWidth = 560;
+    constexpr int RenderPadding = 36;
+
+    // Text past this cannot show in a thumbnail, so it is not laid out
+    constexpr int RenderTextLimit = 6000;
+
+    const QColor PageColor("#252525");
+    const QColor TextColor("#c5c5c5");
+    const QColor PlaceholderColor("#5a5a5a");
+
+    QImage renderThumbnail(const QString &content, const PageEditor::DocumentStyle &style)
+    {
+        const qreal scale = qreal(PageThumbnailModel::ThumbnailWidth) / RenderWidth;
+        const QRectF pageRect(0, 0, RenderWidth, PageThumbnailModel::ThumbnailHeight / scale);
+
+        QTextDocument document;
+        document.setDefaultFont(style.font);
+        document.setDefaultTextOption(style.option);
+        document.setDocumentMargin(RenderPadding);
+        document.setPlainText(content.left(RenderTextLimit));
+        document.setTextWidth(RenderWidth);
+
+        QImage image(PageThumbnailModel::ThumbnailWidth, PageThumbnailModel::ThumbnailHeight,
+                     QImage::Format_ARGB32_Premultiplied);
+        image.fill(PageColor);
+
+        QPainter painter(&image);
+        painter.setRenderHint(QPainter::Antialiasing);
+        painter.setRenderHint(QPainter::TextAntialiasing);
+        painter.scale(scale, scale);
+
+        QAbstractTextDocumentLayout::PaintContext context;
+        context.palette.setColor(QPalette::Text, TextColor);
+        context.clip = pageRect;
+        document.documentLayout()->draw(&painter, context);
+
+        return image;
+    }
+}
+
+// ============ PageThumbnailModel Implementation ============
+PageThumbnailModel::PageThumbnailModel(QObject *parent)
+    : QAbstractListModel(parent), m_cache(CacheBytes / 1024), m_generation(0), m_pageCount(0)
+{
+    // Blank page shown until a thumbnail arrives
+    m_placeholder = QPixmap(ThumbnailWidth, ThumbnailHeight);
+    m_placeholder.fill(PageColor);
+
+    m_pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() / 2));
+    m_pool.setThreadPriority(QThread::LowPriority);
+}
+
+int PageThumbnailModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_pageCount;
+}
+
+QVariant PageThumbnailModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_pageCount)
+        return QVariant();
+
+    const int page = index.row() + 1;
+    switch (role)
+    {
+    case Qt::DisplayRole:
+        return QString::number(page);
+    case Qt::DecorationRole:
+    {
+        if (const QPixmap *pixmap = m_cache.object(cacheKey(page)))
+            return *pixmap;
+        return m_placeholder;
+    }
+    case Qt::ToolTipRole:
+        return tr("Page %1").arg(page);
+    case Qt::ForegroundRole:
+        return m_cache.contains(cacheKey(page)) ? TextColor : PlaceholderColor;
+    default:
+        return QVariant();
+    }
+}
+
+void PageThumbnailModel::setDocumentStyle(const PageEditor::DocumentStyle &style)
+{
+    m_style = style;
+}
+
+void PageThumbnailModel::setPageCount(int count)
+{
+    count = qMax(count, 0);
+    if (count == m_pageCount)
+        return;
+
+    beginResetModel();
+    m_pageCount = count;
+    endResetModel();
+}
+
+void PageThumbnailModel::clear()
+{
+    // Renders still running belong to the old content
+    ++m_generation;
+    m_cache.clear();
+    m_revisions.clear();
+    m_requested.clear();
+    m_rendering.clear();
+
+    beginResetModel();
+    m_pageCount = 0;
+    endResetModel();
+}
+
+void PageThumbnailModel::invalidatePage(int page)
+{
+    if (page < 1 || page > m_pageCount)
+        return;
+
+    m_cache.remove(cacheKey(page));
+    ++m_revisions[page];
+    m_requested.remove(page);
+    m_rendering.remove(page);
+
+    const QModelIndex row = index(page - 1);
+    emit dataChanged(row, row, {Qt::DecorationRole, Qt::ForegroundRole});
+}
+
+void PageThumbnailModel::fetch(int first, int last)
+{
+    first = qMax(first, 1);
+    last = qMin(last, m_pageCount);
+    for (int page = first; page <= last; ++page)
+    {
+        if (m_cache.contains(cacheKey(page)) || m_requested.contains(page) || m_rendering.contains(page))
+            continue;
+
+        m_requested.insert(page);
+        emit pageRequested(page);
+    }
+}
+
+void PageThumbnailModel::setPageContent(int page, const QString &content)
+{
+    if (!m_requested.remove(page))
+        return;
+    m_rendering.insert(page);
+
+    const PageEditor::DocumentStyle style = m_style;
+    const quint64 revision = m_revisions.value(page);
+    const quint64 generation = m_generation;
+
+    m_pool.start([this, page, content, style, revision, generation]()
+                 {
+        const QImage image = renderThumbnail(content, style);
+        QMetaObject::invokeMethod(this, [this, page, revision, generation, image]()
+                                  { onRendered(page, revision, generation, image); }, Qt::QueuedConnection); });
+}
+
+void PageThumbnailModel::onRendered(int page, quint64 revision, quint64 generation, const QImage &image)
+{
+    // Saved again, or another entry opened, while this one rendered
+    if (generation != m_generation || revision != m_revisions.value(page) || !m_rendering.remove(page))
+        return;
+
+    // QPixmap is GUI-thread only, so the conversion happens here
+    m_cache.insert(cacheKey(page), new QPixmap(QPixmap::fromImage(image)), image.sizeInBytes() / 1024);
+
+    const QModelIndex row = index(page - 1);
+    emit dataChanged(row, row, {Qt::DecorationRole, Qt::ForegroundRole});
+}
+
+quint64 PageThumbnailModel::cacheKey(int page) const
+{
+    return (quint64(quint32(page)) << 32) | quint32(m_revisions.value(page));
+}
+
+// ============ PageThumbnailStrip Implementation ============
+PageThumbnailStrip::PageThumbnailStrip(PageThumbnailModel *model, QWidget *parent)
+    : QListView(parent), m_model(model)
+{
+    setModel(model);
+    setViewMode(QListView::ListMode);
+    setFlow(QListView::TopToBottom);
+    setUniformItemSizes(true);
+    setIconSize(QSize(PageThumbnailModel::ThumbnailWidth, PageThumbnailModel::ThumbnailHeight));
+    setSpacing(6);
+    setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    setEditTriggers(QAbstractItemView::NoEditTriggers);
+    setFixedWidth(PageThumbnailModel::ThumbnailWidth + 64);
+
+    m_fetchTimer.setSingleShot(true);
+    connect(&m_fetchTimer, &QTimer::timeout, this, &PageThumbnailStrip::fetchVisible);
+    connect(verticalScrollBar(), &QScrollBar::valueChanged, this, [this]()
+            { m_fetchTimer.start(FetchDelay); });
+    connect(model, &QAbstractItemModel::modelReset, this, [this]()
+            { m_fetchTimer.start(FetchDelay); });
+    connect(model, &QAbstractItemModel::dataChanged, this, [this]()
+            {
+        // Invalidated rows in view are fetched again
+        if (!m_fetchTimer.isActive())
+            m_fetchTimer.start(FetchDelay); });
+    connect(this, &QListView::clicked, this, [this](const QModelIndex &index)
+            { emit pageActivated(index.row() + 1); });
+}
+
+void PageThumbnailStrip::setCurrentPage(int page)
+{
+    const QModelIndex index = m_model->index(page - 1);
+    if (!index.isValid())
+        return;
+
+    setCurrentIndex(index);
+    scrollTo(index);
+}
+
+void PageThumbnailStrip::resizeEvent(QResizeEvent *event)
+{
+    QListView::resizeEvent(event);
+    m_fetchTimer.start(FetchDelay);
+}
+
+void PageThumbnailStrip::showEvent(QShowEvent *event)
+{
+    QListView::showEvent(event);
+    m_fetchTimer.start(FetchDelay);
+}
+
+void PageThumbnailStrip::fetchVisible()
+{
+    if (!isVisible() || m_model->rowCount() == 0)
+        return;
+
+    // A point may fall into the spacing between items, so probe once more
+    // past it
+    const int x = viewport()->width() / 2;
+    const int step = 2 * spacing() + 1;
+    auto rowAt = [this, x, step](int y, int direction, int fallback)
+    {
+        for (int probe = 0; probe < 2; ++probe, y += direction * step)
+        {
+            const QModelIndex index = indexAt(QPoint(x, y));
+            if (index.isValid())
+                return index.row();
+        }
+        return fallback;
+    };
+    const int firstRow = rowAt(0, 1, 0);
+    const int lastRow = rowAt(viewport()->height() - 1, -1, m_model->rowCount() - 1);
+
+    m_model->fetch(firstRow + 1 - FetchMargin, lastRow + 1 + FetchMargin);
+}
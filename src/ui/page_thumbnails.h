@@ -0,0 +1,100 @@
+// src/ui/page_thumbnails.h
+// Miniature page previews for jumping around a book
+#ifndef PAGE_THUMBNAILS_H
+#define PAGE_THUMBNAILS_H
+
+#include "page_editor.h"
+#include <QAbstractListModel>
+#include <QCache>
+#include <QHash>
+#include <QListView>
+#include <QPixmap>
+#include <QSet>
+#include <QThreadPool>
+#include <QTimer>
+
+// ============ Page Thumbnail Model ============
+// One row per page. Thumbnails are rasterized on worker threads and cached
+// by (page, revision); a page's revision only moves when it is saved or
+// split, so scrolling back over a page never renders it twice. Rows with no
+// thumbnail yet show the page number until fetch() is asked for them.
+class PageThumbnailModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    static constexpr int ThumbnailWidth = 96;
+    static constexpr int ThumbnailHeight = 136;
+    static constexpr int CacheBytes = 16 * 1024 * 1024;
+
+    explicit PageThumbnailModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    void setDocumentStyle(const PageEditor::DocumentStyle &style);
+    void setPageCount(int count);
+
+    // Drops every thumbnail, e.g. when another entry opens
+    void clear();
+
+    // The page's stored text changed; its thumbnail is rendered again
+    void invalidatePage(int page);
+
+    // Asks for thumbnails of pages [first, last] that are missing
+    void fetch(int first, int last);
+
+    // Answer to pageRequested(); content nobody asked for is ignored
+    void setPageContent(int page, const QString &content);
+
+signals:
+    void pageRequested(int page);
+
+private:
+    void onRendered(int page, quint64 revision, quint64 generation, const QImage &image);
+    quint64 cacheKey(int page) const;
+
+    PageEditor::DocumentStyle m_style;
+    QPixmap m_placeholder;
+    QCache<quint64, QPixmap> m_cache;
+    QHash<int, quint64> m_revisions;
+    QSet<int> m_requested;
+    QSet<int> m_rendering;
+    quint64 m_generation;
+    int m_pageCount;
+
+    // Last, so its destructor waits for running renders before the rest goes
+    QThreadPool m_pool;
+};
+
+// ============ Page Thumbnail Strip ============
+// Sidebar list of the model's rows. Items have a uniform size, so the view
+// only touches the rows on screen; thumbnails are fetched for those once
+// scrolling pauses, so flinging past a thousand pages renders none of them.
+class PageThumbnailStrip : public QListView
+{
+    Q_OBJECT
+
+public:
+    static constexpr int FetchDelay = 120;
+    static constexpr int FetchMargin = 4;
+
+    explicit PageThumbnailStrip(PageThumbnailModel *model, QWidget *parent = nullptr);
+
+    void setCurrentPage(int page);
+
+signals:
+    void pageActivated(int page);
+
+protected:
+    void resizeEvent(QResizeEvent *event) override;
+    void showEvent(QShowEvent *event) override;
+
+private:
+    void fetchVisible();
+
+    PageThumbnailModel *m_model;
+    QTimer m_fetchTimer;
+};
+
+#endif // PAGE_THUMBNAILS_H
@@ -0,0 +1,402 @@
+// piece_table.cpp
+#include "piece_table.h"
+#include <algorithm>
+
+struct PieceTable::Buffer
+{
+    std::unique_ptr<QChar[]> data;
+    qsizetype capacity;
+    qsizetype used;
+};
+
+struct PieceTable::Node
+{
+    std::shared_ptr<const Buffer> buffer;
+    qsizetype start;
+    qsizetype length;
+    qsizetype utf8Length;
+    quint32 priority;
+    NodePtr left;
+    NodePtr right;
+    qsizetype subtreeLength;
+    qsizetype subtreeUtf8;
+    qsizetype subtreePieces;
+};
+
+namespace
+{
+    using Node = PieceTable::Node;
+    using NodePtr = PieceTable::NodePtr;
+
+    qsizetype lengthOf(const NodePtr &node)
+    {
+        return node ? node->subtreeLength : 0;
+    }
+
+    qsizetype utf8Of(const NodePtr &node)
+    {
+        return node ? node->subtreeUtf8 : 0;
+    }
+
+    qsizetype piecesOf(const NodePtr &node)
+    {
+        return node ? node->subtreePieces : 0;
+    }
+
+    // UTF-8 size of a run of UTF-16 units; each half of a surrogate pair
+    // counts two bytes, so a piece may end between the halves
+    qsizetype utf8Length(const QChar *data, qsizetype length)
+    {
+        qsizetype bytes = 0;
+        for (qsizetype i = 0; i < length; ++i)
+        {
+            const ushort unit = data[i].unicode();
+            bytes += unit < 0x80 ? 1 : (unit < 0x800 || QChar::isSurrogate(unit)) ? 2 : 3;
+        }
+        return bytes;
+    }
+
+    // UTF-8 size of the first `count` units of a piece, scanning whichever
+    // side of the split is shorter
+    qsizetype utf8Prefix(const Node &piece, qsizetype count)
+    {
+        const QChar *data = piece.buffer->data.get() + piece.start;
+        if (count <= piece.length / 2)
+            return utf8Length(data, count);
+        return piece.utf8Length - utf8Length(data + count, piece.length - count);
+    }
+
+    // Copies a piece under new children; the only way nodes are ever built
+    NodePtr withChildren(const Node &piece, NodePtr left, NodePtr right)
+    {
+        const qsizetype length = piece.length + lengthOf(left) + lengthOf(right);
+        const qsizetype utf8 = piece.utf8Length + utf8Of(left) + utf8Of(right);
+        const qsizetype pieces = 1 + piecesOf(left) + piecesOf(right);
+        return std::make_shared<const Node>(Node{piece.buffer, piece.start, piece.length, piece.utf8Length, piece.priority,
+                                                 std::move(left), std::move(right), length, utf8, pieces});
+    }
+
+    const Node *lastPiece(const NodePtr &node)
+    {
+        const Node *current = node.get();
+        while (current && current->right)
+            current = current->right.get();
+        return current;
+    }
+
+    NodePtr extendLast(const NodePtr &node, qsizetype extra, qsizetype extraUtf8)
+    {
+        if (node->right)
+            return withChildren(*node, node->left, extendLast(node->right, extra, extraUtf8));
+
+        Node piece = *node;
+        piece.length += extra;
+        piece.utf8Length += extraUtf8;
+        return withChildren(piece, node->left, nullptr);
+    }
+
+    // Appends [from, to) of the subtree, in subtree-relative positions
+    void appendRange(const NodePtr &node, qsizetype from, qsizetype to, QString &out)
+    {
+        if (!node || from >= to)
+            return;
+
+        const qsizetype leftLength = lengthOf(node->left);
+        if (from < leftLength)
+            appendRange(node->left, from, qMin(to, leftLength), out);
+
+        const qsizetype pieceFrom = qMax(from - leftLength, qsizetype(0));
+        const qsizetype pieceTo = qMin(to - leftLength, node->length);
+        if (pieceFrom < pieceTo)
+            out.append(node->buffer->data.get() + node->start + pieceFrom, pieceTo - pieceFrom);
+
+        const qsizetype rightBase = leftLength + node->length;
+        if (to > rightBase)
+            appendRange(node->right, qMax(from - rightBase, qsizetype(0)), to - rightBase, out);
+    }
+}
+
+// ============ Snapshot Implementation ============
+PieceTable::Snapshot::Snapshot(NodePtr root)
+    : m_root(std::move(root))
+{
+}
+
+bool PieceTable::Snapshot::isEmpty() const
+{
+    return lengthOf(m_root) == 0;
+}
+
+qsizetype PieceTable::Snapshot::size() const
+{
+    return lengthOf(m_root);
+}
+
+qsizetype PieceTable::Snapshot::utf8Size() const
+{
+    return utf8Of(m_root);
+}
+
+qsizetype PieceTable::Snapshot::pieceCount() const
+{
+    return piecesOf(m_root);
+}
+
+QString PieceTable::Snapshot::toString() const
+{
+    return mid(0, size());
+}
+
+QString PieceTable::Snapshot::mid(qsizetype position, qsizetype length) const
+{
+    const qsizetype from = qBound(qsizetype(0), position, size());
+    const qsizetype to = qBound(from, from + length, size());
+
+    QString out;
+    out.reserve(to - from);
+    appendRange(m_root, from, to, out);
+    return out;
+}
+
+// ============ PieceTable Implementation ============
+PieceTable::PieceTable()
+    : m_seed(0x9E3779B9u)
+{
+}
+
+PieceTable::PieceTable(const QString &text)
+    : m_seed(0x9E3779B9u)
+{
+    reset(text);
+}
+
+qsizetype PieceTable::size() const
+{
+    return lengthOf(m_root);
+}
+
+qsizetype PieceTable::utf8Size() const
+{
+    return utf8Of(m_root);
+}
+
+qsizetype PieceTable::utf8Offset(qsizetype position) const
+{
+    position = qBound(qsizetype(0), position, size());
+
+    qsizetype bytes = 0;
+    const Node *node = m_root.get();
+    while (node)
+    {
+        const qsizetype leftLength = lengthOf(node->left);
+        if (position <= leftLength)
+        {
+            node = node->left.get();
+            continue;
+        }
+
+        bytes += utf8Of(node->left);
+        position -= leftLength;
+        if (position <= node->length)
+            return bytes + utf8Prefix(*node, position);
+
+        bytes += node->utf8Length;
+        position -= node->length;
+        node = node->right.get();
+    }
+    return bytes;
+}
+
+qsizetype PieceTable::pieceCount() const
+{
+    return piecesOf(m_root);
+}
+
+QString PieceTable::toString() const
+{
+    return snapshot().toString();
+}
+
+QString PieceTable::mid(qsizetype position, qsizetype length) const
+{
+    return snapshot().mid(position, length);
+}
+
+PieceTable::Snapshot PieceTable::snapshot() const
+{
+    return Snapshot(m_root);
+}
+
+PieceTable::Snapshot PieceTable::insert(qsizetype position, const QString &text)
+{
+    if (text.isEmpty())
+        return Snapshot();
+
+    position = qBound(qsizetype(0), position, size());
+    const qsizetype length = text.size();
+
+    std::pair<NodePtr, NodePtr> parts = split(m_root, position);
+
+    // Typing extends the piece right before the caret when it already ends
+    // where the add chunk does, so a sentence stays one piece
+    bool extend = false;
+    if (!m_addChunk || m_addChunk->capacity - m_addChunk->used < length)
+    {
+        m_addChunk = newBuffer(qMax(ChunkCapacity, length));
+    }
+    else if (const Node *last = lastPiece(parts.first))
+    {
+        extend = last->buffer == m_addChunk && last->start + last->length == m_addChunk->used;
+    }
+
+    const qsizetype start = m_addChunk->used;
+    std::copy(text.constData(), text.constData() + length, m_addChunk->data.get() + start);
+    m_addChunk->used += length;
+
+    const qsizetype utf8 = utf8Length(text.constData(), length);
+    NodePtr inserted = makeLeaf(m_addChunk, start, length, utf8);
+    NodePtr left = extend ? extendLast(parts.first, length, utf8) : merge(parts.first, inserted);
+    m_root = merge(left, parts.second);
+
+    return Snapshot(inserted);
+}
+
+PieceTable::Snapshot PieceTable::remove(qsizetype position, qsizetype length)
+{
+    position = qBound(qsizetype(0), position, size());
+    length = qBound(qsizetype(0), length, size() - position);
+    if (length == 0)
+        return Snapshot();
+
+    std::pair<NodePtr, NodePtr> head = split(m_root, position);
+    std::pair<NodePtr, NodePtr> tail = split(head.second, length);
+    m_root = merge(head.first, tail.second);
+
+    return Snapshot(tail.first);
+}
+
+void PieceTable::insert(qsizetype position, const Snapshot &pieces)
+{
+    if (pieces.isEmpty())
+        return;
+
+    position = qBound(qsizetype(0), position, size());
+    std::pair<NodePtr, NodePtr> parts = split(m_root, position);
+    m_root = merge(merge(parts.first, pieces.m_root), parts.second);
+}
+
+PieceTable::Snapshot PieceTable::concat(const Snapshot &first, const Snapshot &second)
+{
+    return Snapshot(merge(first.m_root, second.m_root));
+}
+
+void PieceTable::reset(const QString &text)
+{
+    m_root.reset();
+    m_addChunk.reset();
+
+    if (!text.isEmpty())
+    {
+        std::shared_ptr<Buffer> original = newBuffer(text.size());
+        std::copy(text.constData(), text.constData() + text.size(), original->data.get());
+        original->used = text.size();
+        m_root = makeLeaf(original, 0, text.size(), utf8Length(text.constData(), text.size()));
+    }
+}
+
+void PieceTable::compact()
+{
+    reset(toString());
+}
+
+qsizetype PieceTable::memoryUsage() const
+{
+    qsizetype bytes = nodeMemory(pieceCount());
+    for (const std::weak_ptr<const Buffer> &weak : m_buffers)
+    {
+        if (std::shared_ptr<const Buffer> buffer = weak.lock())
+            bytes += qsizetype(sizeof(Buffer)) + buffer->capacity * qsizetype(sizeof(QChar));
+    }
+    return bytes;
+}
+
+qsizetype PieceTable::nodeMemory(qsizetype pieces)
+{
+    // make_shared puts the control block next to the node
+    return pieces * qsizetype(sizeof(Node) + 2 * sizeof(void *));
+}
+
+PieceTable::NodePtr PieceTable::makeLeaf(const std::shared_ptr<const Buffer> &buffer, qsizetype start, qsizetype length, qsizetype utf8)
+{
+    return withChildren(Node{buffer, start, length, utf8, nextPriority(), nullptr, nullptr, 0, 0, 0}, nullptr, nullptr);
+}
+
+PieceTable::NodePtr PieceTable::merge(const NodePtr &left, const NodePtr &right)
+{
+    if (!left)
+        return right;
+    if (!right)
+        return left;
+
+    if (left->priority > right->priority)
+        return withChildren(*left, left->left, merge(left->right, right));
+    return withChildren(*right, merge(left, right->left), right->right);
+}
+
+std::pair<PieceTable::NodePtr, PieceTable::NodePtr> PieceTable::split(const NodePtr &node, qsizetype position)
+{
+    if (!node)
+        return {nullptr, nullptr};
+    if (position <= 0)
+        return {nullptr, node};
+    if (position >= node->subtreeLength)
+        return {node, nullptr};
+
+    const qsizetype leftLength = lengthOf(node->left);
+    if (position <= leftLength)
+    {
+        std::pair<NodePtr, NodePtr> parts = split(node->left, position);
+        return {parts.first, withChildren(*node, parts.second, node->right)};
+    }
+
+    const qsizetype pieceEnd = leftLength + node->length;
+    if (position >= pieceEnd)
+    {
+        std::pair<NodePtr, NodePtr> parts = split(node->right, position - pieceEnd);
+        return {withChildren(*node, node->left, parts.first), parts.second};
+    }
+
+    // The position falls inside this piece: keep the head in place and merge
+    // the tail, as a fresh leaf, in front of the right subtree
+    const qsizetype offset = position - leftLength;
+    Node head = *node;
+    head.length = offset;
+    head.utf8Length = utf8Prefix(*node, offset);
+    NodePtr tail = makeLeaf(node->buffer, node->start + offset, node->length - offset, node->utf8Length - head.utf8Length);
+    return {withChildren(head, node->left, nullptr), merge(tail, node->right)};
+}
+
+std::shared_ptr<PieceTable::Buffer> PieceTable::newBuffer(qsizetype capacity)
+{
+    // Forget buffers nothing references any more
+    m_buffers.erase(std::remove_if(m_buffers.begin(), m_buffers.end(),
+                                   [](const std::weak_ptr<const Buffer> &weak)
+                                   { return weak.expired(); }),
+                    m_buffers.end());
+
+    std::shared_ptr<Buffer> buffer = std::make_shared<Buffer>();
+    buffer->capacity = capacity;
+    buffer->data.reset(new QChar[capacity]);
+    buffer->used = 0;
+    m_buffers.push_back(buffer);
+    return buffer;
+}
+
+quint32 PieceTable::nextPriority()
+{
+    // xorshift32; treap balance only needs the priorities to look random
+    m_seed ^= m_seed << 13;
+    m_seed ^= m_seed >> 17;
+    m_seed ^= m_seed << 5;
+    return m_seed;
+}
@@ -0,0 +1,94 @@
+// src/ui/piece_table.h
+// Persistent piece-table text store
+#ifndef PIECE_TABLE_H
+#define PIECE_TABLE_H
+
+#include <QString>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// ============ Piece Table ============
+// Text is a sequence of pieces pointing into immutable buffers: the text the
+// table was reset with, plus append-only add chunks for everything typed
+// since. Pieces live in a persistent treap ordered by position and augmented
+// with subtree lengths, so inserts and deletes are O(log n) and only copy the
+// path they touch. Nodes are never mutated once built, which makes a snapshot
+// a single root pointer that any thread can read while editing continues.
+class PieceTable
+{
+public:
+    struct Buffer;
+    struct Node;
+    using NodePtr = std::shared_ptr<const Node>;
+
+    // Read-only view of a piece sequence. Returned by snapshot() for background
+    // readers, and by insert()/remove() so the undo log can keep the pieces of
+    // an edit instead of a copy of its text.
+    class Snapshot
+    {
+    public:
+        Snapshot() = default;
+
+        bool isEmpty() const;
+        qsizetype size() const;
+        qsizetype utf8Size() const;
+        qsizetype pieceCount() const;
+        QString toString() const;
+        QString mid(qsizetype position, qsizetype length) const;
+
+    private:
+        friend class PieceTable;
+        explicit Snapshot(NodePtr root);
+
+        NodePtr m_root;
+    };
+
+    PieceTable();
+    explicit PieceTable(const QString &text);
+
+    qsizetype size() const;
+    qsizetype pieceCount() const;
+    QString toString() const;
+    QString mid(qsizetype position, qsizetype length) const;
+    Snapshot snapshot() const;
+
+    // Nodes also sum the UTF-8 size of their subtree, so a UTF-16 position
+    // maps to a byte offset of the UTF-8 text in O(log n)
+    qsizetype utf8Size() const;
+    qsizetype utf8Offset(qsizetype position) const;
+
+    // Edits return the pieces they inserted or removed
+    Snapshot insert(qsizetype position, const QString &text);
+    Snapshot remove(qsizetype position, qsizetype length);
+    void insert(qsizetype position, const Snapshot &pieces);
+
+    // Joins two piece sequences, used to coalesce consecutive edits
+    Snapshot concat(const Snapshot &first, const Snapshot &second);
+
+    void reset(const QString &text);
+
+    // Rewrites the current text into a single buffer. Outstanding snapshots
+    // keep the buffers they reference alive until they are dropped.
+    void compact();
+
+    // Bytes held by live buffers plus the nodes of the current text
+    qsizetype memoryUsage() const;
+    static qsizetype nodeMemory(qsizetype pieces);
+
+private:
+    static constexpr qsizetype ChunkCapacity = 64 * 1024;
+
+    NodePtr makeLeaf(const std::shared_ptr<const Buffer> &buffer, qsizetype start, qsizetype length, qsizetype utf8);
+    NodePtr merge(const NodePtr &left, const NodePtr &right);
+    std::pair<NodePtr, NodePtr> split(const NodePtr &node, qsizetype position);
+    std::shared_ptr<Buffer> newBuffer(qsizetype capacity);
+    quint32 nextPriority();
+
+    NodePtr m_root;
+    std::shared_ptr<Buffer> m_addChunk;
+    std::vector<std::weak_ptr<const Buffer>> m_buffers;
+    quint32 m_seed;
+};
+
+#endif // PIECE_TABLE_H
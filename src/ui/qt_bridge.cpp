@@ -1,9 +1,20 @@
 // src/ui/qt_bridge.cpp
 #include "qt_bridge.h"
+#include "command_queue.h"
+#include "event_ring.h"
+#include "image_loader.h"
 #include "mainwindow.h"
+#include "page_editor.h"
+#include "text_store.h"
 #include <QApplication>
 #include <QString>
 #include <QStringList>
+#include <QThread>
+#include <QTimer>
+#include <atomic>
+#include <iterator>
+#include <utility>
+#include <vector>
 
 // Internal structure that holds Qt objects and callbacks
 struct MainWindowHandle
@@ -11,6 +22,22 @@ struct MainWindowHandle
     QApplication *app;
     MainWindow *window;
 
+    // Open qt_batch_begin() calls and the updates they hold back
+    int batch_depth;
+    QList<UiCommand> batch;
+
+    // Updates made off the GUI thread, and whether a drain is already posted
+    UiCommandQueue queue;
+    std::atomic<bool> drain_pending;
+
+    // UI events waiting for Rust once qt_enable_event_ring() is called,
+    // whether a drain is posted, and whether Rust is draining right now
+    UiEventRing *events;
+    EventsAvailableCallback events_cb;
+    void *events_user_data;
+    bool events_pending;
+    bool draining_events;
+
     // Callback storage
     PasswordSubmittedCallback password_cb;
     void *password_user_data;
@@ -41,8 +68,83 @@ struct MainWindowHandle
 
     AddNewPageCallback add_new_page_cb;
     void *add_new_page_user_data;
+
+    SplitPageCallback split_page_cb;
+    void *split_page_user_data;
+
+    SaveDeltaCallback save_delta_cb;
+    void *save_delta_user_data;
+
+    PrefetchPageCallback prefetch_page_cb;
+    void *prefetch_page_user_data;
+
+    AddCheckboxCallback add_checkbox_cb;
+    void *add_checkbox_user_data;
+
+    CheckboxToggledCallback checkbox_toggled_cb;
+    void *checkbox_toggled_user_data;
+
+    CheckboxOrderCallback checkbox_order_cb;
+    void *checkbox_order_user_data;
+
+    ImageInsertedCallback image_inserted_cb;
+    void *image_inserted_user_data;
+
+    ImagePositionsCallback image_positions_cb;
+    void *image_positions_user_data;
+
+    ThumbnailRequestedCallback thumbnail_requested_cb;
+    void *thumbnail_requested_user_data;
+
+    OriginalRequestedCallback original_requested_cb;
+    void *original_requested_user_data;
+
+    ThumbnailsReadyCallback thumbnails_ready_cb;
+    void *thumbnails_ready_user_data;
 };
 
+// ==============================================
+// Event Ring
+// ==============================================
+
+// Hands every event written so far to Rust. A drain is not re-entered:
+// events raised while Rust handles a batch wait for the next one.
+static void flushEvents(MainWindowHandle *handle)
+{
+    handle->events_pending = false;
+    if (!handle->events || handle->draining_events || handle->events->isEmpty())
+        return;
+
+    handle->draining_events = true;
+    handle->events_cb(handle->events_user_data);
+    handle->draining_events = false;
+}
+
+// Writes an event for Rust to drain once the GUI thread is idle. False when
+// the ring is off or still full after a drain; the caller then makes the
+// direct callback instead.
+static bool postEvent(MainWindowHandle *handle, UiEventType type, int value = 0, qint64 id = 0,
+                      const QByteArray &text = QByteArray())
+{
+    if (!handle->events)
+        return false;
+
+    if (!handle->events->push(type, value, id, text.constData(), text.size()))
+    {
+        flushEvents(handle);
+        if (!handle->events->push(type, value, id, text.constData(), text.size()))
+            return false;
+    }
+
+    if (!handle->events_pending)
+    {
+        handle->events_pending = true;
+        QMetaObject::invokeMethod(handle->window, [handle]()
+                                  { flushEvents(handle); }, Qt::QueuedConnection);
+    }
+    return true;
+}
+
 // ==============================================
 // Initialization and Lifecycle
 // ==============================================
@@ -54,6 +156,15 @@ MainWindowHandle *qt_init(int argc, char **argv)
     handle->app = new QApplication(argc, argv);
     handle->window = new MainWindow();
 
+    handle->batch_depth = 0;
+    handle->drain_pending.store(false);
+
+    handle->events = nullptr;
+    handle->events_cb = nullptr;
+    handle->events_user_data = nullptr;
+    handle->events_pending = false;
+    handle->draining_events = false;
+
     // Initialize all callbacks to nullptr
     handle->password_cb = nullptr;
     handle->password_user_data = nullptr;
@@ -75,6 +186,28 @@ MainWindowHandle *qt_init(int argc, char **argv)
     handle->page_changed_user_data = nullptr;
     handle->add_new_page_cb = nullptr;
     handle->add_new_page_user_data = nullptr;
+    handle->split_page_cb = nullptr;
+    handle->split_page_user_data = nullptr;
+    handle->save_delta_cb = nullptr;
+    handle->save_delta_user_data = nullptr;
+    handle->prefetch_page_cb = nullptr;
+    handle->prefetch_page_user_data = nullptr;
+    handle->add_checkbox_cb = nullptr;
+    handle->add_checkbox_user_data = nullptr;
+    handle->checkbox_toggled_cb = nullptr;
+    handle->checkbox_toggled_user_data = nullptr;
+    handle->checkbox_order_cb = nullptr;
+    handle->checkbox_order_user_data = nullptr;
+    handle->image_inserted_cb = nullptr;
+    handle->image_inserted_user_data = nullptr;
+    handle->image_positions_cb = nullptr;
+    handle->image_positions_user_data = nullptr;
+    handle->thumbnail_requested_cb = nullptr;
+    handle->thumbnail_requested_user_data = nullptr;
+    handle->original_requested_cb = nullptr;
+    handle->original_requested_user_data = nullptr;
+    handle->thumbnails_ready_cb = nullptr;
+    handle->thumbnails_ready_user_data = nullptr;
 
     handle->window->show();
 
@@ -85,7 +218,11 @@ int qt_exec(MainWindowHandle *handle)
 {
     if (!handle || !handle->app)
         return -1;
-    return handle->app->exec();
+    const int code = handle->app->exec();
+
+    // Events from closing the window never got their idle drain
+    flushEvents(handle);
+    return code;
 }
 
 void qt_cleanup(MainWindowHandle *handle)
@@ -96,6 +233,7 @@ void qt_cleanup(MainWindowHandle *handle)
             delete handle->window;
         if (handle->app)
             delete handle->app;
+        delete handle->events;
         delete handle;
     }
 }
@@ -104,6 +242,147 @@ void qt_cleanup(MainWindowHandle *handle)
 // UI Update Functions
 // ==============================================
 
+static void applyCommand(MainWindow *window, const UiCommand &command)
+{
+    switch (command.type)
+    {
+    case UiCommand::EntryTitle:
+        window->setCurrentEntryTitle(command.text);
+        break;
+    case UiCommand::TotalPages:
+        window->setTotalPages(command.value);
+        break;
+    case UiCommand::CurrentPage:
+        window->setCurrentPage(command.value);
+        break;
+    case UiCommand::Content:
+        window->setCurrentContent(command.text);
+        break;
+    case UiCommand::WordCount:
+        window->setWordCount(command.value);
+        break;
+    case UiCommand::Call:
+        break;
+    }
+}
+
+// Text handed over with its length; NULL or empty gives an empty string
+static QString fromUtf8(const char *text, long long length)
+{
+    if (!text || length <= 0)
+        return QString();
+    return QString::fromUtf8(text, qsizetype(length));
+}
+
+// UTF-16 is QString's own encoding, so this is a single copy
+static QString fromUtf16(const unsigned short *text, long long length)
+{
+    if (!text || length <= 0)
+        return QString();
+    return QString(reinterpret_cast<const QChar *>(text), qsizetype(length));
+}
+
+// Applies a typed update, or holds it back while a batch is open
+static void submitCommand(MainWindowHandle *handle, const UiCommand &command)
+{
+    if (handle->batch_depth == 0)
+    {
+        applyCommand(handle->window, command);
+        return;
+    }
+
+    // A later update of the same kind replaces the earlier one
+    for (UiCommand &queued : handle->batch)
+    {
+        if (queued.type == command.type)
+        {
+            queued = command;
+            return;
+        }
+    }
+    handle->batch.append(command);
+}
+
+// Updates without a command of their own may depend on queued ones (images
+// are placed into the content), so those go first
+static void flushCommands(MainWindowHandle *handle)
+{
+    const QList<UiCommand> batch = std::exchange(handle->batch, QList<UiCommand>());
+    for (const UiCommand &command : batch)
+        applyCommand(handle->window, command);
+}
+
+// On the GUI thread
+static void runCommand(MainWindowHandle *handle, const UiCommand &command)
+{
+    if (command.type != UiCommand::Call)
+    {
+        submitCommand(handle, command);
+        return;
+    }
+
+    flushCommands(handle);
+    command.call(handle);
+}
+
+// Everything queued so far; the flag is cleared first, so a push that this
+// drain misses posts the next one
+static void drainQueue(MainWindowHandle *handle)
+{
+    handle->drain_pending.store(false);
+
+    UiCommand command;
+    while (handle->queue.pop(&command))
+        runCommand(handle, command);
+}
+
+// Widgets are only touched on the GUI thread. Other threads queue the update,
+// converted already, and wake the GUI thread once per drain.
+static void dispatch(MainWindowHandle *handle, UiCommand command)
+{
+    if (QThread::currentThread() == handle->app->thread())
+    {
+        // Whatever other threads sent before this goes first
+        UiCommand queued;
+        while (handle->queue.pop(&queued))
+            runCommand(handle, queued);
+
+        runCommand(handle, command);
+        return;
+    }
+
+    handle->queue.push(std::move(command));
+    if (!handle->drain_pending.exchange(true))
+    {
+        QMetaObject::invokeMethod(handle->window, [handle]()
+                                  { drainQueue(handle); }, Qt::QueuedConnection);
+    }
+}
+
+void qt_batch_begin(MainWindowHandle *handle)
+{
+    if (!handle || !handle->window)
+        return;
+
+    dispatch(handle, UiCommand::function([](MainWindowHandle *handle)
+                                         {
+        if (handle->batch_depth++ == 0)
+            handle->window->setUpdatesEnabled(false); }));
+}
+
+void qt_batch_commit(MainWindowHandle *handle)
+{
+    if (!handle || !handle->window)
+        return;
+
+    // Queued commands were applied before this runs
+    dispatch(handle, UiCommand::function([](MainWindowHandle *handle)
+                                         {
+        if (handle->batch_depth == 0 || --handle->batch_depth > 0)
+            return;
+        handle->window->setUpdatesEnabled(true); }));
+}
+
 void qt_set_entry_list(MainWindowHandle *handle, const char **entries, int count)
 {
     if (!handle || !handle->window)
@@ -114,72 +393,233 @@ void qt_set_entry_list(MainWindowHandle *handle, const char **entries, int count
     {
         list.append(QString::fromUtf8(entries[i]));
     }
-    handle->window->setEntryList(list);
+    dispatch(handle, UiCommand::function([list](MainWindowHandle *handle)
+                                         { handle->window->setEntryList(list); }));
 }
 
 void qt_set_current_entry_title(MainWindowHandle *handle, const char *title)
 {
     if (!handle || !handle->window)
         return;
-    handle->window->setCurrentEntryTitle(QString::fromUtf8(title));
+    dispatch(handle, UiCommand::typed(UiCommand::EntryTitle, QString::fromUtf8(title), 0));
 }
 
 void qt_set_current_content(MainWindowHandle *handle, const char *content)
 {
     if (!handle || !handle->window)
         return;
-    handle->window->setCurrentContent(QString::fromUtf8(content));
+    dispatch(handle, UiCommand::typed(UiCommand::Content, QString::fromUtf8(content), 0));
+}
+
+void qt_set_entry_list_utf8(MainWindowHandle *handle, const char *const *entries, const long long *lengths, int count)
+{
+    if (!handle || !handle->window)
+        return;
+
+    QStringList list;
+    list.reserve(count);
+    for (int i = 0; i < count; i++)
+    {
+        list.append(fromUtf8(entries[i], lengths[i]));
+    }
+    dispatch(handle, UiCommand::function([list](MainWindowHandle *handle)
+                                         { handle->window->setEntryList(list); }));
+}
+
+void qt_set_current_entry_title_utf8(MainWindowHandle *handle, const char *title, long long length)
+{
+    if (!handle || !handle->window)
+        return;
+    dispatch(handle, UiCommand::typed(UiCommand::EntryTitle, fromUtf8(title, length), 0));
+}
+
+void qt_set_current_content_utf8(MainWindowHandle *handle, const char *content, long long length)
+{
+    if (!handle || !handle->window)
+        return;
+    dispatch(handle, UiCommand::typed(UiCommand::Content, fromUtf8(content, length), 0));
+}
+
+void qt_set_current_content_utf16(MainWindowHandle *handle, const unsigned short *content, long long length)
+{
+    if (!handle || !handle->window)
+        return;
+    dispatch(handle, UiCommand::typed(UiCommand::Content, fromUtf16(content, length), 0));
 }
 
 void qt_set_current_page(MainWindowHandle *handle, int page)
 {
     if (!handle || !handle->window)
         return;
-    handle->window->setCurrentPage(page);
+    dispatch(handle, UiCommand::typed(UiCommand::CurrentPage, QString(), page));
 }
 
 void qt_set_total_pages(MainWindowHandle *handle, int total)
 {
     if (!handle || !handle->window)
         return;
-    handle->window->setTotalPages(total);
+    dispatch(handle, UiCommand::typed(UiCommand::TotalPages, QString(), total));
 }
 
 void qt_set_word_count(MainWindowHandle *handle, int count)
 {
     if (!handle || !handle->window)
         return;
-    handle->window->setWordCount(count);
+    dispatch(handle, UiCommand::typed(UiCommand::WordCount, QString(), count));
 }
 
 void qt_set_password_error(MainWindowHandle *handle, const char *error)
 {
     if (!handle || !handle->window)
         return;
-    handle->window->setPasswordError(QString::fromUtf8(error));
+    const QString message = QString::fromUtf8(error);
+    dispatch(handle, UiCommand::function([message](MainWindowHandle *handle)
+                                         { handle->window->setPasswordError(message); }));
 }
 
 void qt_show_password_error(MainWindowHandle *handle, int show)
 {
     if (!handle || !handle->window)
         return;
-    handle->window->setShowPasswordError(show != 0);
+    dispatch(handle, UiCommand::function([show](MainWindowHandle *handle)
+                                         { handle->window->setShowPasswordError(show != 0); }));
+}
+
+void qt_unlock_finished(MainWindowHandle *handle, int unlocked, const char *error)
+{
+    if (!handle || !handle->window)
+        return;
+    const QString message = error ? QString::fromUtf8(error) : QString();
+    dispatch(handle, UiCommand::function([unlocked, message](MainWindowHandle *handle)
+                                         { handle->window->finishUnlock(unlocked != 0, message); }));
+}
+
+void qt_post_to_gui(MainWindowHandle *handle, GuiTaskCallback cb, void *user_data)
+{
+    if (!handle || !handle->window || !cb)
+        return;
+    // A queued task can be drained from inside a Rust call into the bridge,
+    // so it only runs once control is back in the event loop
+    dispatch(handle, UiCommand::function([cb, user_data](MainWindowHandle *handle)
+                                         { QTimer::singleShot(0, handle->window, [cb, user_data]()
+                                                              { cb(user_data); }); }));
+}
+
+void qt_set_autosave_interval(MainWindowHandle *handle, int msec)
+{
+    if (!handle || !handle->window)
+        return;
+    dispatch(handle, UiCommand::function([msec](MainWindowHandle *handle)
+                                         { handle->window->setAutosaveInterval(msec); }));
+}
+
+void qt_provide_page_content(MainWindowHandle *handle, int page, const char *content)
+{
+    if (!handle || !handle->window || !content)
+        return;
+    flushCommands(handle);
+    handle->window->providePageContent(page, QString::fromUtf8(content));
+}
+
+void qt_provide_page_content_utf8(MainWindowHandle *handle, int page, const char *content, long long length)
+{
+    if (!handle || !handle->window || !content)
+        return;
+    flushCommands(handle);
+    handle->window->providePageContent(page, fromUtf8(content, length));
+}
+
+void qt_provide_page_content_utf16(MainWindowHandle *handle, int page, const unsigned short *content, long long length)
+{
+    if (!handle || !handle->window || !content)
+        return;
+    flushCommands(handle);
+    handle->window->providePageContent(page, fromUtf16(content, length));
+}
+
+void qt_set_note_checkboxes(MainWindowHandle *handle, const long long *ids, const int *checked, int count)
+{
+    if (!handle || !handle->window || (count > 0 && (!ids || !checked)))
+        return;
+
+    QList<qint64> idList;
+    QList<bool> checkedList;
+    for (int i = 0; i < count; ++i)
+    {
+        idList.append(ids[i]);
+        checkedList.append(checked[i] != 0);
+    }
+    dispatch(handle, UiCommand::function([idList, checkedList](MainWindowHandle *handle)
+                                         { handle->window->setNoteCheckboxes(idList, checkedList); }));
+}
+
+void qt_set_images(MainWindowHandle *handle, const long long *ids, const char *const *paths,
+                   const char *const *hashes, const int *positions, const int *widths, const int *heights,
+                   int count)
+{
+    if (!handle || !handle->window || (count > 0 && (!ids || !paths || !hashes || !positions || !widths || !heights)))
+        return;
+
+    QList<StoredImage> images;
+    for (int i = 0; i < count; ++i)
+    {
+        StoredImage image;
+        image.id = ids[i];
+        image.path = paths[i] ? QString::fromUtf8(paths[i]) : QString();
+        image.hash = hashes[i] ? QString::fromUtf8(hashes[i]) : QString();
+        image.position = positions[i];
+        image.size = QSize(widths[i], heights[i]);
+        images.append(image);
+    }
+    dispatch(handle, UiCommand::function([images](MainWindowHandle *handle)
+                                         { handle->window->setImages(images); }));
+}
+
+void qt_provide_thumbnail(MainWindowHandle *handle, const char *hash, int size, const unsigned char *data,
+                          long long length)
+{
+    if (!handle || !handle->window || !hash || (length > 0 && !data))
+        return;
+    flushCommands(handle);
+
+    const QByteArray bytes = length > 0 ? QByteArray(reinterpret_cast<const char *>(data), qsizetype(length))
+                                        : QByteArray();
+    handle->window->provideThumbnail(QString::fromUtf8(hash), size, bytes);
+}
+
+void qt_provide_original(MainWindowHandle *handle, long long image_id, const unsigned char *data, long long length)
+{
+    if (!handle || !handle->window || (length > 0 && !data))
+        return;
+
+    const QByteArray bytes = length > 0 ? QByteArray(reinterpret_cast<const char *>(data), qsizetype(length))
+                                        : QByteArray();
+    dispatch(handle, UiCommand::function([image_id, bytes](MainWindowHandle *handle)
+                                         { handle->window->provideOriginal(image_id, bytes); }));
 }
 
 void qt_show_book_editor(MainWindowHandle *handle)
 {
-    // This would require adding a method to MainWindow
-    // For now, the view switching is handled internally
+    if (!handle || !handle->window)
+        return;
+    dispatch(handle, UiCommand::function([](MainWindowHandle *handle)
+                                         { handle->window->showBookEditor(); }));
 }
 
 void qt_show_note_editor(MainWindowHandle *handle)
 {
-    // Same as above
+    if (!handle || !handle->window)
+        return;
+    dispatch(handle, UiCommand::function([](MainWindowHandle *handle)
+                                         { handle->window->showNoteEditor(); }));
 }
 
 void qt_show_list_view(MainWindowHandle *handle)
 {
-    // Same as above
+    if (!handle || !handle->window)
+        return;
+    dispatch(handle, UiCommand::function([](MainWindowHandle *handle)
+                                         { handle->window->showListView(); }));
 }
 
 // ==============================================
@@ -199,6 +639,7 @@ void qt_register_password_submitted(MainWindowHandle *handle, PasswordSubmittedC
                      {
                          if (handle->password_cb)
                          {
+                             flushEvents(handle);
                              QByteArray utf8 = password.toUtf8();
                              handle->password_cb(utf8.constData(), handle->password_user_data);
                          }
@@ -216,8 +657,11 @@ void qt_register_new_entry_clicked(MainWindowHandle *handle, NewEntryClickedCall
     QObject::connect(handle->window, &MainWindow::newEntryClicked,
                      [handle]()
                      {
+                         if (postEvent(handle, UI_EVENT_NEW_ENTRY_CLICKED))
+                             return;
                          if (handle->new_entry_cb)
                          {
+                             flushEvents(handle);
                              handle->new_entry_cb(handle->new_entry_user_data);
                          }
                      });
@@ -236,13 +680,14 @@ void qt_register_mode_selected(MainWindowHandle *handle, ModeSelectedCallback cb
                      {
                          if (handle->mode_selected_cb)
                          {
-                             // Parse "MODE|TITLE" format
-                             QStringList parts = data.split('|');
-                             if (parts.size() >= 2)
+                             flushEvents(handle);
+                             // "MODE|TITLE"; the title may hold '|' itself
+                             const qsizetype bar = data.indexOf(QLatin1Char('|'));
+                             if (bar >= 0)
                              {
-                                 QByteArray mode = parts[0].toUtf8();
-                                 QByteArray title = parts[1].toUtf8();
-                                 handle->mode_selected_cb(mode.constData(), title.constData(),
+                                 const QByteArray mode = data.left(bar).toUtf8();
+                                 const QByteArray title = data.mid(bar + 1).toUtf8();
+                                 handle->mode_selected_cb(mode.constData(), mode.size(), title.constData(), title.size(),
                                                           handle->mode_selected_user_data);
                              }
                          }
@@ -260,8 +705,11 @@ void qt_register_entry_selected(MainWindowHandle *handle, EntrySelectedCallback
     QObject::connect(handle->window, &MainWindow::entrySelected,
                      [handle](int index)
                      {
+                         if (postEvent(handle, UI_EVENT_ENTRY_SELECTED, index))
+                             return;
                          if (handle->entry_selected_cb)
                          {
+                             flushEvents(handle);
                              handle->entry_selected_cb(index, handle->entry_selected_user_data);
                          }
                      });
@@ -278,8 +726,11 @@ void qt_register_delete_entry(MainWindowHandle *handle, DeleteEntryCallback cb,
     QObject::connect(handle->window, &MainWindow::deleteEntryClicked,
                      [handle](int index)
                      {
+                         if (postEvent(handle, UI_EVENT_DELETE_ENTRY, index))
+                             return;
                          if (handle->delete_entry_cb)
                          {
+                             flushEvents(handle);
                              handle->delete_entry_cb(index, handle->delete_entry_user_data);
                          }
                      });
@@ -294,12 +745,13 @@ void qt_register_save_content(MainWindowHandle *handle, SaveContentCallback cb,
     handle->save_content_user_data = user_data;
 
     QObject::connect(handle->window, &MainWindow::saveContent,
-                     [handle](const QString &content)
+                     [handle](const QString &content, int page)
                      {
                          if (handle->save_content_cb)
                          {
-                             QByteArray utf8 = content.toUtf8();
-                             handle->save_content_cb(utf8.constData(), handle->save_content_user_data);
+                             flushEvents(handle);
+                             const QByteArray utf8 = content.toUtf8();
+                             handle->save_content_cb(utf8.constData(), utf8.size(), page, handle->save_content_user_data);
                          }
                      });
 }
@@ -315,8 +767,11 @@ void qt_register_back_to_list(MainWindowHandle *handle, BackToListCallback cb, v
     QObject::connect(handle->window, &MainWindow::backToList,
                      [handle]()
                      {
+                         if (postEvent(handle, UI_EVENT_BACK_TO_LIST))
+                             return;
                          if (handle->back_to_list_cb)
                          {
+                             flushEvents(handle);
                              handle->back_to_list_cb(handle->back_to_list_user_data);
                          }
                      });
@@ -333,8 +788,11 @@ void qt_register_search_entries(MainWindowHandle *handle, SearchEntriesCallback
     QObject::connect(handle->window, &MainWindow::searchEntries,
                      [handle](const QString &query)
                      {
+                         if (postEvent(handle, UI_EVENT_SEARCH_ENTRIES, 0, 0, query.toUtf8()))
+                             return;
                          if (handle->search_entries_cb)
                          {
+                             flushEvents(handle);
                              QByteArray utf8 = query.toUtf8();
                              handle->search_entries_cb(utf8.constData(), handle->search_entries_user_data);
                          }
@@ -352,8 +810,11 @@ void qt_register_page_changed(MainWindowHandle *handle, PageChangedCallback cb,
     QObject::connect(handle->window, &MainWindow::pageChanged,
                      [handle](int page)
                      {
+                         if (postEvent(handle, UI_EVENT_PAGE_CHANGED, page))
+                             return;
                          if (handle->page_changed_cb)
                          {
+                             flushEvents(handle);
                              handle->page_changed_cb(page, handle->page_changed_user_data);
                          }
                      });
@@ -370,9 +831,302 @@ void qt_register_add_new_page(MainWindowHandle *handle, AddNewPageCallback cb, v
     QObject::connect(handle->window, &MainWindow::addNewPage,
                      [handle]()
                      {
+                         if (postEvent(handle, UI_EVENT_ADD_NEW_PAGE))
+                             return;
                          if (handle->add_new_page_cb)
                          {
+                             flushEvents(handle);
                              handle->add_new_page_cb(handle->add_new_page_user_data);
                          }
                      });
+}
+
+void qt_register_split_page(MainWindowHandle *handle, SplitPageCallback cb, void *user_data)
+{
+    if (!handle || !handle->window)
+        return;
+
+    handle->split_page_cb = cb;
+    handle->split_page_user_data = user_data;
+
+    QObject::connect(handle->window, &MainWindow::splitPage,
+                     [handle](int page, const QString &keep, const QString &overflow)
+                     {
+                         if (handle->split_page_cb)
+                         {
+                             flushEvents(handle);
+                             const QByteArray keepUtf8 = keep.toUtf8();
+                             const QByteArray overflowUtf8 = overflow.toUtf8();
+                             // Rust answers 0 when nothing was stored; the page then keeps its text
+                             if (handle->split_page_cb(page, keepUtf8.constData(), keepUtf8.size(), overflowUtf8.constData(),
+                                                       overflowUtf8.size(), handle->split_page_user_data) != 0)
+                             {
+                                 handle->window->pageSplit(page, int(keep.size()));
+                             }
+                         }
+                     });
+}
+
+static bool send_save_delta(MainWindowHandle *handle, const TextDelta &delta, int page)
+{
+    std::vector<SaveDeltaOp> ops;
+    ops.reserve(delta.ops.size());
+    for (const TextDelta::Op &op : delta.ops)
+    {
+        ops.push_back({op.offset, op.removed, op.inserted.constData(), op.inserted.size()});
+    }
+    return handle->save_delta_cb(delta.baseRevision, delta.revision, ops.data(), int(ops.size()), page,
+                                 handle->save_delta_user_data) != 0;
+}
+
+void qt_register_save_delta(MainWindowHandle *handle, SaveDeltaCallback cb, void *user_data)
+{
+    if (!handle || !handle->window)
+        return;
+
+    handle->save_delta_cb = cb;
+    handle->save_delta_user_data = user_data;
+
+    QObject::connect(handle->window, &MainWindow::saveDelta,
+                     [handle](TextStore *store, int page)
+                     {
+                         if (handle->save_delta_cb)
+                         {
+                             flushEvents(handle);
+                             // Rust answers 0 when it no longer holds the base text
+                             TextDelta delta = store->delta();
+                             bool saved = send_save_delta(handle, delta, page);
+                             if (!saved && delta.baseRevision >= 0)
+                             {
+                                 delta = store->fullDelta();
+                                 saved = send_save_delta(handle, delta, page);
+                             }
+                             if (saved)
+                             {
+                                 store->markSaved(delta.revision);
+                             }
+                         }
+                     });
+}
+
+void qt_register_prefetch_page(MainWindowHandle *handle, PrefetchPageCallback cb, void *user_data)
+{
+    if (!handle || !handle->window)
+        return;
+
+    handle->prefetch_page_cb = cb;
+    handle->prefetch_page_user_data = user_data;
+
+    QObject::connect(handle->window, &MainWindow::prefetchPage,
+                     [handle](int page)
+                     {
+                         if (postEvent(handle, UI_EVENT_PREFETCH_PAGE, page))
+                             return;
+                         if (handle->prefetch_page_cb)
+                         {
+                             flushEvents(handle);
+                             handle->prefetch_page_cb(page, handle->prefetch_page_user_data);
+                         }
+                     });
+}
+
+void qt_register_add_checkbox(MainWindowHandle *handle, AddCheckboxCallback cb, void *user_data)
+{
+    if (!handle || !handle->window)
+        return;
+
+    handle->add_checkbox_cb = cb;
+    handle->add_checkbox_user_data = user_data;
+
+    QObject::connect(handle->window, &MainWindow::addCheckbox,
+                     [handle](int index)
+                     {
+                         if (handle->add_checkbox_cb)
+                         {
+                             flushEvents(handle);
+                             const long long id = handle->add_checkbox_cb(index, handle->add_checkbox_user_data);
+                             if (id >= 0)
+                             {
+                                 handle->window->setCheckboxId(index, id);
+                             }
+                         }
+                     });
+}
+
+void qt_register_checkbox_toggled(MainWindowHandle *handle, CheckboxToggledCallback cb, void *user_data)
+{
+    if (!handle || !handle->window)
+        return;
+
+    handle->checkbox_toggled_cb = cb;
+    handle->checkbox_toggled_user_data = user_data;
+
+    QObject::connect(handle->window, &MainWindow::checkboxToggled,
+                     [handle](qint64 id, bool checked)
+                     {
+                         if (postEvent(handle, UI_EVENT_CHECKBOX_TOGGLED, checked ? 1 : 0, id))
+                             return;
+                         if (handle->checkbox_toggled_cb)
+                         {
+                             flushEvents(handle);
+                             handle->checkbox_toggled_cb(id, checked ? 1 : 0, handle->checkbox_toggled_user_data);
+                         }
+                     });
+}
+
+void qt_register_checkbox_order(MainWindowHandle *handle, CheckboxOrderCallback cb, void *user_data)
+{
+    if (!handle || !handle->window)
+        return;
+
+    handle->checkbox_order_cb = cb;
+    handle->checkbox_order_user_data = user_data;
+
+    QObject::connect(handle->window, &MainWindow::checkboxOrderChanged,
+                     [handle](const QList<qint64> &ids, const QList<int> &positions)
+                     {
+                         if (handle->checkbox_order_cb)
+                         {
+                             flushEvents(handle);
+                             std::vector<long long> rows(ids.begin(), ids.end());
+                             std::vector<int> offsets(positions.begin(), positions.end());
+                             handle->checkbox_order_cb(rows.data(), offsets.data(), int(rows.size()),
+                                                       handle->checkbox_order_user_data);
+                         }
+                     });
+}
+
+void qt_register_image_inserted(MainWindowHandle *handle, ImageInsertedCallback cb, void *user_data)
+{
+    if (!handle || !handle->window)
+        return;
+
+    handle->image_inserted_cb = cb;
+    handle->image_inserted_user_data = user_data;
+
+    QObject::connect(handle->window, &MainWindow::imageInserted,
+                     [handle](const QString &path, const QString &hash, int position, const QSize &size)
+                     {
+                         if (handle->image_inserted_cb)
+                         {
+                             flushEvents(handle);
+                             const QByteArray pathBytes = path.toUtf8();
+                             const QByteArray hashBytes = hash.toUtf8();
+                             const long long id = handle->image_inserted_cb(pathBytes.constData(), hashBytes.constData(), position,
+                                                                            size.width(), size.height(),
+                                                                            handle->image_inserted_user_data);
+                             if (id >= 0)
+                             {
+                                 handle->window->setImageId(position, id);
+                             }
+                         }
+                     });
+}
+
+void qt_register_image_positions(MainWindowHandle *handle, ImagePositionsCallback cb, void *user_data)
+{
+    if (!handle || !handle->window)
+        return;
+
+    handle->image_positions_cb = cb;
+    handle->image_positions_user_data = user_data;
+
+    QObject::connect(handle->window, &MainWindow::imagePositionsChanged,
+                     [handle](const QList<qint64> &ids, const QList<int> &positions)
+                     {
+                         if (handle->image_positions_cb)
+                         {
+                             flushEvents(handle);
+                             std::vector<long long> rows(ids.begin(), ids.end());
+                             std::vector<int> offsets(positions.begin(), positions.end());
+                             handle->image_positions_cb(rows.data(), offsets.data(), int(rows.size()),
+                                                        handle->image_positions_user_data);
+                         }
+                     });
+}
+
+void qt_register_thumbnail_requested(MainWindowHandle *handle, ThumbnailRequestedCallback cb, void *user_data)
+{
+    if (!handle || !handle->window)
+        return;
+
+    handle->thumbnail_requested_cb = cb;
+    handle->thumbnail_requested_user_data = user_data;
+
+    QObject::connect(handle->window, &MainWindow::thumbnailRequested,
+                     [handle](const QString &hash, int size)
+                     {
+                         if (handle->thumbnail_requested_cb)
+                         {
+                             flushEvents(handle);
+                             const QByteArray hashBytes = hash.toUtf8();
+                             handle->thumbnail_requested_cb(hashBytes.constData(), size, handle->thumbnail_requested_user_data);
+                         }
+                     });
+}
+
+void qt_register_original_requested(MainWindowHandle *handle, OriginalRequestedCallback cb, void *user_data)
+{
+    if (!handle || !handle->window)
+        return;
+
+    handle->original_requested_cb = cb;
+    handle->original_requested_user_data = user_data;
+
+    QObject::connect(handle->window, &MainWindow::originalRequested,
+                     [handle](qint64 id)
+                     {
+                         if (handle->original_requested_cb)
+                         {
+                             flushEvents(handle);
+                             handle->original_requested_cb(id, handle->original_requested_user_data);
+                         }
+                     });
+}
+
+void qt_register_thumbnails_ready(MainWindowHandle *handle, ThumbnailsReadyCallback cb, void *user_data)
+{
+    if (!handle || !handle->window)
+        return;
+
+    handle->thumbnails_ready_cb = cb;
+    handle->thumbnails_ready_user_data = user_data;
+
+    QObject::connect(handle->window, &MainWindow::thumbnailsReady,
+                     [handle](qint64 id, const QString &hash, const QList<QByteArray> &encoded)
+                     {
+                         if (handle->thumbnails_ready_cb)
+                         {
+                             flushEvents(handle);
+                             const QByteArray hashBytes = hash.toUtf8();
+                             std::vector<int> sizes;
+                             std::vector<const unsigned char *> data;
+                             std::vector<long long> lengths;
+                             for (int i = 0; i < encoded.size() && i < int(std::size(ImageLoader::ThumbnailSizes)); ++i)
+                             {
+                                 sizes.push_back(ImageLoader::ThumbnailSizes[i]);
+                                 data.push_back(reinterpret_cast<const unsigned char *>(encoded[i].constData()));
+                                 lengths.push_back(encoded[i].size());
+                             }
+                             handle->thumbnails_ready_cb(id, hashBytes.constData(), sizes.data(), data.data(), lengths.data(),
+                                                         int(sizes.size()), handle->thumbnails_ready_user_data);
+                         }
+                     });
+}
+
+void qt_enable_event_ring(MainWindowHandle *handle, long long capacity, EventsAvailableCallback cb, void *user_data)
+{
+    if (!handle || !handle->window || !cb || handle->events)
+        return;
+
+    handle->events = new UiEventRing(capacity > 0 ? qsizetype(capacity) : 64 * 1024);
+    handle->events_cb = cb;
+    handle->events_user_data = user_data;
+}
+
+int qt_next_event(MainWindowHandle *handle, UiEvent *event)
+{
+    if (!handle || !handle->events || !event)
+        return 0;
+    return handle->events->pop(event) ? 1 : 0;
 }
\ No newline at end of file
@@ -29,6 +29,21 @@ extern "C"
     // ==============================================
     // UI Update Functions (Called from Rust)
     // ==============================================
+    // The qt_set_* and qt_batch_* functions may be called from any thread.
+    // Off the GUI thread their arguments are copied before they return and
+    // the update is applied on the GUI thread shortly after, in call order.
+    // The qt_provide_* answers are GUI-thread only, made inside the callback
+    // that asked.
+
+    /// Hold back repaints until the matching qt_batch_commit, so one
+    /// transition (title, page count, page, content, word count) is laid out
+    /// and painted once. Those setters are queued until then, a later call
+    /// replacing an earlier one; other calls apply the queue first. Batches
+    /// nest and only the outermost commit applies.
+    void qt_batch_begin(MainWindowHandle *handle);
+
+    /// Apply the queued updates and repaint
+    void qt_batch_commit(MainWindowHandle *handle);
 
     /// Set the entry list in the UI
     void qt_set_entry_list(MainWindowHandle *handle, const char **entries, int count);
@@ -48,13 +63,64 @@ extern "C"
     /// Set word count
     void qt_set_word_count(MainWindowHandle *handle, int count);
 
+    /// Length-delimited forms of the setters above, for text that is already
+    /// in memory: nothing is scanned for a terminator and embedded NULs are
+    /// kept. `length` counts UTF-8 bytes, or UTF-16 code units for the
+    /// _utf16 forms, which are copied into the editor's string as they are.
+    void qt_set_entry_list_utf8(MainWindowHandle *handle, const char *const *entries, const long long *lengths,
+                                int count);
+    void qt_set_current_entry_title_utf8(MainWindowHandle *handle, const char *title, long long length);
+    void qt_set_current_content_utf8(MainWindowHandle *handle, const char *content, long long length);
+    void qt_set_current_content_utf16(MainWindowHandle *handle, const unsigned short *content, long long length);
+
     /// Set password error message
     void qt_set_password_error(MainWindowHandle *handle, const char *error);
 
     /// Show/hide password error
     void qt_show_password_error(MainWindowHandle *handle, int show);
 
-    /// Switch to book editor view
+    /// End of an unlock started by the password callback. The dialog stays
+    /// busy until this is called; it closes when `unlocked` is nonzero and
+    /// shows `error` otherwise.
+    void qt_unlock_finished(MainWindowHandle *handle, int unlocked, const char *error);
+
+    /// Idle time (ms) after the last edit before the page is autosaved; 0 saves
+    /// only on Ctrl+S, page changes and close
+    void qt_set_autosave_interval(MainWindowHandle *handle, int msec);
+
+    /// Content for a page asked for by the prefetch callback. Does not change
+    /// the page shown; it is ready when the user turns to it.
+    void qt_provide_page_content(MainWindowHandle *handle, int page, const char *content);
+    void qt_provide_page_content_utf8(MainWindowHandle *handle, int page, const char *content, long long length);
+    void qt_provide_page_content_utf16(MainWindowHandle *handle, int page, const unsigned short *content,
+                                       long long length);
+
+    /// Rows stored for the open note's checklist items, in text order. Call
+    /// after qt_set_current_content; `checked` holds 0 or 1 per item.
+    void qt_set_note_checkboxes(MainWindowHandle *handle, const long long *ids, const int *checked, int count);
+
+    /// Images stored for the open page or note. Call after
+    /// qt_set_current_content; `positions` are UTF-16 offsets of each image's
+    /// U+FFFC in the text. Each is drawn from a thumbnail of its content
+    /// `hashes` entry, or read from `paths` in the background when that is
+    /// NULL. A file that is gone is asked for with the original callback.
+    void qt_set_images(MainWindowHandle *handle, const long long *ids, const char *const *paths,
+                       const char *const *hashes, const int *positions, const int *widths, const int *heights,
+                       int count);
+
+    /// Answer to the thumbnail callback, made before it returns. `length` 0
+    /// means there is no such thumbnail and the picture is read from its file.
+    void qt_provide_thumbnail(MainWindowHandle *handle, const char *hash, int size, const unsigned char *data,
+                              long long length);
+
+    /// Answer to the original callback, from any thread: the bytes of image
+    /// `image_id`'s file as it was inserted. `length` 0 leaves the image's
+    /// frame empty.
+    void qt_provide_original(MainWindowHandle *handle, long long image_id, const unsigned char *data,
+                             long long length);
+
+    /// Switch to book editor view. The shown editor is the one that takes
+    /// content and images, so this goes before them.
     void qt_show_book_editor(MainWindowHandle *handle);
 
     /// Switch to note editor view
@@ -67,19 +133,49 @@ extern "C"
     // Callback Registration (Rust provides callbacks)
     // ==============================================
 
-    /// Callback function types
+    /// One edit of a delta save, in UTF-8 bytes of the text as left by the
+    /// previous edits of the batch. `insert` is not NUL-terminated.
+    typedef struct SaveDeltaOp
+    {
+        long long offset;
+        long long delete_length;
+        const char *insert;
+        long long insert_length;
+    } SaveDeltaOp;
+
+    /// Callback function types. Text is UTF-8 with its length in bytes and
+    /// no terminating NUL, so NULs pasted into it survive.
     typedef void (*PasswordSubmittedCallback)(const char *password, void *user_data);
     typedef void (*NewEntryClickedCallback)(void *user_data);
-    typedef void (*ModeSelectedCallback)(const char *mode, const char *title, void *user_data);
+    typedef void (*ModeSelectedCallback)(const char *mode, long long mode_length, const char *title, long long title_length, void *user_data);
     typedef void (*EntrySelectedCallback)(int index, void *user_data);
     typedef void (*DeleteEntryCallback)(int index, void *user_data);
-    typedef void (*SaveContentCallback)(const char *content, void *user_data);
+    typedef void (*SaveContentCallback)(const char *content, long long length, int page, void *user_data);
     typedef void (*BackToListCallback)(void *user_data);
     typedef void (*SearchEntriesCallback)(const char *query, void *user_data);
     typedef void (*PageChangedCallback)(int page, void *user_data);
     typedef void (*AddNewPageCallback)(void *user_data);
+    typedef int (*SplitPageCallback)(int page, const char *keep, long long keep_length, const char *overflow, long long overflow_length, void *user_data);
+    typedef int (*SaveDeltaCallback)(long long base_revision, long long revision, const SaveDeltaOp *ops, int count, int page, void *user_data);
+    typedef void (*PrefetchPageCallback)(int page, void *user_data);
+    typedef long long (*AddCheckboxCallback)(int index, void *user_data);
+    typedef void (*CheckboxToggledCallback)(long long id, int checked, void *user_data);
+    typedef void (*CheckboxOrderCallback)(const long long *ids, const int *positions, int count, void *user_data);
+    typedef long long (*ImageInsertedCallback)(const char *path, const char *hash, int position, int width, int height, void *user_data);
+    typedef void (*ImagePositionsCallback)(const long long *ids, const int *positions, int count, void *user_data);
+    typedef void (*ThumbnailRequestedCallback)(const char *hash, int size, void *user_data);
+    typedef void (*OriginalRequestedCallback)(long long image_id, void *user_data);
+    typedef void (*ThumbnailsReadyCallback)(long long image_id, const char *hash, const int *sizes, const unsigned char *const *data, const long long *lengths, int count, void *user_data);
+    typedef void (*GuiTaskCallback)(void *user_data);
+
+    /// Run `cb` on the GUI thread from the event loop, after the updates
+    /// already sent; never from inside another bridge call. Tasks still
+    /// waiting when the window goes are dropped without running. This is how
+    /// worker threads hand results back.
+    void qt_post_to_gui(MainWindowHandle *handle, GuiTaskCallback cb, void *user_data);
 
-    /// Register callbacks that Qt will call when events occur
+    /// Register callbacks that Qt will call when events occur. The password
+    /// callback starts the unlock and answers with qt_unlock_finished.
     void qt_register_password_submitted(MainWindowHandle *handle, PasswordSubmittedCallback cb, void *user_data);
     void qt_register_new_entry_clicked(MainWindowHandle *handle, NewEntryClickedCallback cb, void *user_data);
     void qt_register_mode_selected(MainWindowHandle *handle, ModeSelectedCallback cb, void *user_data);
@@ -91,6 +187,111 @@ extern "C"
     void qt_register_page_changed(MainWindowHandle *handle, PageChangedCallback cb, void *user_data);
     void qt_register_add_new_page(MainWindowHandle *handle, AddNewPageCallback cb, void *user_data);
 
+    /// Auto-pagination: `page` keeps `keep`, `overflow` moves to the start of
+    /// page + 1 (created if missing). Sent as one operation so Rust can apply
+    /// it in a single transaction. The callback returns nonzero once it is
+    /// stored; until then the editor keeps the whole text.
+    void qt_register_split_page(MainWindowHandle *handle, SplitPageCallback cb, void *user_data);
+
+    /// Saves send the edits made since the last save instead of the whole
+    /// text. `ops` turn the text stored at `base_revision` into `revision`;
+    /// an empty batch means nothing changed. Return 1 once applied, or 0 if
+    /// the base is not the text Rust holds, and the whole text is resent as
+    /// one op with `base_revision` -1. Replaces qt_register_save_content
+    /// once registered.
+    ///
+    /// Both saves name the text they carry: `page` is its book page, which
+    /// may not be the one shown (a cached page left unsaved), or 0 for a
+    /// note. Revisions count from 0 on every page, so only a delta for the
+    /// page Rust has open can be applied; others are answered with 0.
+    void qt_register_save_delta(MainWindowHandle *handle, SaveDeltaCallback cb, void *user_data);
+
+    /// Book mode asks for pages next to the one shown while the user is idle.
+    /// Answer with qt_provide_page_content, or ignore pages that are missing.
+    void qt_register_prefetch_page(MainWindowHandle *handle, PrefetchPageCallback cb, void *user_data);
+
+    /// A checklist item was added to the note as item `index`. Return the id
+    /// of its new row, or -1 if it could not be created.
+    void qt_register_add_checkbox(MainWindowHandle *handle, AddCheckboxCallback cb, void *user_data);
+
+    /// An item was ticked or unticked. Only the item's row changes; the note
+    /// text is not re-saved.
+    void qt_register_checkbox_toggled(MainWindowHandle *handle, CheckboxToggledCallback cb, void *user_data);
+
+    /// Sent after each save of a note: the ids of the items left in the saved
+    /// text, in order, with the UTF-16 offset of each one's U+FFFC. Rows not
+    /// listed were deleted from the note. Not sent while the large-document
+    /// editor is up.
+    void qt_register_checkbox_order(MainWindowHandle *handle, CheckboxOrderCallback cb, void *user_data);
+
+    /// A picture finished decoding and was inserted at UTF-16 offset
+    /// `position`, shown at `width` x `height`. `hash` is the SHA-256 (hex)
+    /// of the file its thumbnails were stored under. Return the id of its
+    /// new row, or -1 if it could not be created.
+    void qt_register_image_inserted(MainWindowHandle *handle, ImageInsertedCallback cb, void *user_data);
+
+    /// Sent after each save of a page or note: the ids and offsets of the
+    /// images left in the saved text, in order. Rows not listed were deleted.
+    void qt_register_image_positions(MainWindowHandle *handle, ImagePositionsCallback cb, void *user_data);
+
+    /// A stored image is about to be drawn from its `size` thumbnail (longest
+    /// side in pixels). Answer with qt_provide_thumbnail before returning.
+    void qt_register_thumbnail_requested(MainWindowHandle *handle, ThumbnailRequestedCallback cb, void *user_data);
+
+    /// A stored image with no thumbnails has to be decoded, but its file is
+    /// gone. Answer with qt_provide_original, now or later.
+    void qt_register_original_requested(MainWindowHandle *handle, OriginalRequestedCallback cb, void *user_data);
+
+    /// A picture was decoded from its file; store its thumbnails, one encoded
+    /// image per `sizes` entry, under `hash`. `image_id` is the row to point
+    /// at them, or -1 for a picture whose insert callback follows.
+    void qt_register_thumbnails_ready(MainWindowHandle *handle, ThumbnailsReadyCallback cb, void *user_data);
+
+    // ==============================================
+    // Event Ring (Rust drains UI events in batches)
+    // ==============================================
+
+    /// Events that go through the ring once it is enabled, with what each
+    /// carries. The rest (password, new entry mode, saves and every callback
+    /// that answers) stay direct calls, and the ring is drained before each
+    /// of them so Rust sees all events in the order they happened.
+    typedef enum UiEventType
+    {
+        UI_EVENT_NEW_ENTRY_CLICKED = 1, // -
+        UI_EVENT_ENTRY_SELECTED = 2,    // value: index
+        UI_EVENT_DELETE_ENTRY = 3,      // value: index
+        UI_EVENT_BACK_TO_LIST = 4,      // -
+        UI_EVENT_SEARCH_ENTRIES = 5,    // text: query
+        UI_EVENT_PAGE_CHANGED = 6,      // value: page
+        UI_EVENT_ADD_NEW_PAGE = 7,      // -
+        UI_EVENT_PREFETCH_PAGE = 8,     // value: page
+        UI_EVENT_CHECKBOX_TOGGLED = 9   // id: checkbox row, value: checked
+    } UiEventType;
+
+    /// One event read from the ring. `text` is UTF-8, not NUL-terminated,
+    /// and valid until the next qt_next_event call.
+    typedef struct UiEvent
+    {
+        int type;
+        int value;
+        long long id;
+        const char *text;
+        long long text_length;
+    } UiEvent;
+
+    typedef void (*EventsAvailableCallback)(void *user_data);
+
+    /// Write the events above to a ring of `capacity` bytes (0 for the
+    /// default) instead of calling their callbacks. `cb` is called once the
+    /// GUI thread is idle after events were written, and before any direct
+    /// callback; drain the ring with qt_next_event there. An event that finds
+    /// the ring still full after a drain falls back to its callback.
+    void qt_enable_event_ring(MainWindowHandle *handle, long long capacity, EventsAvailableCallback cb,
+                              void *user_data);
+
+    /// Take the next event; returns 0 when the ring is empty. GUI thread only.
+    int qt_next_event(MainWindowHandle *handle, UiEvent *event);
+
 #ifdef __cplusplus
 }
 #endif
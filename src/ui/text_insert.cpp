@@ -0,0 +1,228 @@
+// text_insert.cpp
+#include "text_insert.h"
+#include "text_store.h"
+#include <QMimeData>
+#include <QProgressDialog>
+#include <QTextDocument>
+#include <QTimer>
+
+// ============ ChunkedTextInserter Implementation ============
+ChunkedTextInserter *ChunkedTextInserter::insert(QWidget *editor, const QTextCursor &cursor, const QString &text)
+{
+    ChunkedTextInserter *inserter = new ChunkedTextInserter(editor, cursor, text);
+    inserter->start();
+    return inserter;
+}
+
+ChunkedTextInserter::ChunkedTextInserter(QWidget *editor, const QTextCursor &cursor, const QString &text)
+    : QObject(editor), m_editor(editor), m_cursor(cursor), m_text(text), m_offset(0), m_skipLineFeed(false), m_firstChunk(true), m_done(false), m_groupOpen(false), m_progressDialog(nullptr)
+{
+}
+
+void ChunkedTextInserter::start()
+{
+    // Both QTextEdit and QPlainTextEdit expose readOnly as a property
+    m_editor->setProperty("readOnly", true);
+
+    m_store = TextStore::forDocument(m_cursor.document());
+    if (m_store)
+    {
+        m_store->beginGroup();
+        m_groupOpen = true;
+    }
+
+    m_progressDialog = new QProgressDialog(tr("Inserting text..."), tr("Cancel"), 0, 1000, m_editor);
+    m_progressDialog->setWindowModality(Qt::WindowModal);
+    m_progressDialog->setMinimumDuration(400);
+    m_progressDialog->setValue(0);
+    connect(m_progressDialog, &QProgressDialog::canceled, this, &ChunkedTextInserter::cancel);
+
+    QTimer::singleShot(0, this, &ChunkedTextInserter::insertNextChunk);
+}
+
+void ChunkedTextInserter::cancel()
+{
+    if (m_done)
+        return;
+
+    // Every chunk joined one undo group, so a single undo rolls them all back
+    closeGroup();
+    if (!m_firstChunk)
+    {
+        if (m_store)
+            m_store->undo();
+        else
+            m_cursor.document()->undo();
+    }
+    finish(false);
+}
+
+void ChunkedTextInserter::insertNextChunk()
+{
+    if (m_done)
+        return;
+
+    qsizetype length = qMin(ChunkSize, m_text.size() - m_offset);
+
+    // Keep surrogate pairs together across chunk boundaries
+    if (m_offset + length < m_text.size() && m_text.at(m_offset + length - 1).isHighSurrogate())
+    {
+        ++length;
+    }
+
+    const QString chunk = normalizeChunk(m_offset, length);
+    m_offset += length;
+
+    if (m_firstChunk)
+    {
+        m_cursor.beginEditBlock();
+        m_firstChunk = false;
+    }
+    else
+    {
+        m_cursor.joinPreviousEditBlock();
+    }
+    m_cursor.insertText(chunk);
+    m_cursor.endEditBlock();
+
+    // A modal progress dialog pumps events here, so Cancel may land mid-call
+    m_progressDialog->setValue(int(m_offset * 1000 / m_text.size()));
+    if (m_done)
+        return;
+
+    if (m_offset < m_text.size())
+    {
+        QTimer::singleShot(0, this, &ChunkedTextInserter::insertNextChunk);
+    }
+    else
+    {
+        finish(true);
+    }
+}
+
+void ChunkedTextInserter::finish(bool completed)
+{
+    m_done = true;
+    closeGroup();
+
+    m_progressDialog->disconnect(this);
+    m_progressDialog->deleteLater();
+    m_progressDialog = nullptr;
+
+    m_editor->setProperty("readOnly", false);
+    m_text.clear();
+
+    emit finished(completed);
+    deleteLater();
+}
+
+void ChunkedTextInserter::closeGroup()
+{
+    if (m_groupOpen && m_store)
+    {
+        m_store->endGroup();
+    }
+    m_groupOpen = false;
+}
+
+QString ChunkedTextInserter::normalizeChunk(qsizetype from, qsizetype length)
+{
+    QString out;
+    out.reserve(length);
+
+    const QChar *data = m_text.constData() + from;
+    for (qsizetype i = 0; i < length; ++i)
+    {
+        const QChar ch = data[i];
+
+        // CRLF and lone CR both become LF; the flag carries across chunks
+        if (m_skipLineFeed)
+        {
+            m_skipLineFeed = false;
+            if (ch == QLatin1Char('\n'))
+                continue;
+        }
+        if (ch == QLatin1Char('\r'))
+        {
+            out.append(QLatin1Char('\n'));
+            m_skipLineFeed = true;
+            continue;
+        }
+
+        if (ch.isHighSurrogate() && i + 1 < length && data[i + 1].isLowSurrogate())
+        {
+            if (QChar::isNonCharacter(QChar::surrogateToUcs4(ch, data[i + 1])))
+            {
+                out.append(QChar(QChar::ReplacementCharacter));
+            }
+            else
+            {
+                out.append(ch);
+                out.append(data[i + 1]);
+            }
+            ++i;
+            continue;
+        }
+
+        // Lone surrogates, NUL and noncharacters cannot be stored as UTF-8 text
+        if (ch.isSurrogate() || ch.isNull() || QChar::isNonCharacter(ch.unicode()))
+        {
+            out.append(QChar(QChar::ReplacementCharacter));
+            continue;
+        }
+
+        out.append(ch);
+    }
+
+    return out;
+}
+
+// ============ PasteAwareTextEdit Implementation ============
+PasteAwareTextEdit::PasteAwareTextEdit(QWidget *parent)
+    : QTextEdit(parent)
+{
+}
+
+void PasteAwareTextEdit::insertFromMimeData(const QMimeData *source)
+{
+    if (isReadOnly() || !source->hasText())
+    {
+        QTextEdit::insertFromMimeData(source);
+        return;
+    }
+
+    const QString text = source->text();
+    if (text.size() < ChunkedTextInserter::LargeInsertThreshold)
+    {
+        QTextEdit::insertFromMimeData(source);
+        return;
+    }
+
+    ChunkedTextInserter *inserter = ChunkedTextInserter::insert(this, textCursor(), text);
+    connect(inserter, &ChunkedTextInserter::finished, this, &PasteAwareTextEdit::largeInsertFinished);
+}
+
+// ============ PasteAwarePlainTextEdit Implementation ============
+PasteAwarePlainTextEdit::PasteAwarePlainTextEdit(QWidget *parent)
+    : QPlainTextEdit(parent)
+{
+}
+
+void PasteAwarePlainTextEdit::insertFromMimeData(const QMimeData *source)
+{
+    if (isReadOnly() || !source->hasText())
+    {
+        QPlainTextEdit::insertFromMimeData(source);
+        return;
+    }
+
+    const QString text = source->text();
+    if (text.size() < ChunkedTextInserter::LargeInsertThreshold)
+    {
+        QPlainTextEdit::insertFromMimeData(source);
+        return;
+    }
+
+    ChunkedTextInserter *inserter = ChunkedTextInserter::insert(this, textCursor(), text);
+    connect(inserter, &ChunkedTextInserter::finished, this, &PasteAwarePlainTextEdit::largeInsertFinished);
+}
@@ -0,0 +1,95 @@
+// src/ui/text_insert.h
+// Chunked, cancellable insertion of very large text into the editors
+#ifndef TEXT_INSERT_H
+#define TEXT_INSERT_H
+
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <QPlainTextEdit>
+#include <QTextCursor>
+#include <QTextEdit>
+
+class QMimeData;
+class QProgressDialog;
+class TextStore;
+
+// ============ Chunked Text Inserter ============
+// Streams a large string into a document one chunk per event-loop turn so
+// the GUI thread never stalls on a huge paste. Line endings and invalid code
+// points are normalized chunk by chunk, and every chunk joins one undo group
+// of the document's TextStore so the whole insert undoes as a single step.
+class ChunkedTextInserter : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Pastes shorter than this (in UTF-16 units) take the normal synchronous path
+    static constexpr qsizetype LargeInsertThreshold = 256 * 1024;
+    static constexpr qsizetype ChunkSize = 64 * 1024;
+
+    // Starts inserting `text` at `cursor`; `editor` is made read-only until
+    // the insert completes or is cancelled. The inserter deletes itself.
+    static ChunkedTextInserter *insert(QWidget *editor, const QTextCursor &cursor, const QString &text);
+
+    void cancel();
+
+signals:
+    void finished(bool completed);
+
+private slots:
+    void insertNextChunk();
+
+private:
+    ChunkedTextInserter(QWidget *editor, const QTextCursor &cursor, const QString &text);
+
+    void start();
+    void finish(bool completed);
+    void closeGroup();
+    QString normalizeChunk(qsizetype from, qsizetype length);
+
+    QWidget *m_editor;
+    QTextCursor m_cursor;
+    QPointer<TextStore> m_store;
+    QString m_text;
+    qsizetype m_offset;
+    bool m_skipLineFeed;
+    bool m_firstChunk;
+    bool m_done;
+    bool m_groupOpen;
+    QProgressDialog *m_progressDialog;
+};
+
+// ============ Paste-Aware Text Edit ============
+// QTextEdit that routes very large pastes and drops through ChunkedTextInserter
+class PasteAwareTextEdit : public QTextEdit
+{
+    Q_OBJECT
+
+public:
+    explicit PasteAwareTextEdit(QWidget *parent = nullptr);
+
+signals:
+    void largeInsertFinished(bool completed);
+
+protected:
+    void insertFromMimeData(const QMimeData *source) override;
+};
+
+// ============ Paste-Aware Plain Text Edit ============
+// Same paste routing for the large-document editor
+class PasteAwarePlainTextEdit : public QPlainTextEdit
+{
+    Q_OBJECT
+
+public:
+    explicit PasteAwarePlainTextEdit(QWidget *parent = nullptr);
+
+signals:
+    void largeInsertFinished(bool completed);
+
+protected:
+    void insertFromMimeData(const QMimeData *source) override;
+};
+
+#endif // TEXT_INSERT_H
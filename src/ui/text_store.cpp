@@ -0,0 +1,444 @@
+// text_store.cpp
+#include "text_store.h"
+#include <QTextCursor>
+#include <QTextDocument>
+
+namespace
+{
+    // Keystrokes further apart than this start a new undo step
+    constexpr qint64 CoalesceWindowMs = 1500;
+
+    // Typing one character at a time fragments the table; past this many
+    // pieces, with few characters per piece, it is rewritten into one buffer
+    constexpr qsizetype CompactPieceCount = 4096;
+    constexpr qsizetype CompactCharsPerPiece = 64;
+
+    bool isKeystroke(const PieceTable::Snapshot &text)
+    {
+        return text.size() == 1 && text.toString() != QLatin1String("\n");
+    }
+}
+
+// ============ TextStore Implementation ============
+TextStore::TextStore(QTextDocument *document)
+    : QObject(document), m_document(document), m_table(document->toPlainText()), m_revision(0), m_savedRevision(0), m_pendingOverflow(false), m_nextGroup(1), m_openGroup(0), m_groupDepth(0), m_tracking(true)
+{
+    m_document->setUndoRedoEnabled(false);
+    connect(m_document, &QTextDocument::contentsChange, this, &TextStore::onContentsChange);
+}
+
+TextStore *TextStore::forDocument(QTextDocument *document)
+{
+    if (!document)
+        return nullptr;
+    return document->findChild<TextStore *>(QString(), Qt::FindDirectChildrenOnly);
+}
+
+PieceTable::Snapshot TextStore::snapshot() const
+{
+    return m_table.snapshot();
+}
+
+qsizetype TextStore::size() const
+{
+    return m_table.size();
+}
+
+qint64 TextStore::memoryUsage() const
+{
+    // Buffers are shared between the text and the history and are counted
+    // once by the table; history steps only add their own nodes
+    qsizetype historyPieces = 0;
+    for (const Step &step : m_undo)
+        historyPieces += step.removed.pieceCount() + step.inserted.pieceCount();
+    for (const Step &step : m_redo)
+        historyPieces += step.removed.pieceCount() + step.inserted.pieceCount();
+
+    const qsizetype steps = qsizetype(m_undo.size() + m_redo.size());
+    return m_table.memoryUsage() + PieceTable::nodeMemory(historyPieces) + steps * qsizetype(sizeof(Step));
+}
+
+void TextStore::suspendTracking()
+{
+    m_tracking = false;
+}
+
+void TextStore::reset(const QString &text)
+{
+    m_table.reset(text);
+    clearHistory();
+    m_pending.clear();
+    m_pendingOverflow = false;
+    m_revision = 0;
+    m_savedRevision = 0;
+    m_tracking = true;
+}
+
+void TextStore::clearHistory()
+{
+    m_undo.clear();
+    m_redo.clear();
+    m_lastEdit.invalidate();
+}
+
+void TextStore::beginGroup()
+{
+    if (m_groupDepth++ == 0)
+    {
+        m_openGroup = m_nextGroup++;
+    }
+}
+
+void TextStore::endGroup()
+{
+    if (m_groupDepth > 0 && --m_groupDepth == 0)
+    {
+        m_lastEdit.invalidate();
+    }
+}
+
+bool TextStore::canUndo() const
+{
+    return !m_undo.empty();
+}
+
+bool TextStore::canRedo() const
+{
+    return !m_redo.empty();
+}
+
+int TextStore::undo()
+{
+    if (m_undo.empty())
+        return -1;
+
+    const quint64 group = m_undo.back().group;
+    int caret = -1;
+    while (!m_undo.empty() && m_undo.back().group == group)
+    {
+        Step step = m_undo.back();
+        m_undo.pop_back();
+        caret = apply(step, true);
+        m_redo.push_back(step);
+    }
+
+    m_lastEdit.invalidate();
+    return caret;
+}
+
+int TextStore::redo()
+{
+    if (m_redo.empty())
+        return -1;
+
+    const quint64 group = m_redo.back().group;
+    int caret = -1;
+    while (!m_redo.empty() && m_redo.back().group == group)
+    {
+        Step step = m_redo.back();
+        m_redo.pop_back();
+        caret = apply(step, false);
+        m_undo.push_back(step);
+    }
+
+    m_lastEdit.invalidate();
+    return caret;
+}
+
+qint64 TextStore::revision() const
+{
+    return m_revision;
+}
+
+qint64 TextStore::savedRevision() const
+{
+    return m_savedRevision;
+}
+
+bool TextStore::isModified() const
+{
+    return m_revision != m_savedRevision;
+}
+
+TextDelta TextStore::delta() const
+{
+    if (m_pendingOverflow)
+        return fullDelta();
+
+    TextDelta delta;
+    delta.baseRevision = m_savedRevision;
+    delta.revision = m_revision;
+    delta.ops.reserve(m_pending.size());
+    for (const PendingOp &op : m_pending)
+        delta.ops.push_back({op.offset, op.removed, op.inserted.toString().toUtf8()});
+    return delta;
+}
+
+TextDelta TextStore::fullDelta() const
+{
+    TextDelta delta;
+    delta.baseRevision = -1;
+    delta.revision = m_revision;
+    delta.ops.push_back({0, 0, m_table.toString().toUtf8()});
+    return delta;
+}
+
+void TextStore::markSaved(qint64 revision)
+{
+    // A save that raced further edits leaves them pending
+    if (revision != m_revision)
+        return;
+
+    m_pending.clear();
+    m_pendingOverflow = false;
+    m_savedRevision = revision;
+}
+
+void TextStore::markLoaded()
+{
+    if (isModified())
+        return;
+
+    m_revision = 0;
+    m_savedRevision = 0;
+    m_pending.clear();
+    m_pendingOverflow = false;
+}
+
+void TextStore::invalidateBase()
+{
+    m_pending.clear();
+    m_pendingOverflow = true;
+}
+
+void TextStore::onContentsChange(int position, int charsRemoved, int charsAdded)
+{
+    if (!m_tracking)
+        return;
+
+    // Whole-document changes also count the closing paragraph separator,
+    // which has no counterpart in the plain text
+    const qsizetype documentLength = m_document->characterCount() - 1;
+    const qsizetype removed = qMin(qsizetype(charsRemoved), m_table.size() - position);
+    const qsizetype added = qMin(qsizetype(charsAdded), documentLength - position);
+    if (position < 0 || removed < 0 || added < 0 || m_table.size() - removed + added != documentLength)
+    {
+        resync();
+        return;
+    }
+
+    const QString inserted = documentText(position, added);
+
+    // Format-only changes report the same range as both removed and added
+    if (removed == added && m_table.mid(position, removed) == inserted)
+        return;
+
+    const qint64 offset = m_table.utf8Offset(position);
+
+    Step step;
+    step.position = position;
+    step.removed = m_table.remove(position, removed);
+    step.inserted = m_table.insert(position, inserted);
+    step.group = 0;
+    recordDelta(offset, step.removed, step.inserted);
+    record(step);
+    emit changed();
+}
+
+void TextStore::record(Step step)
+{
+    m_redo.clear();
+    step.group = m_groupDepth > 0 ? m_openGroup : m_nextGroup++;
+
+    if (!coalesce(step))
+    {
+        m_undo.push_back(step);
+    }
+    m_lastEdit.restart();
+
+    if (m_table.pieceCount() > CompactPieceCount && m_table.pieceCount() * CompactCharsPerPiece > m_table.size())
+    {
+        m_table.compact();
+    }
+    trimHistory();
+}
+
+void TextStore::trimHistory()
+{
+    while (int(m_undo.size()) > MaxUndoSteps && dropOldestStep())
+    {
+    }
+
+    // Nothing to give up but the group still being built
+    if (historyMemory() <= MaxUndoBytes || m_undo.empty() || (m_groupDepth > 0 && m_undo.front().group == m_openGroup))
+        return;
+
+    // Text removed from buffers the current text still points into is only
+    // let go once the text is rewritten into its own buffer
+    m_table.compact();
+    while (historyMemory() > MaxUndoBytes / 4 * 3 && dropOldestStep())
+    {
+    }
+}
+
+bool TextStore::dropOldestStep()
+{
+    // Whole steps from the old end, never the group still being built
+    if (m_undo.empty())
+        return false;
+
+    const quint64 oldest = m_undo.front().group;
+    if (m_groupDepth > 0 && oldest == m_openGroup)
+        return false;
+    while (!m_undo.empty() && m_undo.front().group == oldest)
+        m_undo.pop_front();
+    return true;
+}
+
+qint64 TextStore::historyMemory() const
+{
+    const qint64 text = m_table.size() * qint64(sizeof(QChar)) + PieceTable::nodeMemory(m_table.pieceCount());
+    return qMax<qint64>(0, memoryUsage() - text);
+}
+
+bool TextStore::coalesce(const Step &step)
+{
+    if (m_undo.empty())
+        return false;
+
+    Step &last = m_undo.back();
+    const bool grouped = m_groupDepth > 0 && last.group == step.group;
+
+    // Outside a group only single keystrokes that keep flowing are merged
+    if (!grouped)
+    {
+        if (!m_lastEdit.isValid() || m_lastEdit.elapsed() > CoalesceWindowMs)
+            return false;
+        if (!(isKeystroke(step.inserted) && step.removed.isEmpty()) &&
+            !(isKeystroke(step.removed) && step.inserted.isEmpty()))
+            return false;
+    }
+
+    // Typing on at the end of the previous insert
+    if (step.removed.isEmpty() && step.position == last.position + last.inserted.size())
+    {
+        last.inserted = m_table.concat(last.inserted, step.inserted);
+        return true;
+    }
+
+    if (step.inserted.isEmpty() && last.inserted.isEmpty())
+    {
+        // Backspace
+        if (step.position + step.removed.size() == last.position)
+        {
+            last.position = step.position;
+            last.removed = m_table.concat(step.removed, last.removed);
+            return true;
+        }
+        // Forward delete
+        if (step.position == last.position)
+        {
+            last.removed = m_table.concat(last.removed, step.removed);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+int TextStore::apply(const Step &step, bool undoing)
+{
+    const PieceTable::Snapshot &outgoing = undoing ? step.inserted : step.removed;
+    const PieceTable::Snapshot &incoming = undoing ? step.removed : step.inserted;
+
+    // The table is updated from the stored pieces, so the document edit
+    // must not be mirrored a second time
+    m_tracking = false;
+    QTextCursor cursor(m_document);
+    cursor.setPosition(int(step.position));
+    cursor.setPosition(int(step.position + outgoing.size()), QTextCursor::KeepAnchor);
+    cursor.insertText(incoming.toString());
+    m_tracking = true;
+
+    recordDelta(m_table.utf8Offset(step.position), outgoing, incoming);
+    m_table.remove(step.position, outgoing.size());
+    m_table.insert(step.position, incoming);
+    emit changed();
+
+    return int(step.position + incoming.size());
+}
+
+void TextStore::recordDelta(qint64 offset, const PieceTable::Snapshot &removed, const PieceTable::Snapshot &inserted)
+{
+    ++m_revision;
+    if (m_pendingOverflow)
+        return;
+
+    if (!m_pending.empty())
+    {
+        PendingOp &last = m_pending.back();
+
+        // Typing on at the end of the previous insert
+        if (removed.isEmpty() && offset == last.offset + last.inserted.utf8Size())
+        {
+            last.inserted = m_table.concat(last.inserted, inserted);
+            return;
+        }
+        // Backspace and forward delete over untouched text
+        if (inserted.isEmpty() && last.inserted.isEmpty())
+        {
+            if (offset + removed.utf8Size() == last.offset)
+            {
+                last.offset = offset;
+                last.removed += removed.utf8Size();
+                return;
+            }
+            if (offset == last.offset)
+            {
+                last.removed += removed.utf8Size();
+                return;
+            }
+        }
+    }
+
+    if (int(m_pending.size()) >= MaxDeltaOps)
+    {
+        m_pending.clear();
+        m_pendingOverflow = true;
+        return;
+    }
+    m_pending.push_back({offset, removed.utf8Size(), inserted});
+}
+
+QString TextStore::documentText(qsizetype position, qsizetype length) const
+{
+    if (length <= 0)
+        return QString();
+
+    QTextCursor cursor(m_document);
+    cursor.setPosition(int(position));
+    cursor.setPosition(int(position + length), QTextCursor::KeepAnchor);
+
+    // Same character mapping as QTextDocument::toPlainText(), one for one
+    QString text = cursor.selectedText();
+    for (QChar &ch : text)
+    {
+        if (ch == QChar::ParagraphSeparator || ch == QChar::LineSeparator)
+            ch = QLatin1Char('\n');
+        else if (ch == QChar::Nbsp)
+            ch = QLatin1Char(' ');
+    }
+    return text;
+}
+
+void TextStore::resync()
+{
+    m_table.reset(m_document->toPlainText());
+    clearHistory();
+
+    // The ops no longer describe how the text got here
+    ++m_revision;
+    m_pending.clear();
+    m_pendingOverflow = true;
+    emit changed();
+}
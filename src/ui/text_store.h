@@ -0,0 +1,144 @@
+// src/ui/text_store.h
+// Piece-table mirror of an editor document with a compact undo history
+#ifndef TEXT_STORE_H
+#define TEXT_STORE_H
+
+#include "piece_table.h"
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QObject>
+#include <deque>
+#include <vector>
+
+class QTextDocument;
+
+// ============ Text Delta ============
+// Edits made since the last save, as UTF-8 operations applied in order to the
+// text saved at baseRevision. A baseRevision of -1 means the single op carries
+// the whole text and needs no base.
+struct TextDelta
+{
+    struct Op
+    {
+        qint64 offset;
+        qint64 removed;
+        QByteArray inserted;
+    };
+
+    qint64 baseRevision;
+    qint64 revision;
+    std::vector<Op> ops;
+};
+
+// ============ Text Store ============
+// Mirrors a QTextDocument into a PieceTable and takes over its undo history.
+// An undo step keeps the pieces it removed and inserted instead of copies of
+// the text, consecutive keystrokes coalesce into one step, and the history is
+// capped at MaxUndoSteps and MaxUndoBytes, so memory stays bounded over a long
+// session.
+class TextStore : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int MaxUndoSteps = 1000;
+
+    // Memory the history may hold beyond the text itself: removed text and
+    // typing buffers only undo still refers to. Past it the oldest steps go
+    // until it is back under three quarters of this.
+    static constexpr qint64 MaxUndoBytes = 16 * 1024 * 1024;
+
+    // Past this many unsaved operations a save sends the whole text instead
+    static constexpr int MaxDeltaOps = 256;
+
+    // Becomes a child of `document` and disables the document's own undo stack
+    explicit TextStore(QTextDocument *document);
+    static TextStore *forDocument(QTextDocument *document);
+
+    // Cheap, immutable copy of the current text for background workers
+    PieceTable::Snapshot snapshot() const;
+    qsizetype size() const;
+    qint64 memoryUsage() const;
+
+    // Wrap a programmatic reload: the store ignores the document until
+    // reset() hands it the new text and drops the history
+    void suspendTracking();
+    void reset(const QString &text);
+    void clearHistory();
+
+    // Edits between beginGroup() and endGroup() undo as one step
+    void beginGroup();
+    void endGroup();
+
+    bool canUndo() const;
+    bool canRedo() const;
+
+    // Both return the caret position after the step, or -1 if there was none
+    int undo();
+    int redo();
+
+    // Every change bumps the revision; reset() starts again at 0
+    qint64 revision() const;
+    qint64 savedRevision() const;
+    bool isModified() const;
+    TextDelta delta() const;
+    TextDelta fullDelta() const;
+    void markSaved(qint64 revision);
+
+    // The saved text was just handed over again as revision 0 (a cached
+    // page matched what was loaded); keeps the undo history
+    void markLoaded();
+
+    // Storage no longer holds this store's saved revision (a page with
+    // unsaved edits was shown again), so the next save sends the whole text
+    void invalidateBase();
+
+signals:
+    // Emitted for every edit that reaches the store, including undo and redo
+    void changed();
+
+private slots:
+    void onContentsChange(int position, int charsRemoved, int charsAdded);
+
+private:
+    struct Step
+    {
+        qsizetype position;
+        PieceTable::Snapshot removed;
+        PieceTable::Snapshot inserted;
+        quint64 group;
+    };
+
+    struct PendingOp
+    {
+        qint64 offset;
+        qint64 removed;
+        PieceTable::Snapshot inserted;
+    };
+
+    void record(Step step);
+    bool coalesce(const Step &step);
+    void trimHistory();
+    bool dropOldestStep();
+    qint64 historyMemory() const;
+    int apply(const Step &step, bool undoing);
+    void recordDelta(qint64 offset, const PieceTable::Snapshot &removed, const PieceTable::Snapshot &inserted);
+    QString documentText(qsizetype position, qsizetype length) const;
+    void resync();
+
+    QTextDocument *m_document;
+    PieceTable m_table;
+    std::deque<Step> m_undo;
+    std::vector<Step> m_redo;
+    QElapsedTimer m_lastEdit;
+    std::vector<PendingOp> m_pending;
+    qint64 m_revision;
+    qint64 m_savedRevision;
+    bool m_pendingOverflow;
+    quint64 m_nextGroup;
+    quint64 m_openGroup;
+    int m_groupDepth;
+    bool m_tracking;
+};
+
+#endif // TEXT_STORE_H
@@ -0,0 +1,118 @@
+// bench_bridge_strings.cpp
+// Conversion cost of the bridge's string paths on page-sized content
+#include <QHash>
+#include <QTest>
+
+// ============ Bridge String Benchmark ============
+// The bridge used to take NUL-terminated UTF-8, which QString::fromUtf8
+// has to strlen() before transcoding. Content now comes with its length,
+// as UTF-8 or as UTF-16 that is copied into the QString as it is. The text
+// mixes ASCII with accented letters and emoji, as journal pages do.
+class BridgeStringBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void nulTerminatedUtf8_data();
+    void nulTerminatedUtf8();
+    void utf8WithLength_data();
+    void utf8WithLength();
+    void utf16WithLength_data();
+    void utf16WithLength();
+
+private:
+    static void addSizes();
+
+    // The same text both ways, by size
+    QHash<int, QByteArray> m_utf8;
+    QHash<int, QString> m_utf16;
+};
+
+void BridgeStringBenchmark::addSizes()
+{
+    QTest::addColumn<int>("kilobytes");
+    QTest::newRow("1 KB") << 1;
+    QTest::newRow("100 KB") << 100;
+    QTest::newRow("1 MB") << 1024;
+    QTest::newRow("10 MB") << 10 * 1024;
+}
+
+void BridgeStringBenchmark::initTestCase()
+{
+    const QByteArray paragraph("Caf\xc3\xa9 au lait on the terrace, then a long walk by the river. "
+                               "\xc3\x9c" "berraschung: the bakery was open \xf0\x9f\x8e\x89. Notes for tomorrow follow.\n");
+    for (int kilobytes : {1, 100, 1024, 10 * 1024})
+    {
+        QByteArray bytes;
+        bytes.reserve(kilobytes * 1024 + paragraph.size());
+        while (bytes.size() < kilobytes * 1024)
+            bytes += paragraph;
+
+        m_utf8.insert(kilobytes, bytes);
+        m_utf16.insert(kilobytes, QString::fromUtf8(bytes));
+    }
+}
+
+void BridgeStringBenchmark::nulTerminatedUtf8_data()
+{
+    addSizes();
+}
+
+void BridgeStringBenchmark::nulTerminatedUtf8()
+{
+    QFETCH(int, kilobytes);
+    const QByteArray bytes = m_utf8.value(kilobytes);
+    const char *text = bytes.constData();
+
+    QString content;
+    QBENCHMARK
+    {
+        content = QString::fromUtf8(text);
+    }
+    QCOMPARE(content.size(), m_utf16.value(kilobytes).size());
+}
+
+void BridgeStringBenchmark::utf8WithLength_data()
+{
+    addSizes();
+}
+
+void BridgeStringBenchmark::utf8WithLength()
+{
+    QFETCH(int, kilobytes);
+    const QByteArray bytes = m_utf8.value(kilobytes);
+    const char *text = bytes.constData();
+    const long long length = bytes.size();
+
+    QString content;
+    QBENCHMARK
+    {
+        content = QString::fromUtf8(text, qsizetype(length));
+    }
+    QCOMPARE(content.size(), m_utf16.value(kilobytes).size());
+}
+
+void BridgeStringBenchmark::utf16WithLength_data()
+{
+    addSizes();
+}
+
+void BridgeStringBenchmark::utf16WithLength()
+{
+    QFETCH(int, kilobytes);
+    const QString units = m_utf16.value(kilobytes);
+    const unsigned short *text = units.utf16();
+    const long long length = units.size();
+
+    QString content;
+    QBENCHMARK
+    {
+        content = QString(reinterpret_cast<const QChar *>(text), qsizetype(length));
+    }
+    QCOMPARE(content.size(), units.size());
+}
+
+QTEST_GUILESS_MAIN(BridgeStringBenchmark)
+#include "bench_bridge_strings.moc"
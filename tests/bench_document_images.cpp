@@ -0,0 +1,224 @@
+// bench_document_images.cpp
+// Open time and memory of a note with 500 images, lazy against eager
+#include "bench_memory.h"
+#include "image_loader.h"
+#include "page_editor.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QPainter>
+#include <QPixmapCache>
+#include <QTemporaryDir>
+#include <QTest>
+#include <QTextDocument>
+#include <QTextEdit>
+#include <QTextImageFormat>
+#include <memory>
+
+// ============ Document Images Benchmark ============
+// PageEditor puts stored images back as placeholders and decodes only those
+// near the viewport. The eager row is what it did before: every image goes
+// to the ImageLoader as soon as the note is loaded. Open time runs until the
+// last decode that was started has been drawn in.
+class DocumentImagesBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void init();
+
+    void open_data();
+    void open();
+    void memory_data();
+    void memory();
+
+private:
+    // A note opened one way or the other, with the time its last decode landed
+    struct OpenNote
+    {
+        std::unique_ptr<QWidget> editor;
+        std::unique_ptr<ImageLoader> loader;
+        QHash<quint64, int> positions;
+        QElapsedTimer timer;
+        qint64 lastDecode = 0;
+    };
+
+    static void addRows();
+    void openLazy(OpenNote *note);
+    void openEager(OpenNote *note);
+    static void waitForDecodes(OpenNote *note);
+
+    static constexpr int ImageCount = 500;
+    static constexpr int QuietMs = 500;
+
+    QTemporaryDir m_dir;
+    QString m_text;
+    QList<StoredImage> m_images;
+};
+
+void DocumentImagesBenchmark::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+
+    // One camera-sized photo, stored once per image
+    const QSize photoSize(1280, 960);
+    QImage photo(photoSize, QImage::Format_RGB32);
+    QPainter painter(&photo);
+    QLinearGradient gradient(0, 0, photoSize.width(), photoSize.height());
+    gradient.setColorAt(0, QColor(30, 90, 160));
+    gradient.setColorAt(1, QColor(220, 200, 120));
+    painter.fillRect(photo.rect(), gradient);
+    painter.end();
+
+    const QString original = m_dir.filePath(QStringLiteral("photo-0.jpg"));
+    QVERIFY(photo.save(original, "JPEG", 85));
+
+    // A caption paragraph, then the image on a line of its own
+    for (int i = 0; i < ImageCount; ++i)
+    {
+        const QString path = m_dir.filePath(QStringLiteral("photo-%1.jpg").arg(i));
+        if (i > 0)
+            QVERIFY(QFile::copy(original, path));
+
+        m_text += QStringLiteral("Photo %1, taken on the walk along the river.\n").arg(i + 1);
+
+        StoredImage image;
+        image.id = i + 1;
+        image.path = path;
+        image.position = int(m_text.size());
+        image.size = ImageLoader::displaySize(photoSize);
+        m_images.append(image);
+
+        m_text += QChar::ObjectReplacementCharacter;
+        m_text += QLatin1Char('\n');
+    }
+}
+
+void DocumentImagesBenchmark::init()
+{
+    // Pixels from the previous row would count against this one
+    QPixmapCache::clear();
+    releaseFreedMemory();
+}
+
+void DocumentImagesBenchmark::addRows()
+{
+    QTest::addColumn<bool>("lazy");
+    QTest::newRow("lazy") << true;
+    QTest::newRow("eager") << false;
+}
+
+void DocumentImagesBenchmark::openLazy(OpenNote *note)
+{
+    auto editor = std::make_unique<PageEditor>();
+    editor->resize(900, 700);
+    editor->show();
+    QVERIFY(QTest::qWaitForWindowExposed(editor.get()));
+
+    ImageLoader *loader = editor->findChild<ImageLoader *>();
+    QVERIFY(loader);
+    connect(loader, &ImageLoader::loaded, this, [note]()
+            { note->lastDecode = note->timer.elapsed(); });
+
+    note->timer.start();
+    editor->setPlainText(m_text);
+    editor->placeImages(m_images);
+    editor->repaint();
+    note->editor = std::move(editor);
+}
+
+void DocumentImagesBenchmark::openEager(OpenNote *note)
+{
+    auto editor = std::make_unique<QTextEdit>();
+    editor->setAcceptRichText(false);
+    editor->resize(900, 700);
+    editor->show();
+    QVERIFY(QTest::qWaitForWindowExposed(editor.get()));
+
+    // Each decoded image is drawn in where its character is
+    note->loader = std::make_unique<ImageLoader>();
+    QTextDocument *document = editor->document();
+    connect(note->loader.get(), &ImageLoader::loaded, this, [note, document](quint64 ticket, const QImage &image)
+            {
+        const int position = note->positions.value(ticket);
+        document->addResource(QTextDocument::ImageResource, QUrl(QStringLiteral("image://%1").arg(ticket)),
+                              QPixmap::fromImage(image));
+        document->markContentsDirty(position, 1);
+        note->lastDecode = note->timer.elapsed(); });
+
+    note->timer.start();
+    editor->setPlainText(m_text);
+    for (const StoredImage &image : m_images)
+    {
+        const quint64 ticket = note->loader->load(image.path, ImageLoader::thumbnailSize(image.size, editor->devicePixelRatioF()));
+        note->positions.insert(ticket, image.position);
+
+        QTextImageFormat format;
+        format.setName(QStringLiteral("image://%1").arg(ticket));
+        format.setWidth(image.size.width());
+        format.setHeight(image.size.height());
+        QTextCursor cursor(document);
+        cursor.setPosition(image.position);
+        cursor.setPosition(image.position + 1, QTextCursor::KeepAnchor);
+        cursor.setCharFormat(format);
+    }
+    editor->repaint();
+    note->editor = std::move(editor);
+}
+
+void DocumentImagesBenchmark::waitForDecodes(OpenNote *note)
+{
+    // Decodes land one after another; a quiet spell means the last is in
+    do
+    {
+        QTest::qWait(QuietMs);
+    } while (note->timer.elapsed() - note->lastDecode < QuietMs);
+}
+
+void DocumentImagesBenchmark::open_data()
+{
+    addRows();
+}
+
+void DocumentImagesBenchmark::open()
+{
+    QFETCH(bool, lazy);
+
+    OpenNote note;
+    if (lazy)
+        openLazy(&note);
+    else
+        openEager(&note);
+    QVERIFY(note.editor);
+    qInfo("First frame after %lld ms", note.timer.elapsed());
+
+    waitForDecodes(&note);
+    QTest::setBenchmarkResult(qreal(note.lastDecode), QTest::WalltimeMilliseconds);
+}
+
+void DocumentImagesBenchmark::memory_data()
+{
+    addRows();
+}
+
+void DocumentImagesBenchmark::memory()
+{
+    QFETCH(bool, lazy);
+
+    const qint64 before = residentBytes();
+    if (before < 0)
+        QSKIP("Resident memory is only read on Linux");
+
+    OpenNote note;
+    if (lazy)
+        openLazy(&note);
+    else
+        openEager(&note);
+    QVERIFY(note.editor);
+
+    waitForDecodes(&note);
+    QTest::setBenchmarkResult(qreal(residentBytes() - before), QTest::BytesAllocated);
+}
+
+QTEST_MAIN(DocumentImagesBenchmark)
+#include "bench_document_images.moc"
@@ -0,0 +1,177 @@
+// bench_editor_layout.cpp
+// Resize, scroll and keystroke frame times of the editor views' layout
+#include "page_editor.h"
+#include <QLabel>
+#include <QScrollArea>
+#include <QScrollBar>
+#include <QTest>
+#include <QVBoxLayout>
+#include <memory>
+
+// ============ Editor Layout Benchmark ============
+// The book and note views used to wrap their PageEditor in a resizable
+// QScrollArea, with the page margin from the wrapper's layout and a 500 px
+// minimum height. Now the editor sits in the view directly and carries the
+// margin itself. Both are built here around the same page, each frame being
+// the change plus a synchronous repaint of the view.
+class EditorLayoutBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void resize_data();
+    void resize();
+    void scroll_data();
+    void scroll();
+    void keystroke_data();
+    void keystroke();
+
+private:
+    static void addRows();
+    void buildView(bool nested);
+
+    // Well below PageEditor::LargeDocumentThreshold, so the regular editor
+    static constexpr int Paragraphs = 2000;
+
+    QString m_text;
+    std::unique_ptr<QWidget> m_window;
+    QWidget *m_view = nullptr;
+    PageEditor *m_editor = nullptr;
+    QAbstractScrollArea *m_textEdit = nullptr;
+};
+
+void EditorLayoutBenchmark::initTestCase()
+{
+    for (int i = 0; i < Paragraphs; ++i)
+        m_text += QStringLiteral("Paragraph %1 of the page, long enough to wrap over a line or two of the "
+                                 "editor at its usual width, like the prose a book page holds.\n")
+                      .arg(i + 1);
+}
+
+void EditorLayoutBenchmark::init()
+{
+    QFETCH(bool, nested);
+    buildView(nested);
+}
+
+void EditorLayoutBenchmark::cleanup()
+{
+    m_window.reset();
+    m_view = nullptr;
+    m_editor = nullptr;
+    m_textEdit = nullptr;
+}
+
+void EditorLayoutBenchmark::addRows()
+{
+    QTest::addColumn<bool>("nested");
+    QTest::newRow("nested scroll area") << true;
+    QTest::newRow("single scroller") << false;
+}
+
+void EditorLayoutBenchmark::buildView(bool nested)
+{
+    // The view is a child, so resizing it is synchronous
+    m_window = std::make_unique<QWidget>();
+    m_window->resize(1200, 900);
+    m_view = new QWidget(m_window.get());
+    m_view->setGeometry(0, 0, 1000, 800);
+
+    QVBoxLayout *layout = new QVBoxLayout(m_view);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addWidget(new QLabel(QStringLiteral("Header")));
+
+    m_editor = new PageEditor;
+    if (nested)
+    {
+        QScrollArea *scrollArea = new QScrollArea;
+        scrollArea->setWidgetResizable(true);
+        scrollArea->setFrameShape(QFrame::NoFrame);
+        scrollArea->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+
+        QWidget *editorContainer = new QWidget;
+        QVBoxLayout *editorLayout = new QVBoxLayout(editorContainer);
+        editorLayout->setContentsMargins(40, 30, 40, 30);
+        m_editor->setMinimumHeight(500);
+        editorLayout->addWidget(m_editor);
+        scrollArea->setWidget(editorContainer);
+        layout->addWidget(scrollArea);
+    }
+    else
+    {
+        m_editor->setContentsMargins(40, 30, 40, 30);
+        layout->addWidget(m_editor);
+    }
+
+    m_editor->setPlainText(m_text);
+    m_textEdit = qobject_cast<QAbstractScrollArea *>(m_editor->currentWidget());
+    QVERIFY(m_textEdit);
+    QVERIFY(!m_editor->isLargeMode());
+
+    m_window->show();
+    QVERIFY(QTest::qWaitForWindowExposed(m_window.get()));
+}
+
+void EditorLayoutBenchmark::resize_data()
+{
+    addRows();
+}
+
+void EditorLayoutBenchmark::resize()
+{
+    // Back and forth between two widths, as when dragging the window edge
+    int frame = 0;
+    QBENCHMARK
+    {
+        const int step = (frame++ % 2) * 80;
+        m_view->resize(1000 - step, 800 - step / 2);
+        QCoreApplication::sendPostedEvents(nullptr, QEvent::LayoutRequest);
+        m_view->repaint();
+    }
+}
+
+void EditorLayoutBenchmark::scroll_data()
+{
+    addRows();
+}
+
+void EditorLayoutBenchmark::scroll()
+{
+    // One page down per frame, back to the top at the end
+    QScrollBar *bar = m_textEdit->verticalScrollBar();
+    QVERIFY(bar->maximum() > 0);
+    QBENCHMARK
+    {
+        bar->setValue(bar->value() < bar->maximum() ? bar->value() + bar->pageStep() : 0);
+        m_view->repaint();
+    }
+}
+
+void EditorLayoutBenchmark::keystroke_data()
+{
+    addRows();
+}
+
+void EditorLayoutBenchmark::keystroke()
+{
+    // Typing in the middle of the page, with a new paragraph now and then
+    QTextCursor cursor = m_editor->textCursor();
+    cursor.setPosition(m_text.size() / 2);
+    m_editor->setTextCursor(cursor);
+    m_textEdit->setFocus();
+
+    int frame = 0;
+    QBENCHMARK
+    {
+        QTest::keyClick(m_textEdit, ++frame % 60 == 0 ? Qt::Key_Return : Qt::Key_A);
+        QCoreApplication::sendPostedEvents(nullptr, QEvent::LayoutRequest);
+        m_view->repaint();
+    }
+}
+
+QTEST_MAIN(EditorLayoutBenchmark)
+#include "bench_editor_layout.moc"
@@ -0,0 +1,96 @@
+// bench_image_scaler.cpp
+// ImageScaler against QImage::scaled() on camera-sized photos
+#include "image_scaler.h"
+#include <QImage>
+#include <QPainter>
+#include <QTest>
+
+// ============ Image Scaler Benchmark ============
+// Both shrink to the longest side ImageLoader keeps (1600 px) with the same
+// box filter; ImageScaler spreads the rows over all cores.
+class ImageScalerBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void imageScaler_data();
+    void imageScaler();
+    void qimageScaled_data();
+    void qimageScaled();
+
+private:
+    static QImage photo(const QSize &size);
+    static void addSizes();
+
+    static constexpr int MaxSide = 1600;
+};
+
+QImage ImageScalerBenchmark::photo(const QSize &size)
+{
+    // Gradients and edges rather than a flat fill, so nothing is trivially
+    // constant
+    QImage image(size, QImage::Format_RGB32);
+    QPainter painter(&image);
+    QLinearGradient gradient(0, 0, size.width(), size.height());
+    gradient.setColorAt(0, QColor(30, 90, 160));
+    gradient.setColorAt(0.5, QColor(220, 200, 120));
+    gradient.setColorAt(1, QColor(40, 120, 60));
+    painter.fillRect(image.rect(), gradient);
+    painter.setPen(QPen(Qt::white, 3));
+    for (int x = 0; x < size.width(); x += 97)
+        painter.drawLine(x, 0, size.width() - x, size.height());
+    return image;
+}
+
+void ImageScalerBenchmark::addSizes()
+{
+    QTest::addColumn<QSize>("size");
+    QTest::newRow("12MP") << QSize(4000, 3000);
+    QTest::newRow("48MP") << QSize(8000, 6000);
+}
+
+void ImageScalerBenchmark::initTestCase()
+{
+    qInfo("AVX2 kernel: %s", ImageScaler::hasAvx2() ? "yes" : "no");
+}
+
+void ImageScalerBenchmark::imageScaler_data()
+{
+    addSizes();
+}
+
+void ImageScalerBenchmark::imageScaler()
+{
+    QFETCH(QSize, size);
+    const QImage source = photo(size);
+
+    QImage scaled;
+    QBENCHMARK
+    {
+        scaled = ImageScaler::scaled(source, MaxSide);
+    }
+    QCOMPARE(qMax(scaled.width(), scaled.height()), MaxSide);
+}
+
+void ImageScalerBenchmark::qimageScaled_data()
+{
+    addSizes();
+}
+
+void ImageScalerBenchmark::qimageScaled()
+{
+    QFETCH(QSize, size);
+    const QImage source = photo(size);
+
+    QImage scaled;
+    QBENCHMARK
+    {
+        scaled = source.scaled(MaxSide, MaxSide, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    }
+    QCOMPARE(qMax(scaled.width(), scaled.height()), MaxSide);
+}
+
+QTEST_MAIN(ImageScalerBenchmark)
+#include "bench_image_scaler.moc"
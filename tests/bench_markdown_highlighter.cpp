@@ -0,0 +1,126 @@
+// bench_markdown_highlighter.cpp
+// Keystroke cost of Markdown highlighting on a 10,000-line note
+#include "markdown_highlighter.h"
+#include <QTest>
+#include <QTextBlock>
+#include <QTextCursor>
+#include <QTextDocument>
+
+// ============ Markdown Highlighter Benchmark ============
+// Each keystroke re-highlights its own block, plus the blocks after it when
+// it opens or closes a fence. The aim is under 1 ms per keystroke.
+class MarkdownHighlighterBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void typeInParagraph();
+    void typeInHeading();
+    void toggleFence();
+    void install();
+
+private:
+    static QString note(int lines);
+    void typeAt(int block, const QString &text);
+
+    static constexpr int NoteLines = 10000;
+    QTextDocument *m_document = nullptr;
+};
+
+QString MarkdownHighlighterBenchmark::note(int lines)
+{
+    // A mix of every construct, with one short fenced block every 50 lines
+    QStringList text;
+    text.reserve(lines);
+    for (int i = 0; text.size() < lines; ++i)
+    {
+        switch (i % 50)
+        {
+        case 0:
+            text << QStringLiteral("## Section %1").arg(i / 50);
+            break;
+        case 10:
+            text << QStringLiteral("```") << QStringLiteral("let x = %1;").arg(i) << QStringLiteral("```");
+            break;
+        case 20:
+            text << QStringLiteral("> a quoted line with *emphasis* and `code`");
+            break;
+        case 30:
+            text << QStringLiteral("- item with a [link](https://example.com/%1)").arg(i);
+            break;
+        default:
+            text << QStringLiteral("Plain text with **strong** and _emphasis_ words, number %1.").arg(i);
+            break;
+        }
+    }
+    text.resize(lines);
+    return text.join(QLatin1Char('\n'));
+}
+
+void MarkdownHighlighterBenchmark::init()
+{
+    m_document = new QTextDocument;
+    m_document->setPlainText(note(NoteLines));
+    MarkdownHighlighter::install(m_document);
+}
+
+void MarkdownHighlighterBenchmark::cleanup()
+{
+    delete m_document;
+    m_document = nullptr;
+}
+
+void MarkdownHighlighterBenchmark::typeAt(int block, const QString &text)
+{
+    QTextCursor cursor(m_document->findBlockByNumber(block));
+    cursor.movePosition(QTextCursor::EndOfBlock);
+    cursor.insertText(text);
+}
+
+void MarkdownHighlighterBenchmark::typeInParagraph()
+{
+    QCOMPARE(m_document->blockCount(), NoteLines);
+    QBENCHMARK
+    {
+        typeAt(NoteLines / 2 + 1, QStringLiteral("a"));
+    }
+}
+
+void MarkdownHighlighterBenchmark::typeInHeading()
+{
+    QBENCHMARK
+    {
+        typeAt(NoteLines / 2, QStringLiteral("a"));
+    }
+}
+
+void MarkdownHighlighterBenchmark::toggleFence()
+{
+    // Opening a fence re-highlights until the next fence closes it; the
+    // following keystroke that undoes it does the same again
+    QTextCursor cursor(m_document->findBlockByNumber(NoteLines / 2 + 2));
+    QBENCHMARK
+    {
+        cursor.movePosition(QTextCursor::StartOfBlock);
+        cursor.insertText(QStringLiteral("```"));
+        cursor.movePosition(QTextCursor::StartOfBlock);
+        cursor.movePosition(QTextCursor::NextCharacter, QTextCursor::KeepAnchor, 3);
+        cursor.removeSelectedText();
+    }
+}
+
+void MarkdownHighlighterBenchmark::install()
+{
+    // The first highlight of a freshly opened note, for scale
+    QBENCHMARK
+    {
+        MarkdownHighlighter::uninstall(m_document);
+        MarkdownHighlighter::install(m_document);
+    }
+}
+
+QTEST_MAIN(MarkdownHighlighterBenchmark)
+#include "bench_markdown_highlighter.moc"
@@ -0,0 +1,39 @@
+// tests/bench_memory.h
+// Resident memory of the benchmark process, for the memory rows
+#ifndef BENCH_MEMORY_H
+#define BENCH_MEMORY_H
+
+#include <QFile>
+#include <QList>
+#include <QtGlobal>
+#ifdef Q_OS_LINUX
+#include <malloc.h>
+#include <unistd.h>
+#endif
+
+// Resident set size in bytes, or -1 where it is not read
+inline qint64 residentBytes()
+{
+#ifdef Q_OS_LINUX
+    QFile statm(QStringLiteral("/proc/self/statm"));
+    if (!statm.open(QIODevice::ReadOnly))
+        return -1;
+    const QList<QByteArray> fields = statm.readAll().split(' ');
+    if (fields.size() < 2)
+        return -1;
+    return fields.at(1).toLongLong() * qint64(sysconf(_SC_PAGESIZE));
+#else
+    return -1;
+#endif
+}
+
+// Hands memory freed by earlier rows back to the system, so it is not
+// reused unseen by the next one
+inline void releaseFreedMemory()
+{
+#if defined(Q_OS_LINUX) && defined(__GLIBC__)
+    malloc_trim(0);
+#endif
+}
+
+#endif // BENCH_MEMORY_H
@@ -0,0 +1,179 @@
+// bench_page_editor.cpp
+// Open time, memory and scroll frame time of the large-document editor
+#include "bench_memory.h"
+#include "page_editor.h"
+#include <QScrollBar>
+#include <QTest>
+#include <QTextEdit>
+#include <memory>
+
+// ============ Page Editor Benchmark ============
+// PageEditor switches to its QPlainTextEdit above LargeDocumentThreshold, so
+// every row here is in large mode. The comparison is a QTextEdit set up as
+// the regular editor is, which lays out the whole page.
+class PageEditorBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void open_data();
+    void open();
+    void memory_data();
+    void memory();
+    void scroll_data();
+    void scroll();
+
+private:
+    static void addRows();
+    static QString page(int megabytes);
+    static std::unique_ptr<QWidget> createEditor(bool large);
+    static void setText(QWidget *editor, const QString &text);
+    static QAbstractScrollArea *scroller(QWidget *editor);
+};
+
+void PageEditorBenchmark::addRows()
+{
+    QTest::addColumn<bool>("large");
+    QTest::addColumn<int>("megabytes");
+    for (int megabytes : {1, 10, 50})
+    {
+        QTest::addRow("QTextEdit, %d MB", megabytes) << false << megabytes;
+        QTest::addRow("large mode, %d MB", megabytes) << true << megabytes;
+    }
+}
+
+QString PageEditorBenchmark::page(int megabytes)
+{
+    // Paragraphs of a few hundred characters, like prose
+    const QString paragraph = QStringLiteral(
+        "The quick brown fox jumps over the lazy dog while the notebook keeps "
+        "every word of it. Pages grow one paragraph at a time, and some of them "
+        "grow for years, long after anyone meant them to be this long. ");
+    const qsizetype size = qsizetype(megabytes) * 1024 * 1024;
+
+    QString text;
+    text.reserve(size + paragraph.size() * 2);
+    while (text.size() < size)
+    {
+        text += paragraph;
+        text += paragraph;
+        text += QLatin1Char('\n');
+    }
+    text.truncate(size);
+    return text;
+}
+
+std::unique_ptr<QWidget> PageEditorBenchmark::createEditor(bool large)
+{
+    if (large)
+        return std::make_unique<PageEditor>();
+
+    auto edit = std::make_unique<QTextEdit>();
+    edit->setAcceptRichText(false);
+    edit->setTabStopDistance(40);
+    return edit;
+}
+
+void PageEditorBenchmark::setText(QWidget *editor, const QString &text)
+{
+    if (PageEditor *pageEditor = qobject_cast<PageEditor *>(editor))
+        pageEditor->setPlainText(text);
+    else
+        static_cast<QTextEdit *>(editor)->setPlainText(text);
+}
+
+QAbstractScrollArea *PageEditorBenchmark::scroller(QWidget *editor)
+{
+    if (PageEditor *pageEditor = qobject_cast<PageEditor *>(editor))
+        return qobject_cast<QAbstractScrollArea *>(pageEditor->currentWidget());
+    return static_cast<QTextEdit *>(editor);
+}
+
+void PageEditorBenchmark::open_data()
+{
+    addRows();
+}
+
+void PageEditorBenchmark::open()
+{
+    QFETCH(bool, large);
+    QFETCH(int, megabytes);
+    const QString text = page(megabytes);
+
+    std::unique_ptr<QWidget> editor = createEditor(large);
+    editor->resize(900, 700);
+    editor->show();
+    QVERIFY(QTest::qWaitForWindowExposed(editor.get()));
+
+    // Until the first frame of the page is painted
+    QBENCHMARK_ONCE
+    {
+        setText(editor.get(), text);
+        editor->repaint();
+    }
+
+    if (large)
+        QVERIFY(static_cast<PageEditor *>(editor.get())->isLargeMode());
+}
+
+void PageEditorBenchmark::memory_data()
+{
+    addRows();
+}
+
+void PageEditorBenchmark::memory()
+{
+    QFETCH(bool, large);
+    QFETCH(int, megabytes);
+    const QString text = page(megabytes);
+
+    releaseFreedMemory();
+    const qint64 before = residentBytes();
+    if (before < 0)
+        QSKIP("Resident memory is only read on Linux");
+
+    std::unique_ptr<QWidget> editor = createEditor(large);
+    editor->resize(900, 700);
+    editor->show();
+    QVERIFY(QTest::qWaitForWindowExposed(editor.get()));
+    setText(editor.get(), text);
+
+    // Read through to the end and back, as a reader would
+    QScrollBar *bar = scroller(editor.get())->verticalScrollBar();
+    editor->repaint();
+    bar->setValue(bar->maximum());
+    editor->repaint();
+    bar->setValue(0);
+    editor->repaint();
+
+    QTest::setBenchmarkResult(qreal(residentBytes() - before), QTest::BytesAllocated);
+}
+
+void PageEditorBenchmark::scroll_data()
+{
+    addRows();
+}
+
+void PageEditorBenchmark::scroll()
+{
+    QFETCH(bool, large);
+    QFETCH(int, megabytes);
+
+    std::unique_ptr<QWidget> editor = createEditor(large);
+    editor->resize(900, 700);
+    editor->show();
+    QVERIFY(QTest::qWaitForWindowExposed(editor.get()));
+    setText(editor.get(), page(megabytes));
+
+    // One page down per frame, back to the top at the end
+    QAbstractScrollArea *view = scroller(editor.get());
+    QScrollBar *bar = view->verticalScrollBar();
+    QBENCHMARK
+    {
+        bar->setValue(bar->value() < bar->maximum() ? bar->value() + bar->pageStep() : 0);
+        view->viewport()->repaint();
+    }
+}
+
+QTEST_MAIN(PageEditorBenchmark)
+#include "bench_page_editor.moc"
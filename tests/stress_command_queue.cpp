@@ -0,0 +1,140 @@
+// stress_command_queue.cpp
+// Many producers against one consumer on UiCommandQueue; build with NOTEQUARRY_TSAN
+#include "command_queue.h"
+#include <QTest>
+#include <thread>
+#include <vector>
+
+// ============ UI Command Queue Stress Test ============
+// Every command carries its producer and sequence number, so the consumer
+// can check that nothing is lost or duplicated and that each producer's
+// commands come out in the order they went in.
+class UiCommandQueueStressTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void emptyQueue();
+    void producersAgainstConsumer_data();
+    void producersAgainstConsumer();
+    void dropsUnpoppedCommands();
+};
+
+void UiCommandQueueStressTest::emptyQueue()
+{
+    UiCommandQueue queue;
+    UiCommand command;
+    QVERIFY(!queue.pop(&command));
+
+    queue.push(UiCommand::typed(UiCommand::CurrentPage, QString(), 7));
+    QVERIFY(queue.pop(&command));
+    QCOMPARE(command.type, UiCommand::CurrentPage);
+    QCOMPARE(command.value, 7);
+    QVERIFY(!queue.pop(&command));
+}
+
+void UiCommandQueueStressTest::producersAgainstConsumer_data()
+{
+    QTest::addColumn<int>("producers");
+    QTest::addColumn<int>("perProducer");
+    QTest::newRow("1x200000") << 1 << 200000;
+    QTest::newRow("4x50000") << 4 << 50000;
+    QTest::newRow("16x10000") << 16 << 10000;
+}
+
+void UiCommandQueueStressTest::producersAgainstConsumer()
+{
+    QFETCH(int, producers);
+    QFETCH(int, perProducer);
+
+    // Written only by the calls, which run on the consumer
+    int callProducer = -1;
+    int callSequence = -1;
+
+    UiCommandQueue queue;
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p)
+    {
+        threads.emplace_back([&queue, &callProducer, &callSequence, p, perProducer]()
+                             {
+            for (int i = 0; i < perProducer; ++i)
+            {
+                // Every other command goes through the call path, so its
+                // std::function is handed across threads as well
+                if (i % 2)
+                {
+                    queue.push(UiCommand::function([&callProducer, &callSequence, p, i](MainWindowHandle *)
+                                                   {
+                        callProducer = p;
+                        callSequence = i; }));
+                }
+                else
+                {
+                    queue.push(UiCommand::typed(UiCommand::Content, QString::number(i), p));
+                }
+                if (i % 1024 == 0)
+                    std::this_thread::yield();
+            } });
+    }
+
+    std::vector<int> next(std::size_t(producers), 0);
+    const qint64 total = qint64(producers) * perProducer;
+    qint64 received = 0;
+    UiCommand command;
+    while (received < total)
+    {
+        if (!queue.pop(&command))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        ++received;
+
+        int producer = -1;
+        int sequence = -1;
+        if (command.type == UiCommand::Call)
+        {
+            QVERIFY(bool(command.call));
+            command.call(nullptr);
+            producer = callProducer;
+            sequence = callSequence;
+        }
+        else
+        {
+            QCOMPARE(command.type, UiCommand::Content);
+            bool ok = false;
+            producer = command.value;
+            sequence = command.text.toInt(&ok);
+            QVERIFY(ok);
+        }
+
+        QVERIFY(producer >= 0 && producer < producers);
+        QCOMPARE(sequence, next[std::size_t(producer)]);
+        next[std::size_t(producer)] = sequence + 1;
+    }
+
+    for (std::thread &thread : threads)
+        thread.join();
+
+    QVERIFY(!queue.pop(&command));
+    for (int p = 0; p < producers; ++p)
+        QCOMPARE(next[std::size_t(p)], perProducer);
+}
+
+void UiCommandQueueStressTest::dropsUnpoppedCommands()
+{
+    // The destructor frees whatever the consumer never got to
+    UiCommandQueue queue;
+    std::thread producer([&queue]()
+                         {
+        for (int i = 0; i < 1000; ++i)
+            queue.push(UiCommand::typed(UiCommand::EntryTitle, QString(64, QLatin1Char('x')), i)); });
+    producer.join();
+
+    UiCommand command;
+    QVERIFY(queue.pop(&command));
+    QCOMPARE(command.value, 0);
+}
+
+QTEST_GUILESS_MAIN(UiCommandQueueStressTest)
+#include "stress_command_queue.moc"
@@ -0,0 +1,97 @@
+// stress_event_ring.cpp
+// One producer against one consumer on UiEventRing; build with NOTEQUARRY_TSAN
+#include "event_ring.h"
+#include <QTest>
+#include <string>
+#include <thread>
+
+// ============ UI Event Ring Stress Test ============
+// Records of every length from empty to several hundred bytes go through a
+// small ring many times over, so the head and tail wrap constantly. Each
+// record's fields and text are derived from its sequence number, and the
+// consumer checks every one of them.
+class UiEventRingStressTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void capacity();
+    void producerAgainstConsumer_data();
+    void producerAgainstConsumer();
+
+private:
+    static std::string textFor(int sequence, int maxLength);
+};
+
+std::string UiEventRingStressTest::textFor(int sequence, int maxLength)
+{
+    return std::string(std::size_t(sequence % maxLength), char('a' + sequence % 26));
+}
+
+void UiEventRingStressTest::capacity()
+{
+    UiEventRing small(10);
+    QCOMPARE(small.capacity(), UiEventRing::MinCapacity);
+    QVERIFY(small.isEmpty());
+
+    // Text that could never fit is refused rather than waited for
+    const std::string huge(std::size_t(UiEventRing::MinCapacity), 'x');
+    QVERIFY(!small.push(1, 0, 0, huge.data(), qsizetype(huge.size())));
+
+    UiEventRing rounded(UiEventRing::MinCapacity + 1);
+    QCOMPARE(rounded.capacity(), UiEventRing::MinCapacity * 2);
+}
+
+void UiEventRingStressTest::producerAgainstConsumer_data()
+{
+    QTest::addColumn<int>("capacity");
+    QTest::addColumn<int>("maxLength");
+    QTest::newRow("4K, short text") << 4096 << 97;
+    QTest::newRow("4K, long text") << 4096 << 1021;
+    QTest::newRow("64K, long text") << 65536 << 1021;
+}
+
+void UiEventRingStressTest::producerAgainstConsumer()
+{
+    QFETCH(int, capacity);
+    QFETCH(int, maxLength);
+    const int count = 300000;
+
+    UiEventRing ring(capacity);
+    std::thread producer([&ring, count, maxLength]()
+                         {
+        for (int i = 0; i < count;)
+        {
+            const std::string text = textFor(i, maxLength);
+            if (ring.push(5, i, qint64(i) * 3, text.data(), qsizetype(text.size())))
+                ++i;
+            else
+                std::this_thread::yield();
+        } });
+
+    int received = 0;
+    UiEvent event;
+    while (received < count)
+    {
+        if (!ring.pop(&event))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        QCOMPARE(event.type, 5);
+        QCOMPARE(event.value, received);
+        QCOMPARE(event.id, qint64(received) * 3);
+        const std::string expected = textFor(received, maxLength);
+        QCOMPARE(event.text_length, qint64(expected.size()));
+        QVERIFY(std::string(event.text, std::size_t(event.text_length)) == expected);
+        ++received;
+    }
+
+    producer.join();
+    QVERIFY(ring.isEmpty());
+    QVERIFY(!ring.pop(&event));
+}
+
+QTEST_GUILESS_MAIN(UiEventRingStressTest)
+#include "stress_event_ring.moc"